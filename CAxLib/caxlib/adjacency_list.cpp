@@ -0,0 +1,189 @@
+#include "adjacency_list.h"
+
+#include <algorithm>
+
+namespace caxlib
+{
+
+CAX_INLINE
+void AdjacencyList::clear()
+{
+    reset(0);
+}
+
+CAX_INLINE
+void AdjacencyList::reset(const int n_rows)
+{
+    this->n_rows = n_rows;
+    offsets.assign(n_rows+1, 0);
+    data.clear();
+    std::vector<int>().swap(patch_id);
+    std::vector< std::vector<int> >().swap(patches);
+}
+
+CAX_INLINE
+void AdjacencyList::alloc()
+{
+    // turn the row sizes stored in offsets[i+1] into the position of the
+    // first entry of row i. insert() will then advance offsets[i+1] up to
+    // the end of row i, which is also the beginning of row i+1
+    //
+    int sum = 0;
+    for(int i=0; i<n_rows; ++i)
+    {
+        int tmp = offsets[i+1];
+        offsets[i+1] = sum;
+        sum += tmp;
+    }
+    std::vector<int>(sum).swap(data);
+}
+
+CAX_INLINE
+size_t AdjacencyList::num_entries() const
+{
+    if (patch_id.empty()) return data.size();
+
+    size_t n = 0;
+    for(int i=0; i<n_rows; ++i) n += row(i).size();
+    return n;
+}
+
+CAX_INLINE
+std::vector<int> & AdjacencyList::patch(const int row)
+{
+    assert(row >= 0 && row < n_rows);
+
+    if (patch_id.empty()) patch_id.resize(n_rows, -1);
+
+    if (patch_id[row] < 0)
+    {
+        patch_id[row] = patches.size();
+        patches.push_back(std::vector<int>(data.begin() + offsets[row], data.begin() + offsets[row+1]));
+    }
+    return patches[patch_id[row]];
+}
+
+CAX_INLINE
+void AdjacencyList::add_row()
+{
+    if (patch_id.empty()) patch_id.resize(n_rows, -1);
+
+    patch_id.push_back(patches.size());
+    patches.push_back(std::vector<int>());
+    ++n_rows;
+}
+
+CAX_INLINE
+void AdjacencyList::pop_row()
+{
+    assert(n_rows > 0);
+
+    int last = n_rows - 1;
+
+    if (!patch_id.empty())
+    {
+        if (patch_id[last] >= 0) std::vector<int>().swap(patches[patch_id[last]]);
+        patch_id.pop_back();
+    }
+
+    if (last < (int)offsets.size() - 1)
+    {
+        offsets.pop_back();
+        data.resize(offsets.back());
+    }
+
+    --n_rows;
+}
+
+CAX_INLINE
+void AdjacencyList::push_back(const int row, const int val)
+{
+    patch(row).push_back(val);
+}
+
+CAX_INLINE
+void AdjacencyList::remove(const int row, const int val)
+{
+    std::vector<int> & p = patch(row);
+    std::vector<int>::iterator it = std::find(p.begin(), p.end(), val);
+    if (it != p.end()) p.erase(it);
+}
+
+CAX_INLINE
+void AdjacencyList::replace(const int row, const int old_val, const int new_val)
+{
+    std::vector<int> & p = patch(row);
+    std::vector<int>::iterator it = std::find(p.begin(), p.end(), old_val);
+    if (it != p.end()) *it = new_val;
+}
+
+CAX_INLINE
+void AdjacencyList::set_row(const int row, const std::vector<int> & vals)
+{
+    patch(row) = vals;
+}
+
+CAX_INLINE
+void AdjacencyList::compact()
+{
+    if (patch_id.empty()) return;
+
+    std::vector<int> new_offsets(n_rows+1, 0);
+    std::vector<int> new_data;
+    new_data.reserve(num_entries());
+
+    for(int i=0; i<n_rows; ++i)
+    {
+        AdjacencyView r = row(i);
+        new_data.insert(new_data.end(), r.begin(), r.end());
+        new_offsets[i+1] = new_data.size();
+    }
+
+    offsets.swap(new_offsets);
+    data.swap(new_data);
+    std::vector<int>().swap(patch_id);
+    std::vector< std::vector<int> >().swap(patches);
+}
+
+CAX_INLINE
+void AdjacencyList::append(const AdjacencyList & l, const int shift)
+{
+    compact();
+
+    offsets.reserve(offsets.size() + l.num_rows());
+    data.reserve(data.size() + l.num_entries());
+
+    for(int i=0; i<l.num_rows(); ++i)
+    {
+        for(int val : l.row(i)) data.push_back(val + shift);
+        offsets.push_back(data.size());
+    }
+    n_rows += l.num_rows();
+}
+
+CAX_INLINE
+bool AdjacencyList::operator==(const AdjacencyList & l) const
+{
+    if (n_rows != l.n_rows) return false;
+
+    for(int i=0; i<n_rows; ++i)
+    {
+        AdjacencyView r0 = row(i);
+        AdjacencyView r1 = l.row(i);
+        if (r0.size() != r1.size() || !std::equal(r0.begin(), r0.end(), r1.begin())) return false;
+    }
+    return true;
+}
+
+CAX_INLINE
+size_t AdjacencyList::memory_footprint() const
+{
+    size_t bytes = (offsets.capacity() + data.capacity() + patch_id.capacity()) * sizeof(int) +
+                    patches.capacity() * sizeof(std::vector<int>);
+
+    for(const std::vector<int> & p : patches) bytes += p.capacity() * sizeof(int);
+
+    return bytes;
+}
+
+}
@@ -0,0 +1,145 @@
+#ifndef ADJACENCY_LIST_H
+#define ADJACENCY_LIST_H
+
+#include "caxlib.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdexcept>
+#include <vector>
+
+namespace caxlib
+{
+
+// Read only view of a row of an AdjacencyList. It behaves like a const
+// std::vector<int> (range for, size, [], at, front, back, iterators), and
+// converts to it when a copy is needed. Like std::vector references, a view
+// is invalidated by any change to the list it comes from.
+//
+class AdjacencyView
+{
+    public:
+
+        typedef int         value_type;
+        typedef const int * iterator;
+        typedef const int * const_iterator;
+
+        AdjacencyView() : b(NULL), e(NULL) {}
+        AdjacencyView(const int * b, const int * e) : b(b), e(e) {}
+
+        const int * begin() const { return b; }
+        const int * end()   const { return e; }
+
+        size_t size()  const { return e - b;  }
+        bool   empty() const { return e == b; }
+
+        const int & operator[](const size_t i) const { assert(i < size()); return b[i]; }
+        const int & front() const { assert(!empty()); return b[0]; }
+        const int & back()  const { assert(!empty()); return e[-1]; }
+
+        const int & at(const size_t i) const
+        {
+            if (i >= size()) throw std::out_of_range("AdjacencyView::at");
+            return b[i];
+        }
+
+        operator std::vector<int>() const { return std::vector<int>(b, e); }
+
+    private:
+
+        const int * b;
+        const int * e;
+};
+
+// Compressed (CSR) storage of a mesh relation: the ids adjacent to element i
+// are data[offsets[i]] ... data[offsets[i+1]-1]. A whole relation costs two
+// heap blocks instead of one per element.
+//
+// Lists are built in three steps: reset(n_rows), count() every entry of every
+// row, alloc(), then insert() the same entries (in the order they should
+// appear in the row).
+//
+// Meshes that are edited locally can still push_back() into a row or
+// add_row(): edited rows are moved to a side buffer and read from there,
+// while all the others stay in the compressed block. compact() folds them
+// back.
+//
+class AdjacencyList
+{
+    public:
+
+        AdjacencyList() : n_rows(0), offsets(1, 0) {}
+
+        void clear();
+        void reset(const int n_rows);
+
+        void count(const int row, const int n = 1)
+        {
+            assert(row >= 0 && row < n_rows);
+            offsets[row+1] += n;
+        }
+
+        void alloc();
+
+        void insert(const int row, const int val)
+        {
+            assert(row >= 0 && row < n_rows);
+            data[offsets[row+1]++] = val;
+        }
+
+        int    num_rows()    const { return n_rows; }
+        size_t num_entries() const;
+
+        AdjacencyView row(const int i) const
+        {
+            assert(i >= 0 && i < n_rows);
+            if (!patch_id.empty() && patch_id[i] >= 0)
+            {
+                const std::vector<int> & p = patches[patch_id[i]];
+                return AdjacencyView(p.data(), p.data() + p.size());
+            }
+            return AdjacencyView(data.data() + offsets[i], data.data() + offsets[i+1]);
+        }
+
+        AdjacencyView operator[](const int i) const { return row(i); }
+
+        // local edits
+        //
+        void add_row();
+        void pop_row();
+        void push_back(const int row, const int val);
+        void remove(const int row, const int val);
+        void replace(const int row, const int old_val, const int new_val);
+        void set_row(const int row, const std::vector<int> & vals);
+        void compact();
+
+        // append all the rows of l, adding shift to each entry (used to
+        // merge meshes, where the ids of the second mesh are shifted)
+        //
+        void append(const AdjacencyList & l, const int shift);
+
+        bool operator==(const AdjacencyList & l) const;
+        bool operator!=(const AdjacencyList & l) const { return !(*this == l); }
+
+        // heap memory actually reserved by the list, in bytes
+        //
+        size_t memory_footprint() const;
+
+    private:
+
+        int                             n_rows;
+        std::vector<int>                offsets;  // n_rows+1 (only the compressed rows)
+        std::vector<int>                data;
+        std::vector<int>                patch_id; // empty if no row was edited
+        std::vector< std::vector<int> > patches;
+
+        std::vector<int> & patch(const int row);
+};
+
+}
+
+#ifndef  CAX_STATIC_LIB
+#include "adjacency_list.cpp"
+#endif
+
+#endif // ADJACENCY_LIST_H
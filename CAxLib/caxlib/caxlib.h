@@ -7,7 +7,10 @@
 
 namespace caxlib
 {
-    static Logger logger;
+    // one logger per thread, so that threads can log (or be silenced, see
+    // Logger::disable()) without racing on the same stream
+    //
+    static thread_local Logger logger;
 }
 
 #endif // CAX_LIB_H
@@ -0,0 +1,294 @@
+#include "convex_hull.h"
+#include "vec3.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <float.h>
+#include <map>
+#include <unordered_map>
+
+namespace caxlib
+{
+
+namespace
+{
+    typedef struct
+    {
+        int              v[3];    // outward oriented
+        int              nbr[3];  // face across edge (v[i], v[(i+1)%3])
+        vec3d            n;       // unit normal
+        double           d;       // n.dot(p) for any p on the face
+        std::vector<int> outside; // points that see the face
+        bool             alive;
+    }
+    HullFace;
+
+    inline vec3d hull_point(const double * coords, const int i)
+    {
+        return vec3d(coords[3*i+0], coords[3*i+1], coords[3*i+2]);
+    }
+
+    inline double hull_dist(const HullFace & f, const vec3d & p)
+    {
+        return f.n.dot(p) - f.d;
+    }
+
+    inline HullFace hull_face(const double * coords, const int v0, const int v1, const int v2)
+    {
+        HullFace f;
+        f.v[0]  = v0;
+        f.v[1]  = v1;
+        f.v[2]  = v2;
+        f.nbr[0] = f.nbr[1] = f.nbr[2] = -1;
+        vec3d p0 = hull_point(coords, v0);
+        f.n = (hull_point(coords, v1) - p0).cross(hull_point(coords, v2) - p0);
+        f.n.normalize();
+        f.d = f.n.dot(p0);
+        f.alive = true;
+        return f;
+    }
+
+    // add i to the outside set of the first face in [beg,end) it sees. It
+    // returns false if i sees none of them (i.e. it is inside the hull)
+    //
+    inline bool hull_assign(std::vector<HullFace> & faces, const int beg, const int end,
+                            const double * coords, const int i, const double eps)
+    {
+        vec3d p = hull_point(coords, i);
+        for(int fid=beg; fid<end; ++fid)
+        {
+            if (hull_dist(faces[fid], p) > eps)
+            {
+                faces[fid].outside.push_back(i);
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+CAX_INLINE
+void convex_hull(const double       * coords,
+                 const int            n,
+                 std::vector<int>   & hull_vids,
+                 std::vector<u_int> & hull_tris)
+{
+    assert(hull_vids.empty() && hull_tris.empty());
+
+    if (n < 4)
+    {
+        for(int i=0; i<n; ++i) hull_vids.push_back(i);
+        return;
+    }
+
+    // extreme points along x, y and z. The tolerance is relative to the size
+    // of the point set
+    //
+    int ext[6] = { 0, 0, 0, 0, 0, 0 };
+    for(int i=1; i<n; ++i)
+    for(int j=0; j<3; ++j)
+    {
+        if (coords[3*i+j] < coords[3*ext[2*j]  +j]) ext[2*j]   = i;
+        if (coords[3*i+j] > coords[3*ext[2*j+1]+j]) ext[2*j+1] = i;
+    }
+
+    double size = 0.0;
+    for(int j=0; j<3; ++j) size = std::max(size, coords[3*ext[2*j+1]+j] - coords[3*ext[2*j]+j]);
+    double eps = size * 1e-10;
+
+    // initial tetrahedron: the two farthest extreme points, the farthest
+    // point from their line and the farthest point from their plane
+    //
+    int    v0 = ext[0], v1 = ext[1];
+    double max_d = -1.0;
+    for(int i=0; i<6; ++i)
+    for(int j=i+1; j<6; ++j)
+    {
+        double d = (hull_point(coords, ext[i]) - hull_point(coords, ext[j])).length();
+        if (d > max_d) { max_d = d; v0 = ext[i]; v1 = ext[j]; }
+    }
+
+    vec3d p0 = hull_point(coords, v0);
+    vec3d u  = hull_point(coords, v1) - p0; u.normalize();
+
+    int v2 = -1;
+    max_d  = eps;
+    for(int i=0; i<n; ++i)
+    {
+        double d = u.cross(hull_point(coords, i) - p0).length();
+        if (d > max_d) { max_d = d; v2 = i; }
+    }
+
+    int v3 = -1;
+    if (v2 >= 0)
+    {
+        vec3d nrm = u.cross(hull_point(coords, v2) - p0); nrm.normalize();
+        max_d = eps;
+        for(int i=0; i<n; ++i)
+        {
+            double d = std::fabs(nrm.dot(hull_point(coords, i) - p0));
+            if (d > max_d) { max_d = d; v3 = i; }
+        }
+    }
+
+    if (v3 < 0)
+    {
+        // flat (or degenerate) point set
+        //
+        for(int i=0; i<n; ++i) hull_vids.push_back(i);
+        return;
+    }
+
+    std::vector<HullFace> faces;
+    {
+        vec3d c = (hull_point(coords, v0) + hull_point(coords, v1) +
+                   hull_point(coords, v2) + hull_point(coords, v3)) * 0.25;
+
+        int tet[4][3] = { { v0, v1, v2 }, { v0, v3, v1 }, { v1, v3, v2 }, { v2, v3, v0 } };
+        for(int i=0; i<4; ++i)
+        {
+            HullFace f = hull_face(coords, tet[i][0], tet[i][1], tet[i][2]);
+            if (hull_dist(f, c) > 0) f = hull_face(coords, tet[i][0], tet[i][2], tet[i][1]);
+            faces.push_back(f);
+        }
+
+        std::map<ipair,int> edge2face;
+        for(int fid=0; fid<4; ++fid)
+        for(int k=0; k<3; ++k)
+        {
+            edge2face[ipair(faces[fid].v[k], faces[fid].v[(k+1)%3])] = fid;
+        }
+        for(int fid=0; fid<4; ++fid)
+        for(int k=0; k<3; ++k)
+        {
+            faces[fid].nbr[k] = edge2face.at(ipair(faces[fid].v[(k+1)%3], faces[fid].v[k]));
+        }
+    }
+
+    for(int i=0; i<n; ++i)
+    {
+        if (i == v0 || i == v1 || i == v2 || i == v3) continue;
+        hull_assign(faces, 0, 4, coords, i, eps);
+    }
+
+    std::vector<int>  stack;
+    std::vector<bool> visible;
+    for(int fid=0; fid<4; ++fid) stack.push_back(fid);
+
+    while (!stack.empty())
+    {
+        int fid = stack.back();
+        stack.pop_back();
+
+        if (!faces[fid].alive || faces[fid].outside.empty()) continue;
+
+        // eye point: the farthest point that sees fid
+        //
+        int    eye   = -1;
+        double max_d = -1.0;
+        for(int i : faces[fid].outside)
+        {
+            double d = hull_dist(faces[fid], hull_point(coords, i));
+            if (d > max_d) { max_d = d; eye = i; }
+        }
+        vec3d p_eye = hull_point(coords, eye);
+
+        // faces visible from the eye, and the edges bounding them (horizon)
+        //
+        visible.resize(faces.size(), false);
+
+        std::vector<int>   visible_fids(1, fid);
+        std::vector<ipair> horizon; // (face, edge offset), face is visible
+        visible[fid] = true;
+
+        for(size_t i=0; i<visible_fids.size(); ++i)
+        {
+            int f = visible_fids[i];
+            for(int k=0; k<3; ++k)
+            {
+                int g = faces[f].nbr[k];
+                if (visible[g]) continue;
+                if (hull_dist(faces[g], p_eye) > eps)
+                {
+                    visible[g] = true;
+                    visible_fids.push_back(g);
+                }
+                else horizon.push_back(ipair(f,k));
+            }
+        }
+
+        // a new face per horizon edge, connected to the eye
+        //
+        int new_beg = faces.size();
+        std::unordered_map<int,int> face_from; // first vertex => new face
+        for(const ipair & h : horizon)
+        {
+            const HullFace & f = faces[h.first];
+            int a = f.v[h.second];
+            int b = f.v[(h.second+1)%3];
+            int g = f.nbr[h.second];
+
+            HullFace nf = hull_face(coords, a, b, eye);
+            nf.nbr[0] = g;
+            for(int k=0; k<3; ++k) if (faces[g].nbr[k] == h.first) faces[g].nbr[k] = faces.size();
+
+            face_from[a] = faces.size();
+            faces.push_back(nf);
+        }
+        int new_end = faces.size();
+
+        for(int f=new_beg; f<new_end; ++f)
+        {
+            faces[f].nbr[1] = face_from.at(faces[f].v[1]); // across (b,eye)
+        }
+        for(int f=new_beg; f<new_end; ++f)
+        {
+            faces[faces[f].nbr[1]].nbr[2] = f;              // across (eye,a)
+        }
+
+        // points outside of the removed faces may see the new ones
+        //
+        for(int f : visible_fids)
+        {
+            faces[f].alive = false;
+            for(int i : faces[f].outside)
+            {
+                if (i != eye) hull_assign(faces, new_beg, new_end, coords, i, eps);
+            }
+            std::vector<int>().swap(faces[f].outside);
+            visible[f] = false;
+        }
+
+        for(int f=new_beg; f<new_end; ++f) if (!faces[f].outside.empty()) stack.push_back(f);
+    }
+
+    std::vector<bool> on_hull(n, false);
+    for(const HullFace & f : faces)
+    {
+        if (!f.alive) continue;
+        for(int k=0; k<3; ++k)
+        {
+            hull_tris.push_back(f.v[k]);
+            on_hull[f.v[k]] = true;
+        }
+    }
+    for(int i=0; i<n; ++i) if (on_hull[i]) hull_vids.push_back(i);
+}
+
+CAX_INLINE
+void convex_hull(const std::vector<double> & coords,
+                 std::vector<int>          & hull_vids,
+                 std::vector<u_int>        & hull_tris)
+{
+    convex_hull(coords.data(), coords.size() / 3, hull_vids, hull_tris);
+}
+
+CAX_INLINE
+void convex_hull(const std::vector<double> & coords,
+                 std::vector<int>          & hull_vids)
+{
+    std::vector<u_int> hull_tris;
+    convex_hull(coords.data(), coords.size() / 3, hull_vids, hull_tris);
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef CONVEX_HULL_H
+#define CONVEX_HULL_H
+
+#include "caxlib.h"
+
+#include <sys/types.h>
+#include <vector>
+
+namespace caxlib
+{
+
+// Convex hull of a set of points (serialized xyz coordinates), computed with
+// quickhull. hull_vids lists (in ascending order) the ids of the points that
+// are vertices of the hull, hull_tris its outward oriented triangles.
+//
+// Points closer than a tiny tolerance (relative to the size of the point set)
+// to the hull are treated as inside, so a point that sticks out of the hull by
+// less than that may be missing. Degenerate (flat) point sets have no hull:
+// all the points are returned as hull vertices, and no triangles. The
+// extreme points in any direction are therefore always among hull_vids.
+//
+CAX_INLINE
+void convex_hull(const std::vector<double> & coords,
+                 std::vector<int>          & hull_vids,
+                 std::vector<u_int>        & hull_tris);
+
+// same as above, for the N points in COORDS (3*N doubles)
+//
+CAX_INLINE
+void convex_hull(const double       * coords,
+                 const int            n,
+                 std::vector<int>   & hull_vids,
+                 std::vector<u_int> & hull_tris);
+
+CAX_INLINE
+void convex_hull(const std::vector<double> & coords,
+                 std::vector<int>          & hull_vids);
+
+}
+
+#ifndef  CAX_STATIC_LIB
+#include "convex_hull.cpp"
+#endif
+
+#endif // CONVEX_HULL_H
@@ -0,0 +1,332 @@
+#include "parse_number.h"
+
+#include <algorithm>
+#include <locale.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace caxlib
+{
+
+namespace
+{
+    // the 128 bits product of A and B: the high 64 bits are returned, the low
+    // ones go in LO. 128 bits integers are not standard: where the compiler
+    // has no such type nor intrinsic, 32 bits halves are multiplied
+    //
+    inline uint64_t mul_64x64(const uint64_t a, const uint64_t b, uint64_t & lo)
+    {
+#if defined(__SIZEOF_INT128__)
+        unsigned __int128 p = (unsigned __int128)a * b;
+        lo = uint64_t(p);
+        return uint64_t(p >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        uint64_t hi;
+        lo = _umul128(a, b, &hi);
+        return hi;
+#else
+        uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+        uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+        uint64_t ll = a_lo * b_lo;
+        uint64_t lh = a_lo * b_hi;
+        uint64_t hl = a_hi * b_lo;
+        uint64_t hh = a_hi * b_hi;
+        uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+        lo = (mid << 32) | (ll & 0xFFFFFFFF);
+        return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+    }
+
+    // number of leading zero bits of X (X > 0)
+    //
+    inline int clz_64(const uint64_t x)
+    {
+#if defined(__GNUC__)
+        return __builtin_clzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long i;
+        _BitScanReverse64(&i, x);
+        return 63 - int(i);
+#else
+        int n = 0;
+        while ((x << n) >> 63 == 0) ++n;
+        return n;
+#endif
+    }
+
+    // The 128 most significant bits of 5^q, for q in [-342,308], as used by
+    // the Eisel-Lemire algorithm (for q in [-27,-1] they are rounded up). They
+    // are computed once, with 256 bits of precision
+    //
+    typedef struct
+    {
+        uint64_t hi[651];
+        uint64_t lo[651];
+    }
+    Pow5;
+
+    inline Pow5 build_pow5()
+    {
+        Pow5 t;
+
+        uint64_t v[4] = { 0, 0, 0, uint64_t(1) << 63 }; // 5^q, normalized
+        for(int q=0; q<=308; ++q)
+        {
+            t.hi[342+q] = v[3];
+            t.lo[342+q] = v[2];
+
+            uint64_t r[5];
+            uint64_t carry = 0;
+            for(int i=0; i<4; ++i)
+            {
+                uint64_t lo;
+                uint64_t hi = mul_64x64(v[i], 5, lo);
+                r[i]  = lo + carry;
+                carry = hi + (r[i] < lo);
+            }
+            r[4] = carry;
+
+            int s = 64 - clz_64(r[4]);
+            for(int i=0; i<4; ++i) v[i] = (r[i] >> s) | (r[i+1] << (64 - s));
+        }
+
+        uint64_t w[4] = { 0, 0, 0, uint64_t(1) << 63 }; // 5^-n, normalized
+        for(int n=1; n<=342; ++n)
+        {
+            uint64_t x[5] = { w[0] << 3,
+                             (w[1] << 3) | (w[0] >> 61),
+                             (w[2] << 3) | (w[1] >> 61),
+                             (w[3] << 3) | (w[2] >> 61),
+                              w[3] >> 61 };
+            // long division by 5, 32 bits at a time (the remainder is < 5)
+            //
+            uint64_t d[5];
+            uint64_t rem = 0;
+            for(int i=4; i>=0; --i)
+            {
+                uint64_t cur_hi = (rem << 32) | (x[i] >> 32);
+                uint64_t d_hi   = cur_hi / 5;
+                rem             = cur_hi % 5;
+                uint64_t cur_lo = (rem << 32) | (x[i] & 0xFFFFFFFF);
+                uint64_t d_lo   = cur_lo / 5;
+                rem             = cur_lo % 5;
+                d[i] = (d_hi << 32) | d_lo;
+            }
+
+            if (d[4] != 0) for(int i=0; i<4; ++i) w[i] = (d[i] >> 1) | (d[i+1] << 63);
+            else           for(int i=0; i<4; ++i) w[i] = d[i];
+
+            uint64_t hi = w[3];
+            uint64_t lo = w[2];
+            if (n <= 27 && ++lo == 0) ++hi;
+            t.hi[342-n] = hi;
+            t.lo[342-n] = lo;
+        }
+
+        return t;
+    }
+
+    // Eisel-Lemire: the double nearest to w * 10^q (w > 0, at most 19 digits).
+    // It returns false for subnormals and overflows
+    //
+    inline bool eisel_lemire(uint64_t w, const int q, uint64_t & bits)
+    {
+        static const Pow5 pow5 = build_pow5();
+
+        if (q < -342 || q > 308) return false;
+
+        int lz = clz_64(w);
+        w <<= lz;
+
+        uint64_t lo;
+        uint64_t hi = mul_64x64(w, pow5.hi[342+q], lo);
+        if ((hi & 0x1FF) == 0x1FF)
+        {
+            uint64_t lo2;
+            uint64_t hi2 = mul_64x64(w, pow5.lo[342+q], lo2);
+            lo += hi2;
+            if (hi2 > lo) ++hi;
+        }
+
+        int      upperbit = int(hi >> 63);
+        int      shift    = upperbit + 9;
+        uint64_t mantissa = hi >> shift;
+        int      power2   = (((152170 + 65536) * q) >> 16) + 63 + upperbit - lz + 1023;
+
+        if (power2 <= 0) return false;
+
+        // exactly halfway between two doubles: round to even
+        if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi)
+        {
+            mantissa &= ~uint64_t(1);
+        }
+
+        mantissa += (mantissa & 1);
+        mantissa >>= 1;
+        if (mantissa >= (uint64_t(2) << 52))
+        {
+            mantissa = uint64_t(1) << 52;
+            ++power2;
+        }
+        mantissa &= ~(uint64_t(1) << 52);
+
+        if (power2 >= 0x7FF) return false;
+
+        bits = mantissa | (uint64_t(power2) << 52);
+        return true;
+    }
+
+    inline bool is_digit(const char c) { return c >= '0' && c <= '9'; }
+    inline bool is_blank(const char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    // the slow path: strtod() on a null terminated copy of [beg,end), with
+    // the decimal separator of the current locale
+    //
+    inline const char * strtod_copy(const char * beg, const char * end, double & d)
+    {
+        std::string s(beg, end);
+        std::replace(s.begin(), s.end(), '.', *localeconv()->decimal_point);
+        char * s_end;
+        d = strtod(s.c_str(), &s_end);
+        return beg + (s_end - s.c_str());
+    }
+}
+
+CAX_INLINE
+const char * parse_double(const char * p, const char * end, double & d)
+{
+    static const double pow10[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    const char * start = p;
+
+    while (p < end && is_blank(*p)) ++p;
+
+    const char * beg = p;
+
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        neg = (*p == '-');
+        ++p;
+    }
+
+    uint64_t w        = 0;     // significant digits (at most 19)
+    int      n_digits = 0;
+    int      q        = 0;     // decimal exponent
+    bool     any      = false; // at least one digit
+    bool     lossy    = false; // non zero digits beyond the 19th
+
+    for(; p < end && is_digit(*p); ++p)
+    {
+        any = true;
+        if (n_digits < 19)
+        {
+            w = 10 * w + (*p - '0');
+            if (w > 0) ++n_digits;
+        }
+        else
+        {
+            ++q;
+            if (*p != '0') lossy = true;
+        }
+    }
+
+    if (p < end && *p == '.')
+    {
+        for(++p; p < end && is_digit(*p); ++p)
+        {
+            any = true;
+            if (n_digits < 19)
+            {
+                w = 10 * w + (*p - '0');
+                --q;
+                if (w > 0) ++n_digits;
+            }
+            else if (*p != '0') lossy = true;
+        }
+    }
+
+    if (!any)
+    {
+        // nan, inf, or not a number at all
+        const char * e = beg;
+        while (e < end && !is_blank(*e) && *e != '\n') ++e;
+        if (e == beg) return start;
+        e = strtod_copy(beg, e, d);
+        return (e == beg) ? start : e;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char * e = p + 1;
+        bool e_neg = false;
+        if (e < end && (*e == '-' || *e == '+'))
+        {
+            e_neg = (*e == '-');
+            ++e;
+        }
+        if (e < end && is_digit(*e))
+        {
+            int x = 0;
+            for(; e < end && is_digit(*e); ++e) if (x < 100000) x = 10 * x + (*e - '0');
+            q += e_neg ? -x : x;
+            p  = e;
+        }
+    }
+
+    if (lossy) return strtod_copy(beg, p, d);
+
+    if (w == 0)
+    {
+        d = neg ? -0.0 : 0.0;
+        return p;
+    }
+
+    // both w and 10^|q| are exact doubles: a single rounding
+    if (q >= -22 && q <= 22 && w <= (uint64_t(1) << 53))
+    {
+        d = (q < 0) ? double(w) / pow10[-q] : double(w) * pow10[q];
+        if (neg) d = -d;
+        return p;
+    }
+
+    uint64_t bits;
+    if (!eisel_lemire(w, q, bits)) return strtod_copy(beg, p, d);
+
+    if (neg) bits |= uint64_t(1) << 63;
+    memcpy(&d, &bits, sizeof(double));
+    return p;
+}
+
+CAX_INLINE
+const char * parse_int(const char * p, const char * end, int & i)
+{
+    const char * start = p;
+
+    while (p < end && is_blank(*p)) ++p;
+
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        neg = (*p == '-');
+        ++p;
+    }
+
+    if (p == end || !is_digit(*p)) return start;
+
+    long x = 0;
+    for(; p < end && is_digit(*p); ++p) x = 10 * x + (*p - '0');
+
+    i = int(neg ? -x : x);
+    return p;
+}
+
+}
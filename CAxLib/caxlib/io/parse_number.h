@@ -0,0 +1,27 @@
+#ifndef PARSE_NUMBER_H
+#define PARSE_NUMBER_H
+
+#include "../caxlib.h"
+
+namespace caxlib
+{
+
+// Parse a number in [p,end), skipping leading spaces and tabs (not new lines).
+// They return the position right after the number, or p if there is none.
+//
+// parse_double() gives the same (correctly rounded) result as strtod(), but
+// much faster: up to 19 significant digits are converted with the
+// Eisel-Lemire algorithm, and only longer mantissas, subnormals, overflows,
+// NaN and inf go through strtod(). It does not depend on the locale ("." is
+// the decimal separator), nor does it need a null terminated string
+//
+CAX_INLINE const char * parse_double(const char * p, const char * end, double & d);
+CAX_INLINE const char * parse_int   (const char * p, const char * end, int    & i);
+
+}
+
+#ifndef  CAX_STATIC_LIB
+#include "parse_number.cpp"
+#endif
+
+#endif // PARSE_NUMBER_H
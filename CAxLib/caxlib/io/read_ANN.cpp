@@ -6,12 +6,21 @@
 #include "read_ANN.h"
 #include "read_write_ANN.h"
 
+#include "parse_number.h"
+
 #include "tinyxml2.h" // external library TINYXML2
 
 #include <algorithm>
+#include <fcntl.h>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
 using namespace tinyxml2;
@@ -25,7 +34,7 @@ void exitOnEmptyList (std::vector<std::string> & list)
     if(list.size() == 0)
     {
         std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : couldn't read the list of annotated elements " << std::endl;
-        exit(-1);
+        read_error();
     }
 }
 
@@ -35,12 +44,15 @@ void exitOnInvalidElementIndex (int index, u_int threshold )
     if (index < 0 || index >= threshold)
     {
         std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : invalid index of annotated element " << index << "[ 0 - " << threshold << " ]" << std::endl;
-        exit(-1);
+        read_error();
     }
 }
 
+// RANGES expands "first-last" tokens (version 2) into single ids, which are
+// checked against the number of elements N (as ann_list() does)
+//
 CAX_INLINE
-std::vector<std::string> getAnnotatedLocalGeometry (XMLElement * element, const std::string elementType)
+std::vector<std::string> getAnnotatedLocalGeometry (XMLElement * element, const std::string elementType, const bool ranges = false, const u_int n = 0)
 {
     XMLElement *elements = element->FirstChildElement(elementType.c_str());
 
@@ -49,40 +61,66 @@ std::vector<std::string> getAnnotatedLocalGeometry (XMLElement * element, const
     std::vector<std::string> lelements;
 
     while (iss >> token)
-        lelements.push_back(token);
+    {
+        size_t dash = token.find('-', 1);
+        if (ranges && dash != std::string::npos)
+        {
+            const char * beg = token.c_str();
+            char * end_first;
+            char * end_last;
+            long first = strtol(beg,            &end_first, 10);
+            long last  = strtol(beg + dash + 1, &end_last,  10);
+
+            if (end_first != beg + dash || end_last == beg + dash + 1 || *end_last != '\0' || first > last)
+            {
+                std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : couldn't read the list of annotated elements " << std::endl;
+                read_error();
+            }
+            if (first < 0 || last >= (long)n)
+            {
+                std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : invalid index of annotated element " << ((first < 0) ? first : last) << "[ 0 - " << n << " ]" << std::endl;
+                read_error();
+            }
+
+            for (long i = first; i <= last; i++)
+                lelements.push_back(std::to_string(i));
+        }
+        else
+            lelements.push_back(token);
+    }
 
     return lelements;
 }
 
 
+// annotations from a loaded (or parsed) XML document. FILENAME is only used
+// for error messages
+//
 CAX_INLINE
-void read_ANN(const char                       * filename,
+void read_ANN(XMLDocument                      & doc,
+              const char                       * filename,
               GlobalAnnotations                & glob_ann,
               std::vector<VertexAnnotations>   & vertex_ann,
               std::vector<TriangleAnnotations> & triangle_ann)
 {
-    setlocale(LC_NUMERIC, "en_US.UTF-8");
+    XMLElement* root = doc.FirstChildElement();
 
+    if( root == NULL || root->Name() != ROOT_NAME)
     {
-        TIXMLASSERT( true );
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : couldn't read root element " << filename << std::endl;
+        read_error();
     }
 
-    XMLDocument* doc = new XMLDocument();
-    doc->LoadFile( filename );
+    int version = 1;
+    root->QueryIntAttribute(VERSION_NAME.c_str(), &version);
 
-    if (doc->ErrorID() != 0)
+    if (version < 1 || version > ANN_VERSION)
     {
-        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : couldn't load input file " << filename << std::endl;
-        exit(-1);
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : unsupported ANN version " << version << " (this reader knows up to version " << ANN_VERSION << ") " << filename << std::endl;
+        read_error();
     }
 
-    XMLElement* root = doc->FirstChildElement();
-
-    if( root == NULL || root->Name() != ROOT_NAME)
-    {
-        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : couldn't read root element " << filename << std::endl;
-        exit(-1);
-    }
+    const bool ranges = (version >= 2);
 
     XMLElement* annotation = root->FirstChildElement(ANNOTATION_NAME.c_str());
 
@@ -93,7 +131,7 @@ void read_ANN(const char                       * filename,
         if(ANNOTATION_NAME.compare(annotation->Name()) != 0)
         {        
             std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : couldn't read annotation element " << annotation->Name() << std::endl;
-            exit(-1);
+            read_error();
         }
 
         XMLElement *identifier = annotation->FirstChildElement(IDENTIFIER_NAME.c_str());
@@ -101,7 +139,7 @@ void read_ANN(const char                       * filename,
         if(identifier == NULL)
         {
             std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : couldn't read annotation identifier " << annotation->Name() << std::endl;
-            exit(-1);
+            read_error();
         }
 
         const char *id_value = identifier->GetText();
@@ -139,7 +177,7 @@ void read_ANN(const char                       * filename,
                         else
                         {
                             std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : invalid chamber dimensions. " << std::endl;
-                            exit(-1);
+                            read_error();
                         }
                     }
                 }
@@ -197,7 +235,7 @@ void read_ANN(const char                       * filename,
                     if (! (iss >> npz.min[0] >> npz.min[1] >> npz.min[2] >> npz.max[0] >> npz.max[1] >> npz.max[2]))
                     {
                         std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : invalid no-print zone. " << std::endl;
-                        exit(-1);
+                        read_error();
                     }
 
                     glob_ann.printer.no_print_zones.push_back(npz);
@@ -231,7 +269,7 @@ void read_ANN(const char                       * filename,
             if (lmatrix.size() != 9)
             {
                 std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : couldn't read orientation matrix in" << annotation->Name() << std::endl;
-                exit(-1);
+                read_error();
             }
 
             for (u_int i=0; i < lmatrix.size(); i++)
@@ -254,7 +292,7 @@ void read_ANN(const char                       * filename,
         else
         if (BAD_GEOMETRY.compare(id_value) == 0)
         {
-            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES);
+            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES, ranges, triangle_ann.size());
 
             exitOnEmptyList(ltriangles);
 
@@ -272,7 +310,7 @@ void read_ANN(const char                       * filename,
         else
         if (CLOSED_VOIDS.compare(id_value) == 0)
         {
-            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES);
+            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES, ranges, triangle_ann.size());
 
             exitOnEmptyList(ltriangles);
 
@@ -292,7 +330,7 @@ void read_ANN(const char                       * filename,
         else
         if (BAD_MATERIAL.compare(id_value) == 0)
         {
-            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES);
+            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES, ranges, triangle_ann.size());
 
             exitOnEmptyList(ltriangles);
 
@@ -310,7 +348,7 @@ void read_ANN(const char                       * filename,
         else
         if (THIN_WALLS_REL.compare(id_value) == 0)
         {
-            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES);
+            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES, ranges, triangle_ann.size());
 
             exitOnEmptyList(ltriangles);
 
@@ -328,7 +366,7 @@ void read_ANN(const char                       * filename,
         else
         if (THIN_CHANNELS.compare(id_value) == 0)
         {
-            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES);
+            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES, ranges, triangle_ann.size());
 
             exitOnEmptyList(ltriangles);
 
@@ -346,7 +384,7 @@ void read_ANN(const char                       * filename,
         else
         if (OVERHANGS.compare(id_value) == 0)
         {
-            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES);
+            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES, ranges, triangle_ann.size());
 
             exitOnEmptyList(ltriangles);
 
@@ -364,7 +402,7 @@ void read_ANN(const char                       * filename,
         else
         if (WEAK_FEATURES.compare(id_value) == 0)
         {
-            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES);
+            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES, ranges, triangle_ann.size());
 
             exitOnEmptyList(ltriangles);
 
@@ -382,7 +420,7 @@ void read_ANN(const char                       * filename,
         else
         if (MACH_ALLOWANCE.compare(id_value) == 0)
         {
-            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES);
+            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES, ranges, triangle_ann.size());
 
             exitOnEmptyList(ltriangles);
 
@@ -403,8 +441,8 @@ void read_ANN(const char                       * filename,
             //
             caxlib::logger << " Annotation [ " << id_value << " ] found. " << std::endl;
 
-            std::vector<std::string> lvertices = getAnnotatedLocalGeometry(annotation, VERTICES);
-            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES);
+            std::vector<std::string> lvertices = getAnnotatedLocalGeometry(annotation, VERTICES, ranges, vertex_ann.size());
+            std::vector<std::string> ltriangles = getAnnotatedLocalGeometry(annotation, TRIANGLES, ranges, triangle_ann.size());
 
             if (lvertices.size()== 0 && ltriangles.size() == 0)
                 glob_ann.extra_annotations.push_back(id_value);
@@ -440,6 +478,586 @@ void read_ANN(const char                       * filename,
     }
 }
 
+CAX_INLINE
+void read_ANN_DOM(const char                       * filename,
+                  GlobalAnnotations                & glob_ann,
+                  std::vector<VertexAnnotations>   & vertex_ann,
+                  std::vector<TriangleAnnotations> & triangle_ann)
+{
+    setlocale(LC_NUMERIC, "en_US.UTF-8");
+
+    {
+        TIXMLASSERT( true );
+    }
+
+    XMLDocument doc;
+    doc.LoadFile( filename );
+
+    if (doc.ErrorID() != 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN_DOM() : couldn't load input file " << filename << std::endl;
+        read_error();
+    }
+
+    read_ANN(doc, filename, glob_ann, vertex_ann, triangle_ann);
+}
+
+CAX_INLINE
+void parse_ANN_DOM(const char                       * buf,
+                   const size_t                       size,
+                   GlobalAnnotations                & glob_ann,
+                   std::vector<VertexAnnotations>   & vertex_ann,
+                   std::vector<TriangleAnnotations> & triangle_ann)
+{
+    setlocale(LC_NUMERIC, "en_US.UTF-8");
+
+    XMLDocument doc;
+    doc.Parse(buf, size);
+
+    if (doc.ErrorID() != 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_ANN_DOM() : couldn't parse annotations" << std::endl;
+        read_error();
+    }
+
+    read_ANN(doc, "(memory)", glob_ann, vertex_ann, triangle_ann);
+}
+
+//
+// Streaming reader. The XML is scanned in place, one annotation at a time,
+// and element lists go straight from the text to the annotations. It reads
+// the XML that write_ANN() (or any other tinyxml2 writer) produces:
+// elements, attributes, text, comments and declarations. Entities are
+// decoded in strings; CDATA sections are not supported
+//
+
+namespace
+{
+    typedef struct
+    {
+        const char * p;
+        const char * end;
+        const char * attr;      // attributes of the last start tag read
+        const char * attr_end;
+    }
+    AnnStream;
+
+    typedef struct
+    {
+        const char * name;
+        const char * name_end;
+        const char * text;      // first text of the element (empty if none)
+        const char * text_end;
+    }
+    AnnElement;
+
+    inline void ann_error(const char * msg)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_ANN() : " << msg << std::endl;
+        read_error();
+    }
+
+    inline bool ann_space(const char c)
+    {
+        return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+    }
+
+    inline bool ann_is(const char * b, const char * e, const std::string & str)
+    {
+        return ((size_t)(e - b) == str.size() && memcmp(b, str.data(), str.size()) == 0);
+    }
+
+    inline bool ann_starts(const AnnStream & s, const char * str)
+    {
+        size_t n = strlen(str);
+        return ((size_t)(s.end - s.p) >= n && memcmp(s.p, str, n) == 0);
+    }
+
+    inline void ann_skip_past(AnnStream & s, const char * str)
+    {
+        size_t n = strlen(str);
+        while ((size_t)(s.end - s.p) >= n && memcmp(s.p, str, n) != 0) ++s.p;
+        if ((size_t)(s.end - s.p) < n) ann_error("unterminated XML markup");
+        s.p += n;
+    }
+
+    // move to the next tag that is not a comment, a declaration or a
+    // processing instruction. Text is skipped
+    //
+    inline void ann_next_tag(AnnStream & s)
+    {
+        for(;;)
+        {
+            while (s.p < s.end && *s.p != '<') ++s.p;
+            if (s.p == s.end) ann_error("truncated XML");
+
+            if      (ann_starts(s, "<!--")) ann_skip_past(s, "-->");
+            else if (ann_starts(s, "<?"))   ann_skip_past(s, "?>");
+            else if (ann_starts(s, "<!"))   ann_skip_past(s, ">");
+            else return;
+        }
+    }
+
+    // read the start tag at s.p. It returns false for an empty element (<a/>)
+    //
+    inline bool ann_start_tag(AnnStream & s, const char *& name, const char *& name_end)
+    {
+        if (s.p >= s.end || *s.p != '<' || s.p + 1 == s.end || s.p[1] == '/') ann_error("malformed XML");
+
+        name = ++s.p;
+        while (s.p < s.end && !ann_space(*s.p) && *s.p != '/' && *s.p != '>') ++s.p;
+        name_end = s.p;
+        if (name == name_end) ann_error("malformed XML");
+
+        // attributes are skipped (their values may contain '>')
+        //
+        s.attr = s.p;
+        while (s.p < s.end && *s.p != '>')
+        {
+            if (*s.p == '"' || *s.p == '\'')
+            {
+                const char q = *s.p++;
+                while (s.p < s.end && *s.p != q) ++s.p;
+                if (s.p == s.end) break;
+            }
+            ++s.p;
+        }
+        if (s.p == s.end) ann_error("truncated XML");
+        s.attr_end = s.p;
+
+        bool has_content = (s.p[-1] != '/');
+        ++s.p;
+        return has_content;
+    }
+
+    // at s.p there is "</": read the end tag of the element NAME
+    //
+    inline void ann_end_tag(AnnStream & s, const char * name, const char * name_end)
+    {
+        s.p += 2;
+        const char * n = s.p;
+        while (s.p < s.end && !ann_space(*s.p) && *s.p != '>') ++s.p;
+        if (!ann_is(n, s.p, std::string(name, name_end))) ann_error("mismatched XML end tag");
+        while (s.p < s.end && *s.p != '>') ++s.p;
+        if (s.p == s.end) ann_error("truncated XML");
+        ++s.p;
+    }
+
+    // text, with entities decoded
+    //
+    inline std::string ann_string(const char * p, const char * end)
+    {
+        std::string str;
+        str.reserve(end - p);
+        while (p < end)
+        {
+            if (*p != '&')
+            {
+                str.push_back(*p++);
+                continue;
+            }
+
+            const char * semi = p;
+            while (semi < end && *semi != ';') ++semi;
+            if (semi == end) ann_error("malformed XML entity");
+
+            std::string ent(p + 1, semi);
+            if      (ent == "lt")   str.push_back('<');
+            else if (ent == "gt")   str.push_back('>');
+            else if (ent == "amp")  str.push_back('&');
+            else if (ent == "quot") str.push_back('"');
+            else if (ent == "apos") str.push_back('\'');
+            else if (ent.size() > 1 && ent[0] == '#')
+            {
+                unsigned long c = (ent[1] == 'x') ? strtoul(ent.c_str() + 2, NULL, 16)
+                                                  : strtoul(ent.c_str() + 1, NULL, 10);
+                // UTF-8
+                if (c < 0x80)         { str.push_back(c); }
+                else if (c < 0x800)   { str.push_back(0xC0 | (c >> 6));
+                                        str.push_back(0x80 | (c & 0x3F)); }
+                else if (c < 0x10000) { str.push_back(0xE0 | (c >> 12));
+                                        str.push_back(0x80 | ((c >> 6) & 0x3F));
+                                        str.push_back(0x80 | (c & 0x3F)); }
+                else                  { str.push_back(0xF0 | (c >> 18));
+                                        str.push_back(0x80 | ((c >> 12) & 0x3F));
+                                        str.push_back(0x80 | ((c >> 6) & 0x3F));
+                                        str.push_back(0x80 | (c & 0x3F)); }
+            }
+            else ann_error("unknown XML entity");
+            p = semi + 1;
+        }
+        return str;
+    }
+
+    // value of the attribute NAME among those of the last start tag (false
+    // if there is no such attribute)
+    //
+    inline bool ann_attribute(const AnnStream & s, const std::string & name, std::string & value)
+    {
+        const char * p = s.attr;
+        for(;;)
+        {
+            while (p < s.attr_end && (ann_space(*p) || *p == '/')) ++p;
+            if (p >= s.attr_end) return false;
+
+            const char * n = p;
+            while (p < s.attr_end && !ann_space(*p) && *p != '=') ++p;
+            const char * n_end = p;
+
+            while (p < s.attr_end && ann_space(*p)) ++p;
+            if (p >= s.attr_end || *p != '=') ann_error("malformed XML attribute");
+            ++p;
+            while (p < s.attr_end && ann_space(*p)) ++p;
+            if (p >= s.attr_end || (*p != '"' && *p != '\'')) ann_error("malformed XML attribute");
+
+            const char q = *p++;
+            const char * v = p;
+            while (p < s.attr_end && *p != q) ++p;
+            if (p >= s.attr_end) ann_error("malformed XML attribute");
+
+            if (ann_is(n, n_end, name))
+            {
+                value = ann_string(v, p);
+                return true;
+            }
+            ++p;
+        }
+    }
+
+    inline void ann_skip_element(AnnStream & s)
+    {
+        const char * name, * name_end;
+        if (!ann_start_tag(s, name, name_end)) return;
+
+        for(;;)
+        {
+            ann_next_tag(s);
+            if (s.p + 1 < s.end && s.p[1] == '/') break;
+            ann_skip_element(s);
+        }
+        ann_end_tag(s, name, name_end);
+    }
+
+    // read an element that only has text (child elements are skipped)
+    //
+    inline void ann_leaf(AnnStream & s, AnnElement & e)
+    {
+        e.text = e.text_end = NULL;
+        if (!ann_start_tag(s, e.name, e.name_end)) return;
+
+        e.text = s.p;
+        while (s.p < s.end && *s.p != '<') ++s.p;
+        e.text_end = s.p;
+
+        for(;;)
+        {
+            ann_next_tag(s);
+            if (s.p + 1 < s.end && s.p[1] == '/') break;
+            ann_skip_element(s);
+        }
+        ann_end_tag(s, e.name, e.name_end);
+    }
+
+    inline const AnnElement * ann_child(const std::vector<AnnElement> & children, const std::string & name)
+    {
+        for(const AnnElement & e : children) if (ann_is(e.name, e.name_end, name)) return &e;
+        return NULL;
+    }
+
+    inline std::string ann_string(const AnnElement & e)
+    {
+        return ann_string(e.text, e.text_end);
+    }
+
+    // the numbers in E, at most N of them. It returns how many were read
+    //
+    inline int ann_doubles(const AnnElement & e, double * d, const int n)
+    {
+        const char * p = e.text;
+        int count = 0;
+        while (count < n)
+        {
+            while (p < e.text_end && ann_space(*p)) ++p;
+            const char * q = parse_double(p, e.text_end, d[count]);
+            if (q == p) break;
+            p = q;
+            ++count;
+        }
+        return count;
+    }
+
+    // as atof()
+    //
+    inline double ann_double(const AnnElement & e)
+    {
+        double d = 0.0;
+        ann_doubles(e, &d, 1);
+        return d;
+    }
+
+    // call FUNC on each element id in E (checking that it is in [0,N)), and
+    // return how many they are. RANGES allows "first-last" (version 2)
+    //
+    template<typename F>
+    inline size_t ann_list(const AnnElement * e, const u_int n, const bool ranges, F func)
+    {
+        if (e == NULL) return 0;
+
+        const char * p     = e->text;
+        const char * end   = e->text_end;
+        size_t       count = 0;
+        for(;;)
+        {
+            while (p < end && ann_space(*p)) ++p;
+            if (p == end) break;
+
+            int first, last;
+            const char * q = parse_int(p, end, first);
+            if (q == p) ann_error("couldn't read the list of annotated elements");
+            p = q;
+
+            last = first;
+            if (ranges && p < end && *p == '-')
+            {
+                q = parse_int(++p, end, last);
+                if (q == p || last < first) ann_error("couldn't read the list of annotated elements");
+                p = q;
+            }
+            if (p < end && !ann_space(*p)) ann_error("couldn't read the list of annotated elements");
+
+            exitOnInvalidElementIndex(first, n);
+            exitOnInvalidElementIndex(last,  n);
+            for(int id=first; id<=last; ++id) func(id);
+            count += last - first + 1;
+        }
+        return count;
+    }
+
+    // element lists of the predefined annotations may not be empty
+    //
+    template<typename F>
+    inline void ann_triangles(const std::vector<AnnElement> & children,
+                              const std::string             & id,
+                              const u_int                     n,
+                              const bool                      ranges,
+                              F                               func)
+    {
+        size_t count = ann_list(ann_child(children, TRIANGLES), n, ranges, func);
+        if (count == 0) ann_error("couldn't read the list of annotated elements");
+        caxlib::logger << id << ": Annotated " << count << " " << TRIANGLES << std::endl;
+    }
+
+    inline void ann_printing_parameters(const std::vector<AnnElement> & children, GlobalAnnotations & glob_ann)
+    {
+        for(const AnnElement & e : children)
+        {
+            const char * b = e.name;
+            const char * n = e.name_end;
+
+            if      (ann_is(b, n, MATERIAL))                          glob_ann.material.name                             = ann_string(e);
+            else if (ann_is(b, n, LAYER_THICKNESS))                   glob_ann.printer.layer_thickness                   = ann_double(e);
+            else if (ann_is(b, n, LASER_BEAM_DIAMETER))               glob_ann.printer.laser_beam_diameter               = ann_double(e);
+            else if (ann_is(b, n, CHAMBER_TEMPERATURE))               glob_ann.printer.chamber_temperature               = ann_double(e);
+            else if (ann_is(b, n, THERMAL_SHRINKAGE))                 glob_ann.material.thermal_shrinkage                = ann_double(e);
+            else if (ann_is(b, n, INSTANTANEOUS_ELASTIC_MODULUS))     glob_ann.material.instantaneous_elastic_modulus    = ann_double(e);
+            else if (ann_is(b, n, ELASTIC_MODULUS_AT_INFINITE_TIME))  glob_ann.material.elastic_modulus_at_infinite_time = ann_double(e);
+            else if (ann_is(b, n, POISSON_RATIO))                     glob_ann.material.poisson_ratio                    = ann_double(e);
+            else if (ann_is(b, n, ELASTIC_VISCOSITY))                 glob_ann.material.elastic_viscosity                = ann_double(e);
+            else if (ann_is(b, n, YIELD_STRESS))                      glob_ann.material.yield_stress                     = ann_double(e);
+            else if (ann_is(b, n, SATURATION_STRESS))                 glob_ann.material.saturation_stress                = ann_double(e);
+            else if (ann_is(b, n, PLASTIC_VISCOSITY))                 glob_ann.material.plastic_viscosity                = ann_double(e);
+            else if (ann_is(b, n, ISOTROPIC_HARDENING_LAW))           glob_ann.material.isotropic_hardening_law          = ann_string(e);
+            else if (ann_is(b, n, ISOTROPIC_HARDENING_COEFFICIENT))   glob_ann.material.isotropic_hardening_coefficient  = ann_double(e);
+            else if (ann_is(b, n, THERMAL_EXPANSION_COEFFICIENT))     glob_ann.material.thermal_expansion_coefficient    = ann_double(e);
+            else if (ann_is(b, n, CHAMBER_DIMENSIONS))
+            {
+                if (ann_doubles(e, glob_ann.printer.chamber_dimension, 3) != 3) ann_error("invalid chamber dimensions");
+            }
+            else if (ann_is(b, n, NO_PRINT_ZONE))
+            {
+                double d[6];
+                if (ann_doubles(e, d, 6) != 6) ann_error("invalid no-print zone");
+
+                Bbox npz;
+                for(int i=0; i<3; ++i)
+                {
+                    npz.min[i] = d[i];
+                    npz.max[i] = d[i+3];
+                }
+                glob_ann.printer.no_print_zones.push_back(npz);
+            }
+        }
+    }
+
+    inline void ann_annotation(const std::vector<AnnElement>    & children,
+                               const int                          version,
+                               u_int                            & closed_void_index,
+                               GlobalAnnotations                & glob_ann,
+                               std::vector<VertexAnnotations>   & vertex_ann,
+                               std::vector<TriangleAnnotations> & triangle_ann)
+    {
+        const AnnElement * identifier = ann_child(children, IDENTIFIER_NAME);
+        if (identifier == NULL) ann_error("couldn't read annotation identifier");
+
+        const std::string id     = ann_string(*identifier);
+        const u_int       nt     = triangle_ann.size();
+        const bool        ranges = (version >= 2);
+
+        if (id == PRINTING_PARAMETERS)
+        {
+            ann_printing_parameters(children, glob_ann);
+        }
+        else
+        if (id == ORIENTATION)
+        {
+            caxlib::logger << " Annotation [ " << ORIENTATION << " ] found. " << std::endl;
+
+            const AnnElement * matrix = ann_child(children, MATRIX);
+            double m[10];
+            if (matrix == NULL || ann_doubles(*matrix, m, 10) != 9) ann_error("couldn't read orientation matrix");
+            for(int i=0; i<9; ++i) glob_ann.orientation[i] = m[i];
+        }
+        else
+        if (id == TOO_BIG)
+        {
+            caxlib::logger << " Annotation [ " << TOO_BIG << " ] found. " << std::endl;
+            glob_ann.too_big = true;
+        }
+        else
+        if (id == TOO_HEAVY)
+        {
+            caxlib::logger << " Annotation [ " << TOO_HEAVY << " ] found. " << std::endl;
+            glob_ann.too_heavy = true;
+        }
+        else if (id == BAD_GEOMETRY)   ann_triangles(children, id, nt, ranges, [&](int tid) { triangle_ann[tid].bad_geometry   = true; });
+        else if (id == BAD_MATERIAL)   ann_triangles(children, id, nt, ranges, [&](int tid) { triangle_ann[tid].bad_material   = true; });
+        else if (id == THIN_WALLS_REL) ann_triangles(children, id, nt, ranges, [&](int tid) { triangle_ann[tid].thin_walls     = true; });
+        else if (id == THIN_CHANNELS)  ann_triangles(children, id, nt, ranges, [&](int tid) { triangle_ann[tid].thin_channels  = true; });
+        else if (id == OVERHANGS)      ann_triangles(children, id, nt, ranges, [&](int tid) { triangle_ann[tid].overhangs      = true; });
+        else if (id == WEAK_FEATURES)  ann_triangles(children, id, nt, ranges, [&](int tid) { triangle_ann[tid].weak_feature   = true; });
+        else if (id == MACH_ALLOWANCE) ann_triangles(children, id, nt, ranges, [&](int tid) { triangle_ann[tid].mach_allowance = true; });
+        else if (id == CLOSED_VOIDS)
+        {
+            const u_int cid = closed_void_index++;
+            ann_triangles(children, id, nt, ranges, [&](int tid) { triangle_ann[tid].closed_voids = cid; });
+        }
+        else
+        {
+            // Generic Annotation
+            //
+            caxlib::logger << " Annotation [ " << id << " ] found. " << std::endl;
+
+            size_t n_verts = ann_list(ann_child(children, VERTICES),  vertex_ann.size(), ranges, [&](int vid) { vertex_ann[vid].extra_annotations.insert(id);   });
+            size_t n_tris  = ann_list(ann_child(children, TRIANGLES), nt,                ranges, [&](int tid) { triangle_ann[tid].extra_annotations.insert(id); });
+
+            if (n_verts == 0 && n_tris == 0) glob_ann.extra_annotations.push_back(id);
+            if (n_verts > 0) caxlib::logger << id << ": Annotated " << n_verts << " " << VERTICES  << std::endl;
+            if (n_tris  > 0) caxlib::logger << id << ": Annotated " << n_tris  << " " << TRIANGLES << std::endl;
+        }
+    }
+}
+
+CAX_INLINE
+void read_ANN(const char                       * filename,
+              GlobalAnnotations                & glob_ann,
+              std::vector<VertexAnnotations>   & vertex_ann,
+              std::vector<TriangleAnnotations> & triangle_ann)
+{
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : couldn't load input file " << filename << std::endl;
+        read_error();
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    size_t size = st.st_size;
+
+    void * data = (size > 0) ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+
+    if (data == MAP_FAILED || data == NULL)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ANN() : couldn't load input file " << filename << std::endl;
+        read_error();
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    // unmapped also if parsing fails (see read_error())
+    //
+    std::shared_ptr<void> unmap(data, [size](void * p) { munmap(p, size); });
+
+    parse_ANN((const char*)data, size, glob_ann, vertex_ann, triangle_ann);
 }
 
+CAX_INLINE
+void parse_ANN(const char                       * buf,
+               const size_t                       size,
+               GlobalAnnotations                & glob_ann,
+               std::vector<VertexAnnotations>   & vertex_ann,
+               std::vector<TriangleAnnotations> & triangle_ann)
+{
+    AnnStream s = { buf, buf + size, NULL, NULL };
 
+    const char * root, * root_end;
+    ann_next_tag(s);
+    bool has_content = ann_start_tag(s, root, root_end);
+    if (!ann_is(root, root_end, ROOT_NAME)) ann_error("couldn't read root element");
+
+    int version = 1;
+    std::string attr;
+    if (ann_attribute(s, VERSION_NAME, attr)) version = atoi(attr.c_str());
+    if (version < 1 || version > ANN_VERSION)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_ANN() : unsupported ANN version " << attr << " (this reader knows up to version " << ANN_VERSION << ")" << std::endl;
+        read_error();
+    }
+
+    if (!has_content) return;
+
+    u_int closed_void_index = 1;
+    bool  first = true;
+
+    std::vector<AnnElement> children;
+
+    for(;;)
+    {
+        ann_next_tag(s);
+        if (s.p + 1 < s.end && s.p[1] == '/') break;
+
+        const char * name, * name_end;
+        AnnStream    tag = s;
+        ann_start_tag(tag, name, name_end);
+
+        // as the DOM reader, elements before the first annotation are ignored
+        //
+        if (!ann_is(name, name_end, ANNOTATION_NAME))
+        {
+            if (!first) ann_error("couldn't read annotation element");
+            ann_skip_element(s);
+            continue;
+        }
+        first = false;
+
+        children.clear();
+        if (ann_start_tag(s, name, name_end))
+        {
+            for(;;)
+            {
+                ann_next_tag(s);
+                if (s.p + 1 < s.end && s.p[1] == '/') break;
+                AnnElement e;
+                ann_leaf(s, e);
+                children.push_back(e);
+            }
+            ann_end_tag(s, name, name_end);
+        }
+
+        ann_annotation(children, version, closed_void_index, glob_ann, vertex_ann, triangle_ann);
+    }
+    ann_end_tag(s, root, root_end);
+}
+
+}
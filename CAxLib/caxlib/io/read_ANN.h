@@ -2,6 +2,7 @@
 #define READ_ANN_H
 
 #include "../caxlib.h"
+#include "read_error.h"
 
 #include "../trimesh/annotations.h"
 
@@ -11,11 +12,40 @@
 namespace caxlib
 {
 
+// The XML is scanned in place (the file is memory mapped), and the lists of
+// annotated elements are parsed straight into the annotations, without
+// building a DOM
+//
 CAX_INLINE
 void read_ANN(const char          * filename,
               GlobalAnnotations & glob_ann,
               std::vector<VertexAnnotations> & vertex_ann,
               std::vector<TriangleAnnotations> & triangle_ann);
+
+// same as read_ANN(), from the content (SIZE bytes) of an ANN file
+//
+CAX_INLINE
+void parse_ANN(const char          * buf,
+               const size_t          size,
+               GlobalAnnotations & glob_ann,
+               std::vector<VertexAnnotations> & vertex_ann,
+               std::vector<TriangleAnnotations> & triangle_ann);
+
+// same as read_ANN() and parse_ANN(), through a TINYXML2 DOM (slower, and
+// memory hungry on big lists, but it reads any well formed XML)
+//
+CAX_INLINE
+void read_ANN_DOM(const char          * filename,
+                  GlobalAnnotations & glob_ann,
+                  std::vector<VertexAnnotations> & vertex_ann,
+                  std::vector<TriangleAnnotations> & triangle_ann);
+
+CAX_INLINE
+void parse_ANN_DOM(const char          * buf,
+                   const size_t          size,
+                   GlobalAnnotations & glob_ann,
+                   std::vector<VertexAnnotations> & vertex_ann,
+                   std::vector<TriangleAnnotations> & triangle_ann);
 }
 
 
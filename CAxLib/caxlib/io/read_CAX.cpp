@@ -0,0 +1,344 @@
+#include "read_CAX.h"
+#include "read_write_CAX.h"
+
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace caxlib
+{
+
+namespace
+{
+    typedef struct
+    {
+        const char * p;
+        const char * end;
+        bool         ok;
+    }
+    CaxCursor;
+
+    template<typename T>
+    inline void cax_get(CaxCursor & c, T & val)
+    {
+        if (c.end - c.p < (ptrdiff_t)sizeof(T))
+        {
+            c.ok = false;
+            return;
+        }
+        memcpy(&val, c.p, sizeof(T));
+        c.p += sizeof(T);
+    }
+
+    inline void cax_get(CaxCursor & c, std::string & str)
+    {
+        uint32_t n = 0;
+        cax_get(c, n);
+        if (!c.ok || c.end - c.p < (ptrdiff_t)n)
+        {
+            c.ok = false;
+            return;
+        }
+        str.assign(c.p, n);
+        c.p += n;
+    }
+
+    inline void cax_get(CaxCursor & c, Material & m)
+    {
+        cax_get(c, m.name);
+        cax_get(c, m.isotropic_hardening_law);
+        cax_get(c, m.relative_weight);
+        cax_get(c, m.thermal_expansion_coefficient);
+        cax_get(c, m.thermal_shrinkage);
+        cax_get(c, m.instantaneous_elastic_modulus);
+        cax_get(c, m.elastic_modulus_at_infinite_time);
+        cax_get(c, m.poisson_ratio);
+        cax_get(c, m.elastic_viscosity);
+        cax_get(c, m.yield_stress);
+        cax_get(c, m.saturation_stress);
+        cax_get(c, m.isotropic_hardening_coefficient);
+        cax_get(c, m.plastic_viscosity);
+        cax_get(c, m.critical_temperature);
+    }
+
+    inline void cax_get(CaxCursor & c, Printer & p)
+    {
+        cax_get(c, p.name);
+        cax_get(c, p.layer_thickness_min);
+        cax_get(c, p.layer_thickness_max);
+        cax_get(c, p.layer_thickness);
+        cax_get(c, p.laser_beam_diameter_min);
+        cax_get(c, p.laser_beam_diameter_max);
+        cax_get(c, p.laser_beam_diameter);
+        cax_get(c, p.chamber_temperature_min);
+        cax_get(c, p.chamber_temperature_max);
+        cax_get(c, p.chamber_temperature);
+        for(int i=0; i<3; ++i) cax_get(c, p.chamber_dimension[i]);
+        cax_get(c, p.weight_max);
+
+        uint32_t n = 0;
+        cax_get(c, n);
+        p.no_print_zones.clear();
+        for(uint32_t i=0; i<n && c.ok; ++i)
+        {
+            Bbox bb;
+            for(int j=0; j<3; ++j) cax_get(c, bb.min[j]);
+            for(int j=0; j<3; ++j) cax_get(c, bb.max[j]);
+            p.no_print_zones.push_back(bb);
+        }
+
+        n = 0;
+        cax_get(c, n);
+        p.supported_materials.clear();
+        for(uint32_t i=0; i<n && c.ok; ++i)
+        {
+            Material m;
+            cax_get(c, m);
+            p.supported_materials.push_back(m);
+        }
+    }
+
+    inline void cax_error(const char * msg)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_CAX() : " << msg << endl;
+        read_error();
+    }
+
+    // everything but copying the coordinates and the triangles, which are
+    // returned as pointers to the NV vertices and NT triangles in BUF
+    //
+    inline void cax_parse(const char                       * buf,
+                          const size_t                       size,
+                          const char                      *& xyz,
+                          const char                      *& tri,
+                          size_t                           & nv,
+                          size_t                           & nt,
+                          GlobalAnnotations                & glob_ann,
+                          std::vector<VertexAnnotations>   & vertex_ann,
+                          std::vector<TriangleAnnotations> & triangle_ann)
+    {
+        CaxHeader h;
+        if (size < sizeof(CaxHeader)) cax_error("not a CAX file");
+        memcpy(&h, buf, sizeof(CaxHeader));
+
+        if (memcmp(h.magic, CAX_MAGIC, 8) != 0) cax_error("not a CAX file");
+        if (h.version > CAX_VERSION)            cax_error("unsupported (newer) version");
+        if (size < sizeof(CaxHeader) + h.num_sections * sizeof(CaxSection)) cax_error("truncated file");
+
+        // find the sections (unknown ones are skipped)
+        //
+        const uint32_t N_TYPES = CAX_TRIANGLE_EXTRA + 1;
+        CaxCursor sec[N_TYPES];
+        for(uint32_t t=0; t<N_TYPES; ++t) sec[t] = { NULL, NULL, false };
+
+        for(uint32_t i=0; i<h.num_sections; ++i)
+        {
+            CaxSection s;
+            memcpy(&s, buf + sizeof(CaxHeader) + i * sizeof(CaxSection), sizeof(CaxSection));
+
+            if (s.offset > size || s.size > size - s.offset) cax_error("truncated file");
+            if (s.type < N_TYPES) sec[s.type] = { buf + s.offset, buf + s.offset + s.size, true };
+        }
+
+        nv = h.num_vertices;
+        nt = h.num_triangles;
+
+        if (!sec[CAX_COORDS].ok || (size_t)(sec[CAX_COORDS].end - sec[CAX_COORDS].p) != 24 * nv) cax_error("missing or bad coordinates");
+        if (!sec[CAX_TRIS].ok   || (size_t)(sec[CAX_TRIS].end   - sec[CAX_TRIS].p)   != 12 * nt) cax_error("missing or bad triangles");
+
+        xyz = sec[CAX_COORDS].p;
+        tri = sec[CAX_TRIS].p;
+
+        vertex_ann.clear();
+        triangle_ann.clear();
+        vertex_ann.resize(nv);
+        triangle_ann.resize(nt);
+
+        if (sec[CAX_GLOBAL].ok)
+        {
+            CaxCursor & c = sec[CAX_GLOBAL];
+            uint8_t b[3] = { 0, 0, 0 };
+            for(int i=0; i<9; ++i) cax_get(c, glob_ann.orientation[i]);
+            for(int i=0; i<3; ++i) cax_get(c, b[i]);
+            glob_ann.too_big              = b[0];
+            glob_ann.too_heavy            = b[1];
+            glob_ann.no_legal_orientation = b[2];
+            cax_get(c, glob_ann.printer);
+            cax_get(c, glob_ann.material);
+
+            uint32_t n = 0;
+            cax_get(c, n);
+            glob_ann.extra_annotations.clear();
+            for(uint32_t i=0; i<n && c.ok; ++i)
+            {
+                std::string str;
+                cax_get(c, str);
+                glob_ann.extra_annotations.push_back(str);
+            }
+            if (!c.ok) cax_error("bad global annotations");
+        }
+
+        if (sec[CAX_TRI_FLAGS].ok)
+        {
+            if ((size_t)(sec[CAX_TRI_FLAGS].end - sec[CAX_TRI_FLAGS].p) != nt) cax_error("bad triangle flags");
+
+            const uint8_t * flags = (const uint8_t*)sec[CAX_TRI_FLAGS].p;
+            for(size_t tid=0; tid<nt; ++tid)
+            {
+                TriangleAnnotations & ann = triangle_ann[tid];
+                ann.bad_geometry   = flags[tid] & CAX_FLAG_BAD_GEOMETRY;
+                ann.bad_material   = flags[tid] & CAX_FLAG_BAD_MATERIAL;
+                ann.thin_walls     = flags[tid] & CAX_FLAG_THIN_WALLS;
+                ann.thin_channels  = flags[tid] & CAX_FLAG_THIN_CHANNELS;
+                ann.overhangs      = flags[tid] & CAX_FLAG_OVERHANGS;
+                ann.weak_feature   = flags[tid] & CAX_FLAG_WEAK_FEATURE;
+                ann.mach_allowance = flags[tid] & CAX_FLAG_MACH_ALLOWANCE;
+            }
+        }
+
+        if (sec[CAX_CLOSED_VOIDS].ok)
+        {
+            CaxCursor & c = sec[CAX_CLOSED_VOIDS];
+            if ((size_t)(c.end - c.p) != 4 * nt) cax_error("bad closed voids");
+            for(size_t tid=0; tid<nt; ++tid)
+            {
+                uint32_t id = 0;
+                cax_get(c, id);
+                triangle_ann[tid].closed_voids = id;
+            }
+        }
+
+        std::vector<std::string> strings;
+        if (sec[CAX_STRINGS].ok)
+        {
+            CaxCursor & c = sec[CAX_STRINGS];
+            uint32_t n = 0;
+            cax_get(c, n);
+            for(uint32_t i=0; i<n && c.ok; ++i)
+            {
+                std::string str;
+                cax_get(c, str);
+                strings.push_back(str);
+            }
+            if (!c.ok) cax_error("bad string table");
+        }
+
+        for(uint32_t t : { CAX_VERTEX_EXTRA, CAX_TRIANGLE_EXTRA })
+        {
+            CaxCursor & c = sec[t];
+            size_t n_elems = (t == CAX_VERTEX_EXTRA) ? nv : nt;
+            while (c.ok && c.p < c.end)
+            {
+                uint32_t id = 0, sid = 0;
+                cax_get(c, id);
+                cax_get(c, sid);
+                if (!c.ok || id >= n_elems || sid >= strings.size()) cax_error("bad extra annotations");
+
+                if (t == CAX_VERTEX_EXTRA) vertex_ann[id].extra_annotations.insert(strings[sid]);
+                else                       triangle_ann[id].extra_annotations.insert(strings[sid]);
+            }
+        }
+    }
+
+    // the whole content of FILENAME, memory mapped read only
+    //
+    inline const char * cax_map(const char * filename, const char * func, const int flags, size_t & size)
+    {
+        int fd = open(filename, O_RDONLY);
+
+        if (fd < 0)
+        {
+            std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : " << func << "() : couldn't open input file " << filename << endl;
+            read_error();
+        }
+
+        struct stat st;
+        fstat(fd, &st);
+        size = st.st_size;
+
+        void * data = (size > 0) ? mmap(NULL, size, PROT_READ, flags, fd, 0) : NULL;
+        close(fd);
+
+        if (data == MAP_FAILED || data == NULL)
+        {
+            std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : " << func << "() : couldn't read input file " << filename << endl;
+            read_error();
+        }
+        return (const char*)data;
+    }
+}
+
+CAX_INLINE
+void read_CAX(const char                       * filename,
+              std::vector<double>              & xyz,
+              std::vector<u_int>               & tri,
+              GlobalAnnotations                & glob_ann,
+              std::vector<VertexAnnotations>   & vertex_ann,
+              std::vector<TriangleAnnotations> & triangle_ann)
+{
+    size_t size;
+    const char * data = cax_map(filename, "read_CAX", MAP_PRIVATE, size);
+
+    // unmapped also if parsing fails (see read_error())
+    //
+    std::shared_ptr<const void> unmap(data, [size](const void * p) { munmap((void*)p, size); });
+
+    parse_CAX(data, size, xyz, tri, glob_ann, vertex_ann, triangle_ann);
+}
+
+CAX_INLINE
+void map_CAX(const char                       * filename,
+             MappedVector<double>             & xyz,
+             MappedVector<u_int>              & tri,
+             GlobalAnnotations                & glob_ann,
+             std::vector<VertexAnnotations>   & vertex_ann,
+             std::vector<TriangleAnnotations> & triangle_ann)
+{
+    size_t size;
+    const char * data = cax_map(filename, "map_CAX", MAP_SHARED, size);
+
+    // unmapped when the last array that borrows from it goes away
+    //
+    std::shared_ptr<const void> keep(data, [size](const void * p) { munmap((void*)p, size); });
+
+    const char * xyz_ptr, * tri_ptr;
+    size_t nv, nt;
+    cax_parse(data, size, xyz_ptr, tri_ptr, nv, nt, glob_ann, vertex_ann, triangle_ann);
+
+    // sections are aligned to CAX_ALIGN bytes, and the mapping to a page
+    //
+    if ((uintptr_t)xyz_ptr % sizeof(double) != 0 || (uintptr_t)tri_ptr % sizeof(u_int) != 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : map_CAX() : misaligned sections in " << filename << endl;
+        read_error();
+    }
+
+    xyz.borrow((const double*)xyz_ptr, 3*nv, keep);
+    tri.borrow((const u_int*) tri_ptr, 3*nt, keep);
+}
+
+CAX_INLINE
+void parse_CAX(const char                       * buf,
+               const size_t                       size,
+               std::vector<double>              & xyz,
+               std::vector<u_int>               & tri,
+               GlobalAnnotations                & glob_ann,
+               std::vector<VertexAnnotations>   & vertex_ann,
+               std::vector<TriangleAnnotations> & triangle_ann)
+{
+    const char * xyz_ptr, * tri_ptr;
+    size_t nv, nt;
+    cax_parse(buf, size, xyz_ptr, tri_ptr, nv, nt, glob_ann, vertex_ann, triangle_ann);
+
+    xyz.resize(3*nv);
+    tri.resize(3*nt);
+    if (nv > 0) memcpy(&xyz[0], xyz_ptr, 24 * nv);
+    if (nt > 0) memcpy(&tri[0], tri_ptr, 12 * nt);
+}
+
+}
@@ -0,0 +1,57 @@
+#ifndef READ_CAX_H
+#define READ_CAX_H
+
+#include "../caxlib.h"
+#include "read_error.h"
+
+#include "../mapped_vector.h"
+#include "../trimesh/annotations.h"
+
+#include <sys/types.h>
+#include <vector>
+
+namespace caxlib
+{
+
+// Binary container written by write_CAX(). The file is memory mapped, and
+// the coordinates and triangles are copied as they are
+//
+CAX_INLINE
+void read_CAX(const char                       * filename,
+              std::vector<double>              & xyz,
+              std::vector<u_int>               & tri,
+              GlobalAnnotations                & glob_ann,
+              std::vector<VertexAnnotations>   & vertex_ann,
+              std::vector<TriangleAnnotations> & triangle_ann);
+
+// same as read_CAX(), but the coordinates and the triangles are not copied:
+// XYZ and TRI borrow them from the mapped file, which is mapped shared
+// (its pages are shared with any other process that maps it) and stays
+// mapped until neither XYZ nor TRI (nor their copies) borrow from it
+//
+CAX_INLINE
+void map_CAX(const char                       * filename,
+             MappedVector<double>             & xyz,
+             MappedVector<u_int>              & tri,
+             GlobalAnnotations                & glob_ann,
+             std::vector<VertexAnnotations>   & vertex_ann,
+             std::vector<TriangleAnnotations> & triangle_ann);
+
+// same as read_CAX(), from the first SIZE bytes of the content of a CAX file
+//
+CAX_INLINE
+void parse_CAX(const char                       * buf,
+               const size_t                       size,
+               std::vector<double>              & xyz,
+               std::vector<u_int>               & tri,
+               GlobalAnnotations                & glob_ann,
+               std::vector<VertexAnnotations>   & vertex_ann,
+               std::vector<TriangleAnnotations> & triangle_ann);
+
+}
+
+#ifndef  CAX_STATIC_LIB
+#include "read_CAX.cpp"
+#endif
+
+#endif // READ_CAX
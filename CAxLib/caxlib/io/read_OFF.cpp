@@ -4,53 +4,247 @@
 */
 
 #include "read_OFF.h"
+#include "parse_number.h"
+#include "../parallel.h"
 
+#include <ctype.h>
+#include <fcntl.h>
 #include <iostream>
+#include <memory>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace caxlib
 {
 
+namespace
+{
+    // data lines are parsed in parallel, in chunks of this many lines
+    //
+    const int OFF_CHUNK = 1 << 16;
+
+    inline const char * next_line(const char * p, const char * end)
+    {
+        const char * nl = (const char *)memchr(p, '\n', end - p);
+        return (nl != NULL) ? nl + 1 : end;
+    }
+
+    // first non blank character of the first line at or after p that is
+    // neither empty nor a comment
+    //
+    inline const char * next_data_line(const char * p, const char * end)
+    {
+        while (p < end)
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+            if (p < end && *p != '\n' && *p != '#') return p;
+            p = next_line(p, end);
+        }
+        return end;
+    }
+
+    // skip n data lines from p, recording where each chunk of them begins
+    //
+    inline const char * skip_data_lines(const char * p, const char * end, const int n, std::vector<const char*> & chunks)
+    {
+        for(int i=0; i<n; ++i)
+        {
+            p = next_data_line(p, end);
+            if (p == end) return NULL;
+            if (i % OFF_CHUNK == 0) chunks.push_back(p);
+            p = next_line(p, end);
+        }
+        chunks.push_back(p);
+        return p;
+    }
+}
+
 CAX_INLINE
 void read_OFF(const char          * filename,
               std::vector<double> & xyz,
               std::vector<u_int>  & tri)
 {
-    setlocale(LC_NUMERIC, "en_US.UTF-8"); // makes sure "." is the decimal separator
-
-    FILE *fp = fopen(filename, "r");
+    int fd = open(filename, O_RDONLY);
 
-    if(!fp)
+    if (fd < 0)
     {
         std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_OFF() : couldn't open input file " << filename << endl;
-        exit(-1);
+        read_error();
     }
 
-    int nv, nt, dummy;
+    struct stat st;
+    fstat(fd, &st);
+    size_t size = st.st_size;
 
-    fscanf(fp, "OFF\n");
-    fscanf(fp, "%d %d %d\n", &nv, &nt, &dummy);
+    // the file is mapped in memory and parsed in place
+    //
+    void * data = (size > 0) ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
 
-    for(int i=0; i<nv; ++i)
+    if (data == MAP_FAILED || data == NULL)
     {
-        //http://stackoverflow.com/questions/16839658/printf-width-specifier-to-maintain-precision-of-floating-point-value
-        //
-        double x, y, z;
-        fscanf(fp, "%lf %lf %lf\n", &x, &y, &z);
-        xyz.push_back(x);
-        xyz.push_back(y);
-        xyz.push_back(z);
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_OFF() : couldn't read input file " << filename << endl;
+        read_error();
     }
+    madvise(data, size, MADV_SEQUENTIAL);
 
-    for(int i=0; i<nt; ++i)
+    // unmapped also if parsing fails (see read_error())
+    //
+    std::shared_ptr<void> unmap(data, [size](void * p) { munmap(p, size); });
+
+    parse_OFF((const char*)data, size, xyz, tri);
+}
+
+CAX_INLINE
+void parse_OFF(const char          * buf,
+               const size_t          size,
+               std::vector<double> & xyz,
+               std::vector<u_int>  & tri)
+{
+    const char * p   = buf;
+    const char * end = buf + size;
+
+    // header: an optional keyword (OFF, COFF, NOFF, STOFF...), then the number
+    // of vertices, faces and edges, on the same line or on the next one
+    //
+    p = next_data_line(p, end);
+    if (p < end && isalpha(*p))
     {
-        int v0, v1, v2;
-        fscanf(fp, "%*d %d %d %d\n", &v0, &v1, &v2);
-        tri.push_back(v0);
-        tri.push_back(v1);
-        tri.push_back(v2);
+        while (p < end && isalnum(*p)) ++p;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+        if (p < end && (*p == '\n' || *p == '#')) p = next_data_line(p, end);
     }
 
-    fclose(fp);
+    int nv = -1, nf = -1, ne;
+    p = parse_int(p, end, nv);
+    p = parse_int(p, end, nf);
+    p = parse_int(p, end, ne); // #edges (unused)
+
+    if (nv < 0 || nf < 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_OFF() : couldn't read the header" << endl;
+        read_error();
+    }
+    p = next_line(p, end);
+
+    // find the vertex and face lines (one element per line). Anything after
+    // the coordinates of a vertex (normals, colors...) or after the indices of
+    // a face (colors) is ignored
+    //
+    std::vector<const char*> v_chunks, f_chunks;
+    if ((p = skip_data_lines(p, end, nv, v_chunks)) == NULL)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_OFF() : expected " << nv << " vertices" << endl;
+        read_error();
+    }
+    if ((p = skip_data_lines(p, end, nf, f_chunks)) == NULL)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_OFF() : expected " << nf << " faces" << endl;
+        read_error();
+    }
+
+    int n_v_chunks = v_chunks.size() - 1;
+    int n_f_chunks = f_chunks.size() - 1;
+
+    std::vector<int> bad(std::max(n_v_chunks, n_f_chunks), -1); // first element that couldn't be read, per chunk
+
+    size_t v_off = xyz.size();
+    xyz.resize(v_off + 3*nv);
+
+    parallel_for(0, n_v_chunks, [&](const int c)
+    {
+        const char * q    = v_chunks[c];
+        const char * last = v_chunks[c+1];
+        int          vid  = c * OFF_CHUNK;
+
+        for(double * v = &xyz[v_off + 3*vid]; vid < nv && q < last; ++vid, v += 3)
+        {
+            q = next_data_line(q, last);
+            const char * e = parse_double(q, last, v[0]);
+            if (e != q) e = parse_double(q = e, last, v[1]);
+            if (e != q) e = parse_double(q = e, last, v[2]);
+            if (e == q)
+            {
+                bad[c] = vid;
+                return;
+            }
+            q = next_line(e, last);
+        }
+    });
+
+    for(int c=0; c<n_v_chunks; ++c) if (bad[c] >= 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_OFF() : couldn't read vertex " << bad[c] << endl;
+        read_error();
+    }
+
+    // faces with more than three vertices are split in a triangle fan, so
+    // the triangles of each chunk are counted first
+    //
+    std::vector<size_t> n_tris(n_f_chunks + 1, 0);
+
+    parallel_for(0, n_f_chunks, [&](const int c)
+    {
+        const char * q    = f_chunks[c];
+        const char * last = f_chunks[c+1];
+
+        while ((q = next_data_line(q, last)) < last)
+        {
+            int n = 0;
+            parse_int(q, last, n);
+            if (n > 2) n_tris[c+1] += n - 2;
+            q = next_line(q, last);
+        }
+    });
+
+    for(int c=0; c<n_f_chunks; ++c) n_tris[c+1] += n_tris[c];
+
+    size_t t_off = tri.size();
+    tri.resize(t_off + 3*n_tris[n_f_chunks]);
+
+    parallel_for(0, n_f_chunks, [&](const int c)
+    {
+        const char * q    = f_chunks[c];
+        const char * last = f_chunks[c+1];
+        u_int      * t    = tri.data() + t_off + 3*n_tris[c];
+        int          fid  = c * OFF_CHUNK;
+
+        for(; (q = next_data_line(q, last)) < last; ++fid)
+        {
+            int n, v0 = 0, v1 = 0, v2 = 0;
+            const char * e = parse_int(q, last, n);
+
+            if (e != q && n > 2)
+            {
+                e = parse_int(q = e, last, v0);
+                if (e != q) e = parse_int(q = e, last, v1);
+                for(int i=2; i<n && e != q; ++i)
+                {
+                    e = parse_int(q = e, last, v2);
+                    t[0] = v0;
+                    t[1] = v1;
+                    t[2] = v2;
+                    t += 3;
+                    v1 = v2;
+                }
+            }
+            if (e == q)
+            {
+                bad[c] = fid;
+                return;
+            }
+            q = next_line(e, last);
+        }
+    });
+
+    for(int c=0; c<n_f_chunks; ++c) if (bad[c] >= 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_OFF() : couldn't read face " << bad[c] << endl;
+        read_error();
+    }
 }
 
 }
@@ -2,6 +2,7 @@
 #define READ_OFF_H
 
 #include "../caxlib.h"
+#include "read_error.h"
 
 #include <sys/types.h>
 #include <vector>
@@ -9,11 +10,26 @@
 namespace caxlib
 {
 
+// The file is memory mapped, and large files are parsed in parallel (see
+// parse_OFF())
+//
 CAX_INLINE
 void read_OFF(const char          * filename,
               std::vector<double> & xyz,
               std::vector<u_int>  & tri);
 
+// same as read_OFF(), from the first SIZE bytes of the content of an OFF file.
+// Vertices and faces are one per line (after the coordinates and the indices
+// anything is ignored, e.g. colors), comments (#) and empty lines are skipped.
+// Faces with more than three vertices are split in a triangle fan (which is
+// fine for convex polygons). Chunks of lines are parsed in parallel
+//
+CAX_INLINE
+void parse_OFF(const char          * buf,
+               const size_t          size,
+               std::vector<double> & xyz,
+               std::vector<u_int>  & tri);
+
 }
 
 #ifndef  CAX_STATIC_LIB
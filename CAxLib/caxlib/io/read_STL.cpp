@@ -0,0 +1,205 @@
+#include "read_STL.h"
+#include "parse_number.h"
+#include "../parallel.h"
+#include "../weld.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <iostream>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace caxlib
+{
+
+namespace
+{
+    // binary records, and ASCII bytes, parsed by each parallel job
+    //
+    const int    STL_CHUNK_TRIS  = 1 << 16;
+    const size_t STL_CHUNK_BYTES = 1 << 22;
+
+    inline bool is_binary_STL(const char * buf, const size_t size)
+    {
+        if (size < 84) return false;
+
+        uint32_t n_tris;
+        memcpy(&n_tris, buf + 80, 4);
+        if (84 + 50 * (size_t)n_tris == size) return true;
+
+        // not a consistent binary file: ASCII, if it starts like one
+        //
+        const char * p = buf;
+        while (p < buf + size && isspace(*p)) ++p;
+        return (size_t)(buf + size - p) < 5 || strncmp(p, "solid", 5) != 0;
+    }
+
+    // coordinates of the "vertex x y z" lines in [beg,end)
+    //
+    inline bool parse_STL_vertices(const char * beg, const char * end, std::vector<double> & soup)
+    {
+        for(const char * p = beg; p < end; )
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+
+            if (end - p > 6 && strncmp(p, "vertex", 6) == 0)
+            {
+                double v[3];
+                const char * q = p + 6;
+                for(int j=0; j<3; ++j)
+                {
+                    const char * e = parse_double(q, end, v[j]);
+                    if (e == q) return false;
+                    q = e;
+                }
+                soup.insert(soup.end(), v, v+3);
+                p = q;
+            }
+
+            const char * nl = (const char *)memchr(p, '\n', end - p);
+            p = (nl != NULL) ? nl + 1 : end;
+        }
+        return true;
+    }
+}
+
+CAX_INLINE
+void read_STL(const char          * filename,
+              std::vector<double> & xyz,
+              std::vector<u_int>  & tri,
+              const double          eps)
+{
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_STL() : couldn't open input file " << filename << endl;
+        exit(-1);
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    size_t size = st.st_size;
+
+    // the file is mapped in memory and parsed in place
+    //
+    void * data = (size > 0) ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+
+    if (data == MAP_FAILED || data == NULL)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_STL() : couldn't read input file " << filename << endl;
+        exit(-1);
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    parse_STL((const char*)data, size, xyz, tri, eps);
+
+    munmap(data, size);
+}
+
+CAX_INLINE
+void parse_STL(const char          * buf,
+               const size_t          size,
+               std::vector<double> & xyz,
+               std::vector<u_int>  & tri,
+               const double          eps)
+{
+    std::vector<double> soup; // three corners per triangle
+
+    if (is_binary_STL(buf, size))
+    {
+        uint32_t n_tris = 0;
+        if (size >= 84) memcpy(&n_tris, buf + 80, 4);
+
+        if (size < 84 || size < 84 + 50 * (size_t)n_tris)
+        {
+            std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_STL() : truncated binary STL" << endl;
+            exit(-1);
+        }
+
+        // records: normal (3 floats, ignored), corners (9 floats), attributes (2 bytes)
+        //
+        soup.resize(9 * (size_t)n_tris);
+
+        int n_chunks = (n_tris + STL_CHUNK_TRIS - 1) / STL_CHUNK_TRIS;
+        parallel_for(0, n_chunks, [&](const int c)
+        {
+            size_t beg = (size_t)c * STL_CHUNK_TRIS;
+            size_t end = std::min<size_t>(n_tris, beg + STL_CHUNK_TRIS);
+            for(size_t tid=beg; tid<end; ++tid)
+            {
+                float f[9];
+                memcpy(f, buf + 84 + 50*tid + 12, sizeof(f));
+                std::copy(f, f+9, soup.begin() + 9*tid);
+            }
+        });
+    }
+    else
+    {
+        // chunks of whole lines
+        //
+        std::vector<const char*> bounds(1, buf);
+        while (bounds.back() < buf + size)
+        {
+            const char * p = std::min(buf + size, bounds.back() + STL_CHUNK_BYTES);
+            const char * nl = (const char *)memchr(p, '\n', buf + size - p);
+            bounds.push_back((nl != NULL) ? nl + 1 : buf + size);
+        }
+
+        int n_chunks = bounds.size() - 1;
+        std::vector< std::vector<double> > chunk_soup(n_chunks);
+        std::vector<char>                  chunk_ok(n_chunks);
+
+        parallel_for(0, n_chunks, [&](const int c)
+        {
+            chunk_ok[c] = parse_STL_vertices(bounds[c], bounds[c+1], chunk_soup[c]);
+        });
+
+        size_t n = 0;
+        for(int c=0; c<n_chunks; ++c)
+        {
+            if (!chunk_ok[c])
+            {
+                std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_STL() : couldn't read a vertex" << endl;
+                exit(-1);
+            }
+            n += chunk_soup[c].size();
+        }
+
+        soup.reserve(n);
+        for(int c=0; c<n_chunks; ++c)
+        {
+            soup.insert(soup.end(), chunk_soup[c].begin(), chunk_soup[c].end());
+            std::vector<double>().swap(chunk_soup[c]);
+        }
+
+        if (soup.size() % 9 != 0)
+        {
+            std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : parse_STL() : facets must have three vertices" << endl;
+            exit(-1);
+        }
+    }
+
+    std::vector<double> welded;
+    std::vector<u_int>  map;
+    weld_points(soup, eps, welded, map);
+
+    u_int v_off = xyz.size() / 3;
+    xyz.insert(xyz.end(), welded.begin(), welded.end());
+
+    tri.reserve(tri.size() + map.size());
+    for(size_t i=0; i<map.size(); i+=3)
+    {
+        if (map[i] == map[i+1] || map[i] == map[i+2] || map[i+1] == map[i+2]) continue;
+        tri.push_back(v_off + map[i+0]);
+        tri.push_back(v_off + map[i+1]);
+        tri.push_back(v_off + map[i+2]);
+    }
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef READ_STL_H
+#define READ_STL_H
+
+#include "../caxlib.h"
+
+#include <sys/types.h>
+#include <vector>
+
+namespace caxlib
+{
+
+// Binary or ASCII STL (told apart from the size of the file). STL is a
+// triangle soup: its corners are welded into vertices (see weld_points()),
+// and triangles that collapse in doing so are dropped. EPS = 0 welds the
+// exact duplicates only, which is what STL writers produce
+//
+CAX_INLINE
+void read_STL(const char          * filename,
+              std::vector<double> & xyz,
+              std::vector<u_int>  & tri,
+              const double          eps = 0.0);
+
+// same as read_STL(), from the first SIZE bytes of the content of an STL
+// file. Large files are parsed in parallel
+//
+CAX_INLINE
+void parse_STL(const char          * buf,
+               const size_t          size,
+               std::vector<double> & xyz,
+               std::vector<u_int>  & tri,
+               const double          eps = 0.0);
+
+}
+
+#ifndef  CAX_STATIC_LIB
+#include "read_STL.cpp"
+#endif
+
+#endif // READ_STL
@@ -31,6 +31,7 @@
 #include <zconf.h>
 
 #include <iostream>
+#include <memory>
 
 namespace caxlib
 {
@@ -40,7 +41,6 @@ void unzip(const char *filename, const char *off, const char *ann)
 {
     //Open the ZIP archive
     int err = 0;
-    zip_flags_t flags;
     struct zip_stat sb;
 
     char buf[100];
@@ -57,7 +57,7 @@ void unzip(const char *filename, const char *off, const char *ann)
         exit(-1);
     }
 
-    int nFiles = zip_get_num_entries(zfile, flags);
+    int nFiles = zip_get_num_entries(zfile, 0);
 
     if (nFiles == 0)
     {
@@ -165,6 +165,43 @@ void unzip(const char *filename, const char *off, const char *ann)
     }
 }
 
+// read the whole content of entry I of ZFILE into BUF (null terminated)
+//
+CAX_INLINE
+void read_ZIP_entry(zip * zfile, const zip_uint64_t i, const zip_uint64_t size, std::vector<char> & buf)
+{
+    buf.resize(size + 1);
+
+    zip_file *zf = zip_fopen_index(zfile, i, 0);
+
+    if (!zf)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ZIP() : error reading entry " << i << endl;
+        read_error();
+    }
+
+    zip_uint64_t sum = 0;
+    while (sum < size)
+    {
+        zip_int64_t len = zip_fread(zf, &buf[sum], size - sum);
+
+        if (len <= 0)
+        {
+            std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : read_ZIP() : error reading entry " << i << endl;
+            zip_fclose(zf);
+            read_error();
+        }
+        sum += len;
+    }
+    buf[size] = '\0';
+
+    zip_fclose(zf);
+}
+
+// The OFF and ANN entries are decompressed in memory and parsed from there:
+// nothing is written to disk, so many processes (or threads) can read at the
+// same time from the same working directory
+//
 CAX_INLINE
 void read_ZIP (const char                            * filename,
                std::vector<double>                   & xyz,
@@ -173,21 +210,87 @@ void read_ZIP (const char                            * filename,
                std::vector<VertexAnnotations>   & vertex_ann,
                std::vector<TriangleAnnotations> & triangle_ann )
 {
-    setlocale(LC_NUMERIC, "en_US.UTF-8"); // makes sure "." is the decimal separator
-    const char * off_filename = "tmp.off";
-    const char * ann_filename = "tmp.ann";
+    int err = 0;
+    zip *zfile = zip_open(filename, 0, &err);
+
+    if (zfile == NULL || err != 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ <<
+                     " : read_ZIP() : couldn't open input file " << filename << endl;
+        if (zfile != NULL) zip_discard(zfile);
+        read_error();
+    }
 
-    unzip(filename, off_filename, ann_filename);
+    // closed also if reading fails (see read_error())
+    //
+    std::shared_ptr<zip> close_zip(zfile, [](zip * z) { zip_discard(z); });
 
-    read_OFF(off_filename, xyz, tri);
+    zip_int64_t nFiles = zip_get_num_entries(zfile, 0);
+
+    if (nFiles == 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ <<
+                     " : read_ZIP() : empty " << filename << endl;
+        read_error();
+    }
+
+    if (nFiles > 2)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ <<
+                     " : read_ZIP() : " << filename << " contains more than 2 files" << endl;
+        read_error();
+    }
+
+    std::vector<char> off, ann;
+
+    for (zip_int64_t i = 0; i < nFiles; i++)
+    {
+        struct zip_stat sb;
+
+        if (zip_stat_index(zfile, i, 0, &sb) != 0)
+        {
+            std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ <<
+                         " : read_ZIP() : couldn't stat entry " << i << " of " << filename << endl;
+            read_error();
+        }
+
+        std::string zfilename = sb.name;
+        std::string ext       = (zfilename.find_last_of('.') != std::string::npos) ? zfilename.substr(zfilename.find_last_of('.')) : "";
+
+        caxlib::logger << "extract: " << zfilename << ", size: " << sb.size << endl;
+
+        if (ext.compare(".off") == 0 || ext.compare(".OFF") == 0)
+        {
+            read_ZIP_entry(zfile, i, sb.size, off);
+        }
+        else
+        if (ext.compare(".ann") == 0 || ext.compare(".ANN") == 0)
+        {
+            read_ZIP_entry(zfile, i, sb.size, ann);
+        }
+        else
+        {
+            std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ <<
+                         " : read_ZIP() : unknown format " << zfilename << " [" << ext << "] " << endl;
+            read_error();
+        }
+    }
+
+    close_zip.reset();
+
+    if (off.empty() || ann.empty())
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ <<
+                     " : read_ZIP() : " << filename << " must contain an OFF and an ANN file" << endl;
+        read_error();
+    }
+
+    parse_OFF(&off[0], off.size() - 1, xyz, tri);
 
     vertex_ann.resize(xyz.size() / 3);
     triangle_ann.resize(tri.size() / 3);
 
-    read_ANN(ann_filename, glob_ann, vertex_ann, triangle_ann);
-
-    remove (off_filename);
-    remove (ann_filename);
+    parse_ANN(&ann[0], ann.size() - 1, glob_ann, vertex_ann, triangle_ann);
 }
 
 }
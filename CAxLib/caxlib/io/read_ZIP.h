@@ -2,6 +2,7 @@
 #define READ_ZIP_H
 
 #include "../caxlib.h"
+#include "read_error.h"
 #include "../trimesh/annotations.h"
 
 #include <sys/types.h>
@@ -0,0 +1,20 @@
+#include "read_error.h"
+
+#include <stdlib.h>
+
+namespace caxlib
+{
+
+CAX_INLINE bool & read_errors_throw()
+{
+    static thread_local bool throws = false;
+    return throws;
+}
+
+[[noreturn]] CAX_INLINE void read_error()
+{
+    if (read_errors_throw()) throw ReadError();
+    exit(-1);
+}
+
+}
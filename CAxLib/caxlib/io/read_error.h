@@ -0,0 +1,35 @@
+#ifndef READ_ERROR_H
+#define READ_ERROR_H
+
+#include "../caxlib.h"
+
+#include <stdexcept>
+
+namespace caxlib
+{
+
+// Readers print an error and exit when a file is missing or malformed, as
+// the rest of the library does. A thread that must survive a bad input (e.g.
+// a worker of a batch job) sets read_errors_throw(): read_error() then throws
+// a ReadError instead of exiting, and readers release whatever they hold
+// (mapped files, archives) on the way out
+//
+class ReadError : public std::runtime_error
+{
+    public:
+        ReadError() : std::runtime_error("couldn't read input file") {}
+};
+
+CAX_INLINE bool & read_errors_throw();
+
+// exit, or throw a ReadError (see read_errors_throw())
+//
+[[noreturn]] CAX_INLINE void read_error();
+
+}
+
+#ifndef  CAX_STATIC_LIB
+#include "read_error.cpp"
+#endif
+
+#endif // READ_ERROR_H
@@ -5,6 +5,7 @@
 #include "read_OBJ.h"
 #include "read_OFF.h"
 #include "read_IV.h"
+#include "read_STL.h"
 //
 // VOLUME READERS
 #include "read_MESH.h"
@@ -13,6 +14,7 @@
 // ANNOTATION READERS
 #include "read_ANN.h"
 #include "read_ZIP.h"
+#include "read_CAX.h"
 
 // SURFACE WRITERS
 #include "write_OBJ.h"
@@ -26,5 +28,6 @@
 // ANNOTATION WRITERS
 #include "write_ANN.h"
 #include "write_ZIP.h"
+#include "write_CAX.h"
 
 #endif // READ_WRITE
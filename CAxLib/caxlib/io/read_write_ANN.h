@@ -4,6 +4,7 @@
 // List of element IDs used in the .ANN codification
 //
 const std::string ROOT_NAME         = "Annotations";
+const std::string VERSION_NAME      = "version";       // attribute of the root
 const std::string ANNOTATION_NAME   = "Annotation";
 const std::string IDENTIFIER_NAME   = "Identifier";
 
@@ -52,4 +53,10 @@ const std::string TRIANGLES = "Triangles";          // Machining allowance
 const std::string VERTICES = "Vertices";           // Machining allowance
 const std::string MATRIX = "Matrix";
 
+// Version of the format (the version attribute of the root, 1 if missing).
+// Version 2 lists of annotated elements may contain ranges of consecutive
+// ids ("first-last"). Readers refuse versions newer than theirs
+//
+const int ANN_VERSION = 2;
+
 #endif
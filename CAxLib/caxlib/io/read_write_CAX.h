@@ -0,0 +1,70 @@
+#ifndef READ_WRITE_CAX_H
+#define READ_WRITE_CAX_H
+
+#include <stdint.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the CAX format is little endian, and is read and written as is"
+#endif
+
+// Layout of the binary CAxLib container (.cax):
+//
+//   CaxHeader
+//   CaxSection x num_sections
+//   sections, each one starting at a multiple of CAX_ALIGN
+//
+// Coordinates (double) and triangles (u_int) are stored as the raw arrays of
+// a Trimesh, so they can be memcpy'd, or used in place from a mapped file.
+// Readers skip the sections they do not know; the version changes only when
+// an existing section changes.
+//
+namespace caxlib
+{
+
+const char     CAX_MAGIC[8] = { 'C', 'A', 'X', 'L', 'I', 'B', '\r', '\n' };
+const uint32_t CAX_VERSION  = 1;
+const uint64_t CAX_ALIGN    = 64;
+
+typedef struct
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t num_sections;
+    uint64_t num_vertices;
+    uint64_t num_triangles;
+}
+CaxHeader;
+
+typedef struct
+{
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;   // from the beginning of the file
+    uint64_t size;     // in bytes
+}
+CaxSection;
+
+// section types
+//
+const uint32_t CAX_COORDS         = 1; // double   x 3 x num_vertices
+const uint32_t CAX_TRIS           = 2; // uint32_t x 3 x num_triangles
+const uint32_t CAX_TRI_FLAGS      = 3; // uint8_t  x num_triangles (CAX_FLAG_ bits)
+const uint32_t CAX_CLOSED_VOIDS   = 4; // uint32_t x num_triangles (omitted if all 0)
+const uint32_t CAX_GLOBAL         = 5; // GlobalAnnotations, field by field
+const uint32_t CAX_STRINGS        = 6; // count, then (length, chars) per string
+const uint32_t CAX_VERTEX_EXTRA   = 7; // (vid, string id) pairs, as uint32_t
+const uint32_t CAX_TRIANGLE_EXTRA = 8; // (tid, string id) pairs, as uint32_t
+
+// TriangleAnnotations flags
+//
+const uint8_t CAX_FLAG_BAD_GEOMETRY   = 1 << 0;
+const uint8_t CAX_FLAG_BAD_MATERIAL   = 1 << 1;
+const uint8_t CAX_FLAG_THIN_WALLS     = 1 << 2;
+const uint8_t CAX_FLAG_THIN_CHANNELS  = 1 << 3;
+const uint8_t CAX_FLAG_OVERHANGS      = 1 << 4;
+const uint8_t CAX_FLAG_WEAK_FEATURE   = 1 << 5;
+const uint8_t CAX_FLAG_MACH_ALLOWANCE = 1 << 6;
+
+}
+
+#endif // READ_WRITE_CAX_H
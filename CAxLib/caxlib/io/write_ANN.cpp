@@ -59,24 +59,61 @@ XMLElement * createListOfAnnotatedElements (XMLDocument *doc, const std::string
     return listElement;
 }
 
+// list of element ids. With ANN_LISTS_RANGES, runs of three or more
+// consecutive ids are written as "first-last"
+//
 CAX_INLINE
-void write_ANN(const char                              * filename,
-               const GlobalAnnotations                 & glob_ann,
-               const std::vector<VertexAnnotations>    & vertex_ann,
-               const std::vector<TriangleAnnotations>  & triangle_ann)
+XMLElement * createListOfAnnotatedIds (XMLDocument *doc, const std::string elemType, const std::vector<u_int> & list, const AnnListEncoding encoding)
 {
+    XMLElement * listElement = doc->NewElement(elemType.c_str());
 
-    setlocale(LC_NUMERIC, "en_US.UTF-8");
+    std::string slist;
+    char        buff[32];
 
+    for (size_t i=0; i < list.size(); )
     {
-        TIXMLASSERT( true );
+        size_t j = i + 1;
+        if (encoding == ANN_LISTS_RANGES)
+        {
+            while (j < list.size() && list.at(j) == list.at(j-1) + 1) ++j;
+        }
+
+        if (j - i >= 3)
+        {
+            snprintf(buff, sizeof(buff), "%u-%u ", list.at(i), list.at(j-1));
+            i = j;
+        }
+        else
+        {
+            snprintf(buff, sizeof(buff), "%u ", list.at(i));
+            ++i;
+        }
+        slist += buff;
     }
 
-    XMLDocument * doc = new XMLDocument();
+    listElement->SetText(slist.c_str());
+
+    return listElement;
+}
 
+// fill DOC (empty) with the annotations
+//
+CAX_INLINE
+void write_ANN(XMLDocument                             * doc,
+               const GlobalAnnotations                 & glob_ann,
+               const std::vector<VertexAnnotations>    & vertex_ann,
+               const std::vector<TriangleAnnotations>  & triangle_ann,
+               const AnnListEncoding                     encoding)
+{
     XMLElement * root = doc->NewElement(ROOT_NAME.c_str());
     doc->InsertFirstChild(root);
 
+    // plain id lists are version 1, which is also what readers assume
+    // when the version is missing: files stay readable by older readers
+    //
+    if (encoding == ANN_LISTS_RANGES)
+        root->SetAttribute(VERSION_NAME.c_str(), ANN_VERSION);
+
     XMLElement *ppElement = addAnnotationWithID(doc, PRINTING_PARAMETERS);
 
     // Printing parameters
@@ -323,7 +360,7 @@ void write_ANN(const char                              * filename,
         for (std::multimap<std::string,u_int>::iterator map_it=range.first; map_it != range.second; ++map_it)
             elements.push_back(map_it->second);
 
-        annElement->InsertEndChild(createListOfAnnotatedElements<u_int>(doc, VERTICES, elements));
+        annElement->InsertEndChild(createListOfAnnotatedIds(doc, VERTICES, elements, encoding));
     }
 
     extra_vertex_ann.clear();
@@ -395,7 +432,7 @@ void write_ANN(const char                              * filename,
     if (bad_geometry.size() > 0)
     {
         XMLElement *annElement = addAnnotationWithID(doc, BAD_GEOMETRY);
-        annElement->InsertEndChild(createListOfAnnotatedElements<u_int>(doc, TRIANGLES, bad_geometry));
+        annElement->InsertEndChild(createListOfAnnotatedIds(doc, TRIANGLES, bad_geometry, encoding));
 
         bad_geometry.clear();
     }
@@ -405,7 +442,7 @@ void write_ANN(const char                              * filename,
     for (u_int i=0; i < closed_voids.size(); i++)
     {
         XMLElement *annElement = addAnnotationWithID(doc, CLOSED_VOIDS);
-        annElement->InsertEndChild(createListOfAnnotatedElements<u_int>(doc, TRIANGLES, closed_voids.at(i)));
+        annElement->InsertEndChild(createListOfAnnotatedIds(doc, TRIANGLES, closed_voids.at(i), encoding));
 
         closed_voids.at(i).clear();
     }
@@ -415,7 +452,7 @@ void write_ANN(const char                              * filename,
     if (bad_material.size() > 0)
     {
         XMLElement *annElement = addAnnotationWithID(doc, BAD_MATERIAL);
-        annElement->InsertEndChild(createListOfAnnotatedElements<u_int>(doc, TRIANGLES, bad_material));
+        annElement->InsertEndChild(createListOfAnnotatedIds(doc, TRIANGLES, bad_material, encoding));
 
         bad_material.clear();
     }
@@ -425,7 +462,7 @@ void write_ANN(const char                              * filename,
     if (thin_walls.size() > 0)
     {
         XMLElement *annElement = addAnnotationWithID(doc, THIN_WALLS_REL);
-        annElement->InsertEndChild(createListOfAnnotatedElements<u_int>(doc, TRIANGLES, thin_walls));
+        annElement->InsertEndChild(createListOfAnnotatedIds(doc, TRIANGLES, thin_walls, encoding));
 
         thin_walls.clear();
     }
@@ -435,7 +472,7 @@ void write_ANN(const char                              * filename,
     if (thin_channels.size() > 0)
     {
         XMLElement *annElement = addAnnotationWithID(doc, THIN_CHANNELS);
-        annElement->InsertEndChild(createListOfAnnotatedElements<u_int>(doc, TRIANGLES, thin_channels));
+        annElement->InsertEndChild(createListOfAnnotatedIds(doc, TRIANGLES, thin_channels, encoding));
 
         thin_channels.clear();
     }
@@ -445,7 +482,7 @@ void write_ANN(const char                              * filename,
     if (overhangs.size() > 0)
     {
         XMLElement *annElement = addAnnotationWithID(doc, OVERHANGS);
-        annElement->InsertEndChild(createListOfAnnotatedElements<u_int>(doc, TRIANGLES, overhangs));
+        annElement->InsertEndChild(createListOfAnnotatedIds(doc, TRIANGLES, overhangs, encoding));
 
         overhangs.clear();
     }
@@ -455,7 +492,7 @@ void write_ANN(const char                              * filename,
     if (weak_features.size() > 0)
     {
         XMLElement *annElement = addAnnotationWithID(doc, WEAK_FEATURES);
-        annElement->InsertEndChild(createListOfAnnotatedElements<u_int>(doc, TRIANGLES, weak_features));
+        annElement->InsertEndChild(createListOfAnnotatedIds(doc, TRIANGLES, weak_features, encoding));
 
         weak_features.clear();
     }
@@ -465,7 +502,7 @@ void write_ANN(const char                              * filename,
     if (mach_allowance.size() > 0)
     {
         XMLElement *annElement = addAnnotationWithID(doc, MACH_ALLOWANCE);
-        annElement->InsertEndChild(createListOfAnnotatedElements<u_int>(doc, TRIANGLES, mach_allowance));
+        annElement->InsertEndChild(createListOfAnnotatedIds(doc, TRIANGLES, mach_allowance, encoding));
 
         mach_allowance.clear();
     }
@@ -486,15 +523,50 @@ void write_ANN(const char                              * filename,
         for (std::multimap<std::string,u_int>::iterator map_it=range.first; map_it != range.second; ++map_it)
             elements.push_back(map_it->second);
 
-        annElement->InsertEndChild(createListOfAnnotatedElements<u_int>(doc, TRIANGLES, elements));
+        annElement->InsertEndChild(createListOfAnnotatedIds(doc, TRIANGLES, elements, encoding));
     }
 
     extra_triangle_ann.clear();
     extra_triangle_ann_key.clear();
+}
+
+CAX_INLINE
+void write_ANN(const char                              * filename,
+               const GlobalAnnotations                 & glob_ann,
+               const std::vector<VertexAnnotations>    & vertex_ann,
+               const std::vector<TriangleAnnotations>  & triangle_ann,
+               const AnnListEncoding                     encoding)
+{
+
+    setlocale(LC_NUMERIC, "en_US.UTF-8");
+
+    {
+        TIXMLASSERT( true );
+    }
+
+    XMLDocument doc;
+    write_ANN(&doc, glob_ann, vertex_ann, triangle_ann, encoding);
 
     // Save XML on file
     //
-    doc->SaveFile(filename);
+    doc.SaveFile(filename);
+}
+
+CAX_INLINE
+void serialize_ANN(const GlobalAnnotations                 & glob_ann,
+                   const std::vector<VertexAnnotations>    & vertex_ann,
+                   const std::vector<TriangleAnnotations>  & triangle_ann,
+                   std::string                             & buf,
+                   const AnnListEncoding                     encoding)
+{
+    setlocale(LC_NUMERIC, "en_US.UTF-8");
+
+    XMLDocument doc;
+    write_ANN(&doc, glob_ann, vertex_ann, triangle_ann, encoding);
+
+    XMLPrinter printer;
+    doc.Print(&printer);
+    buf.assign(printer.CStr(), printer.CStrSize() - 1); // CStrSize() counts the terminating null
 }
 
 }
@@ -5,17 +5,41 @@
 
 #include "../trimesh/annotations.h"
 
+#include <string>
 #include <sys/types.h>
 #include <vector>
 
 namespace caxlib
 {
 
+// Lists of annotated elements: one id at a time (readable by any ANN
+// reader), or with runs of consecutive ids written as ranges ("first-last").
+// Ranges shrink lists such as a whole part flagged as bad material to a
+// single token, but need a reader that knows version 2 of the format (see
+// read_write_ANN.h)
+//
+typedef enum
+{
+    ANN_LISTS_IDS,
+    ANN_LISTS_RANGES
+}
+AnnListEncoding;
+
 CAX_INLINE
 void write_ANN(const char                                   * filename,
                const GlobalAnnotations                      & glob_ann,
                const std::vector<VertexAnnotations>    & vertex_ann,
-               const std::vector<TriangleAnnotations>          & triangle_ann);
+               const std::vector<TriangleAnnotations>          & triangle_ann,
+               const AnnListEncoding                          encoding = ANN_LISTS_IDS);
+
+// same as write_ANN(), but the XML goes in BUF
+//
+CAX_INLINE
+void serialize_ANN(const GlobalAnnotations                      & glob_ann,
+                   const std::vector<VertexAnnotations>         & vertex_ann,
+                   const std::vector<TriangleAnnotations>       & triangle_ann,
+                   std::string                                  & buf,
+                   const AnnListEncoding                          encoding = ANN_LISTS_IDS);
 }
 
 #ifndef  CAX_STATIC_LIB
@@ -0,0 +1,290 @@
+#include "write_CAX.h"
+#include "read_write_CAX.h"
+
+#include <iostream>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+
+namespace caxlib
+{
+
+namespace
+{
+    template<typename T>
+    inline void cax_put(std::string & s, const T & val)
+    {
+        s.append((const char*)&val, sizeof(T));
+    }
+
+    inline void cax_put(std::string & s, const std::string & str)
+    {
+        cax_put(s, (uint32_t)str.size());
+        s.append(str);
+    }
+
+    inline void cax_put(std::string & s, const Material & m)
+    {
+        cax_put(s, m.name);
+        cax_put(s, m.isotropic_hardening_law);
+        cax_put(s, m.relative_weight);
+        cax_put(s, m.thermal_expansion_coefficient);
+        cax_put(s, m.thermal_shrinkage);
+        cax_put(s, m.instantaneous_elastic_modulus);
+        cax_put(s, m.elastic_modulus_at_infinite_time);
+        cax_put(s, m.poisson_ratio);
+        cax_put(s, m.elastic_viscosity);
+        cax_put(s, m.yield_stress);
+        cax_put(s, m.saturation_stress);
+        cax_put(s, m.isotropic_hardening_coefficient);
+        cax_put(s, m.plastic_viscosity);
+        cax_put(s, m.critical_temperature);
+    }
+
+    inline void cax_put(std::string & s, const Printer & p)
+    {
+        cax_put(s, p.name);
+        cax_put(s, p.layer_thickness_min);
+        cax_put(s, p.layer_thickness_max);
+        cax_put(s, p.layer_thickness);
+        cax_put(s, p.laser_beam_diameter_min);
+        cax_put(s, p.laser_beam_diameter_max);
+        cax_put(s, p.laser_beam_diameter);
+        cax_put(s, p.chamber_temperature_min);
+        cax_put(s, p.chamber_temperature_max);
+        cax_put(s, p.chamber_temperature);
+        for(int i=0; i<3; ++i) cax_put(s, p.chamber_dimension[i]);
+        cax_put(s, p.weight_max);
+        cax_put(s, (uint32_t)p.no_print_zones.size());
+        for(const Bbox & bb : p.no_print_zones)
+        {
+            for(int i=0; i<3; ++i) cax_put(s, bb.min[i]);
+            for(int i=0; i<3; ++i) cax_put(s, bb.max[i]);
+        }
+        cax_put(s, (uint32_t)p.supported_materials.size());
+        for(const Material & m : p.supported_materials) cax_put(s, m);
+    }
+
+    // (element id, string id) pairs of the extra annotations, with the
+    // strings collected in a table
+    //
+    template<typename Ann>
+    inline void cax_extra(const std::vector<Ann>           & ann,
+                          std::map<std::string,uint32_t>   & ids,
+                          std::string                      & strings,
+                          std::string                      & pairs)
+    {
+        for(size_t i=0; i<ann.size(); ++i)
+        for(const std::string & str : ann[i].extra_annotations)
+        {
+            std::pair<std::map<std::string,uint32_t>::iterator,bool> ins = ids.insert(std::make_pair(str, (uint32_t)ids.size()));
+            if (ins.second) cax_put(strings, str);
+            cax_put(pairs, (uint32_t)i);
+            cax_put(pairs, ins.first->second);
+        }
+    }
+
+    typedef struct
+    {
+        uint32_t     type;
+        const char * data;
+        uint64_t     size;
+    }
+    CaxChunk;
+
+    // header, section table and sections, as a list of chunks (big arrays
+    // are not copied). The small sections are stored in TMP
+    //
+    inline void cax_chunks(const double                           * xyz,
+                           const size_t                             n_xyz,
+                           const u_int                            * tri,
+                           const size_t                             n_tri,
+                           const GlobalAnnotations                & glob_ann,
+                           const std::vector<VertexAnnotations>   & vertex_ann,
+                           const std::vector<TriangleAnnotations> & triangle_ann,
+                           std::vector<std::string>               & tmp,
+                           std::vector<CaxChunk>                  & chunks)
+    {
+        static_assert(sizeof(u_int) == sizeof(uint32_t), "triangles are stored as uint32_t");
+
+        size_t nt = n_tri / 3;
+
+        // global annotations
+        //
+        tmp.resize(6);
+        std::string & global = tmp[0];
+        for(int i=0; i<9; ++i) cax_put(global, glob_ann.orientation[i]);
+        cax_put(global, (uint8_t)glob_ann.too_big);
+        cax_put(global, (uint8_t)glob_ann.too_heavy);
+        cax_put(global, (uint8_t)glob_ann.no_legal_orientation);
+        cax_put(global, glob_ann.printer);
+        cax_put(global, glob_ann.material);
+        cax_put(global, (uint32_t)glob_ann.extra_annotations.size());
+        for(const std::string & str : glob_ann.extra_annotations) cax_put(global, str);
+
+        // triangle flags and closed voids
+        //
+        std::string & flags = tmp[1];
+        std::string & voids = tmp[2];
+        bool has_voids = false;
+        if (triangle_ann.size() == nt)
+        {
+            flags.resize(nt);
+            for(size_t tid=0; tid<nt; ++tid)
+            {
+                const TriangleAnnotations & ann = triangle_ann[tid];
+                flags[tid] = (ann.bad_geometry   ? CAX_FLAG_BAD_GEOMETRY   : 0) |
+                             (ann.bad_material   ? CAX_FLAG_BAD_MATERIAL   : 0) |
+                             (ann.thin_walls     ? CAX_FLAG_THIN_WALLS     : 0) |
+                             (ann.thin_channels  ? CAX_FLAG_THIN_CHANNELS  : 0) |
+                             (ann.overhangs      ? CAX_FLAG_OVERHANGS      : 0) |
+                             (ann.weak_feature   ? CAX_FLAG_WEAK_FEATURE   : 0) |
+                             (ann.mach_allowance ? CAX_FLAG_MACH_ALLOWANCE : 0);
+                if (ann.closed_voids != 0) has_voids = true;
+            }
+            if (has_voids)
+            {
+                voids.reserve(4*nt);
+                for(size_t tid=0; tid<nt; ++tid) cax_put(voids, (uint32_t)triangle_ann[tid].closed_voids);
+            }
+        }
+
+        // extra annotations
+        //
+        std::string & strings = tmp[3];
+        std::string & v_extra = tmp[4];
+        std::string & t_extra = tmp[5];
+        std::map<std::string,uint32_t> ids;
+        std::string table;
+        cax_extra(vertex_ann,   ids, table, v_extra);
+        cax_extra(triangle_ann, ids, table, t_extra);
+        cax_put(strings, (uint32_t)ids.size());
+        strings += table;
+
+        chunks.clear();
+        chunks.push_back({ CAX_COORDS, (const char*)xyz,        8 * n_xyz      });
+        chunks.push_back({ CAX_TRIS,   (const char*)tri,        4 * n_tri      });
+        chunks.push_back({ CAX_GLOBAL, global.data(),           global.size()  });
+
+        if (!flags.empty())   chunks.push_back({ CAX_TRI_FLAGS,      flags.data(),   flags.size()   });
+        if (has_voids)        chunks.push_back({ CAX_CLOSED_VOIDS,   voids.data(),   voids.size()   });
+        if (!ids.empty())     chunks.push_back({ CAX_STRINGS,        strings.data(), strings.size() });
+        if (!v_extra.empty()) chunks.push_back({ CAX_VERTEX_EXTRA,   v_extra.data(), v_extra.size() });
+        if (!t_extra.empty()) chunks.push_back({ CAX_TRIANGLE_EXTRA, t_extra.data(), t_extra.size() });
+    }
+
+    // header and section table (with the sections aligned to CAX_ALIGN)
+    //
+    inline std::string cax_header(const size_t nv, const size_t nt, const std::vector<CaxChunk> & chunks)
+    {
+        CaxHeader h;
+        memcpy(h.magic, CAX_MAGIC, 8);
+        h.version       = CAX_VERSION;
+        h.num_sections  = chunks.size();
+        h.num_vertices  = nv;
+        h.num_triangles = nt;
+
+        std::string s;
+        cax_put(s, h);
+
+        uint64_t offset = sizeof(CaxHeader) + chunks.size() * sizeof(CaxSection);
+        for(const CaxChunk & c : chunks)
+        {
+            offset = (offset + CAX_ALIGN - 1) / CAX_ALIGN * CAX_ALIGN;
+
+            CaxSection sec;
+            sec.type     = c.type;
+            sec.reserved = 0;
+            sec.offset   = offset;
+            sec.size     = c.size;
+            cax_put(s, sec);
+
+            offset += c.size;
+        }
+        return s;
+    }
+}
+
+CAX_INLINE
+void write_CAX(const char                             * filename,
+               const std::vector<double>              & xyz,
+               const std::vector<u_int>               & tri,
+               const GlobalAnnotations                & glob_ann,
+               const std::vector<VertexAnnotations>   & vertex_ann,
+               const std::vector<TriangleAnnotations> & triangle_ann)
+{
+    write_CAX(filename, xyz.data(), xyz.size(), tri.data(), tri.size(), glob_ann, vertex_ann, triangle_ann);
+}
+
+CAX_INLINE
+void write_CAX(const char                             * filename,
+               const double                           * xyz,
+               const size_t                             n_xyz,
+               const u_int                            * tri,
+               const size_t                             n_tri,
+               const GlobalAnnotations                & glob_ann,
+               const std::vector<VertexAnnotations>   & vertex_ann,
+               const std::vector<TriangleAnnotations> & triangle_ann)
+{
+    FILE *fp = fopen(filename, "wb");
+
+    if(!fp)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : write_CAX() : couldn't save file " << filename << endl;
+        exit(-1);
+    }
+
+    std::vector<std::string> tmp;
+    std::vector<CaxChunk>    chunks;
+    cax_chunks(xyz, n_xyz, tri, n_tri, glob_ann, vertex_ann, triangle_ann, tmp, chunks);
+
+    std::string header = cax_header(n_xyz / 3, n_tri / 3, chunks);
+    fwrite(header.data(), 1, header.size(), fp);
+
+    const char pad[CAX_ALIGN] = { 0 };
+    uint64_t offset = header.size();
+    for(const CaxChunk & c : chunks)
+    {
+        uint64_t n_pad = (CAX_ALIGN - offset % CAX_ALIGN) % CAX_ALIGN;
+        fwrite(pad, 1, n_pad, fp);
+        fwrite(c.data, 1, c.size, fp);
+        offset += n_pad + c.size;
+    }
+
+    fclose(fp);
+}
+
+CAX_INLINE
+void serialize_CAX(const std::vector<double>              & xyz,
+                   const std::vector<u_int>               & tri,
+                   const GlobalAnnotations                & glob_ann,
+                   const std::vector<VertexAnnotations>   & vertex_ann,
+                   const std::vector<TriangleAnnotations> & triangle_ann,
+                   std::string                            & buf)
+{
+    serialize_CAX(xyz.data(), xyz.size(), tri.data(), tri.size(), glob_ann, vertex_ann, triangle_ann, buf);
+}
+
+CAX_INLINE
+void serialize_CAX(const double                           * xyz,
+                   const size_t                             n_xyz,
+                   const u_int                            * tri,
+                   const size_t                             n_tri,
+                   const GlobalAnnotations                & glob_ann,
+                   const std::vector<VertexAnnotations>   & vertex_ann,
+                   const std::vector<TriangleAnnotations> & triangle_ann,
+                   std::string                            & buf)
+{
+    std::vector<std::string> tmp;
+    std::vector<CaxChunk>    chunks;
+    cax_chunks(xyz, n_xyz, tri, n_tri, glob_ann, vertex_ann, triangle_ann, tmp, chunks);
+
+    buf = cax_header(n_xyz / 3, n_tri / 3, chunks);
+    for(const CaxChunk & c : chunks)
+    {
+        buf.resize((buf.size() + CAX_ALIGN - 1) / CAX_ALIGN * CAX_ALIGN, '\0');
+        buf.append(c.data, c.size);
+    }
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef WRITE_CAX_H
+#define WRITE_CAX_H
+
+#include "../caxlib.h"
+
+#include "../trimesh/annotations.h"
+
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace caxlib
+{
+
+// Binary container with the mesh and all its annotations (see
+// read_write_CAX.h for the layout). It is much faster to write and to read
+// than ZIP (OFF + ANN), and holds the same content
+//
+CAX_INLINE
+void write_CAX(const char                             * filename,
+               const std::vector<double>              & xyz,
+               const std::vector<u_int>               & tri,
+               const GlobalAnnotations                & glob_ann,
+               const std::vector<VertexAnnotations>   & vertex_ann,
+               const std::vector<TriangleAnnotations> & triangle_ann);
+
+// same as above, for the N_XYZ coordinates at XYZ and the N_TRI indices at
+// TRI (e.g. the borrowed arrays of a memory mapped mesh, that are written
+// without being copied)
+//
+CAX_INLINE
+void write_CAX(const char                             * filename,
+               const double                           * xyz,
+               const size_t                             n_xyz,
+               const u_int                            * tri,
+               const size_t                             n_tri,
+               const GlobalAnnotations                & glob_ann,
+               const std::vector<VertexAnnotations>   & vertex_ann,
+               const std::vector<TriangleAnnotations> & triangle_ann);
+
+// same as write_CAX(), but the content of the file goes in BUF
+//
+CAX_INLINE
+void serialize_CAX(const std::vector<double>              & xyz,
+                   const std::vector<u_int>               & tri,
+                   const GlobalAnnotations                & glob_ann,
+                   const std::vector<VertexAnnotations>   & vertex_ann,
+                   const std::vector<TriangleAnnotations> & triangle_ann,
+                   std::string                            & buf);
+
+CAX_INLINE
+void serialize_CAX(const double                           * xyz,
+                   const size_t                             n_xyz,
+                   const u_int                            * tri,
+                   const size_t                             n_tri,
+                   const GlobalAnnotations                & glob_ann,
+                   const std::vector<VertexAnnotations>   & vertex_ann,
+                   const std::vector<TriangleAnnotations> & triangle_ann,
+                   std::string                            & buf);
+
+}
+
+#ifndef  CAX_STATIC_LIB
+#include "write_CAX.cpp"
+#endif
+
+#endif // WRITE_CAX
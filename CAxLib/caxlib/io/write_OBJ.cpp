@@ -15,6 +15,16 @@ CAX_INLINE
 void write_OBJ(const char                * filename,
                const std::vector<double> & xyz,
                const std::vector<u_int>  & tri)
+{
+    write_OBJ(filename, xyz.data(), xyz.size(), tri.data(), tri.size());
+}
+
+CAX_INLINE
+void write_OBJ(const char                * filename,
+               const double              * xyz,
+               const size_t                n_xyz,
+               const u_int               * tri,
+               const size_t                n_tri)
 {
     setlocale(LC_NUMERIC, "en_US.UTF-8"); // makes sure "." is the decimal separator
 
@@ -26,14 +36,14 @@ void write_OBJ(const char                * filename,
         exit(-1);
     }
 
-    for(size_t i=0; i<xyz.size(); i+=3)
+    for(size_t i=0; i<n_xyz; i+=3)
     {
         //http://stackoverflow.com/questions/16839658/printf-width-specifier-to-maintain-precision-of-floating-point-value
         //
         fprintf(fp, "v %.17g %.17g %.17g\n", xyz[i], xyz[i+1], xyz[i+2]);
     }
 
-    for(size_t i=0; i<tri.size(); i+=3)
+    for(size_t i=0; i<n_tri; i+=3)
     {
         fprintf(fp, "f %d %d %d\n", tri[i] + 1, tri[i+1] + 1, tri[i+2] + 1);
     }
@@ -14,6 +14,15 @@ void write_OBJ(const char                * filename,
                const std::vector<double> & xyz,
                const std::vector<u_int>  & tri);
 
+// same as above, for the N_XYZ coordinates at XYZ and the N_TRI indices at TRI
+//
+CAX_INLINE
+void write_OBJ(const char                * filename,
+               const double              * xyz,
+               const size_t                n_xyz,
+               const u_int               * tri,
+               const size_t                n_tri);
+
 }
 
 #ifndef  CAX_STATIC_LIB
@@ -6,6 +6,7 @@
 #include "write_OFF.h"
 
 #include <iostream>
+#include <stdio.h>
 
 namespace caxlib
 {
@@ -15,8 +16,16 @@ void write_OFF(const char                * filename,
               const std::vector<double> & xyz,
               const std::vector<u_int>  & tri)
 {
-    setlocale(LC_NUMERIC, "en_US.UTF-8"); // makes sure "." is the decimal separator
+    write_OFF(filename, xyz.data(), xyz.size(), tri.data(), tri.size());
+}
 
+CAX_INLINE
+void write_OFF(const char                * filename,
+               const double              * xyz,
+               const size_t                n_xyz,
+               const u_int               * tri,
+               const size_t                n_tri)
+{
     FILE *fp = fopen(filename, "w");
 
     if(!fp)
@@ -25,21 +34,51 @@ void write_OFF(const char                * filename,
         exit(-1);
     }
 
-    fprintf (fp, "OFF\n%zu %zu 0\n", xyz.size()/3, tri.size()/3);
+    std::string buf;
+    serialize_OFF(xyz, n_xyz, tri, n_tri, buf);
+    fwrite(buf.c_str(), 1, buf.size(), fp);
 
-    for(size_t i=0; i<xyz.size(); i+=3)
+    fclose(fp);
+}
+
+CAX_INLINE
+void serialize_OFF(const std::vector<double> & xyz,
+                   const std::vector<u_int>  & tri,
+                   std::string               & buf)
+{
+    serialize_OFF(xyz.data(), xyz.size(), tri.data(), tri.size(), buf);
+}
+
+CAX_INLINE
+void serialize_OFF(const double              * xyz,
+                   const size_t                n_xyz,
+                   const u_int               * tri,
+                   const size_t                n_tri,
+                   std::string               & buf)
+{
+    setlocale(LC_NUMERIC, "en_US.UTF-8"); // makes sure "." is the decimal separator
+
+    char line[128];
+
+    buf.clear();
+    buf.reserve(20 * n_xyz + 12 * n_tri);
+
+    snprintf(line, sizeof(line), "OFF\n%zu %zu 0\n", n_xyz/3, n_tri/3);
+    buf += line;
+
+    for(size_t i=0; i<n_xyz; i+=3)
     {
         //http://stackoverflow.com/questions/16839658/printf-width-specifier-to-maintain-precision-of-floating-point-value
         //
-        fprintf(fp, "%.17g %.17g %.17g\n", xyz[i], xyz[i+1], xyz[i+2]);
+        snprintf(line, sizeof(line), "%.17g %.17g %.17g\n", xyz[i], xyz[i+1], xyz[i+2]);
+        buf += line;
     }
 
-    for(size_t i=0; i<tri.size(); i+=3)
+    for(size_t i=0; i<n_tri; i+=3)
     {
-        fprintf(fp, "3 %d %d %d\n", tri[i], tri[i+1], tri[i+2]);
+        snprintf(line, sizeof(line), "3 %d %d %d\n", tri[i], tri[i+1], tri[i+2]);
+        buf += line;
     }
-
-    fclose(fp);
 }
 
 }
@@ -3,6 +3,7 @@
 
 #include "../caxlib.h"
 
+#include <string>
 #include <sys/types.h>
 #include <vector>
 
@@ -14,6 +15,31 @@ void write_OFF(const char                * filename,
                const std::vector<double> & xyz,
                const std::vector<u_int>  & tri);
 
+// same as above, for the N_XYZ coordinates at XYZ and the N_TRI indices at
+// TRI (e.g. the borrowed arrays of a memory mapped mesh, that are written
+// without being copied)
+//
+CAX_INLINE
+void write_OFF(const char                * filename,
+               const double              * xyz,
+               const size_t                n_xyz,
+               const u_int               * tri,
+               const size_t                n_tri);
+
+// same as write_OFF(), but the content of the file goes in BUF
+//
+CAX_INLINE
+void serialize_OFF(const std::vector<double> & xyz,
+                   const std::vector<u_int>  & tri,
+                   std::string               & buf);
+
+CAX_INLINE
+void serialize_OFF(const double              * xyz,
+                   const size_t                n_xyz,
+                   const u_int               * tri,
+                   const size_t                n_tri,
+                   std::string               & buf);
+
 }
 
 #ifndef  CAX_STATIC_LIB
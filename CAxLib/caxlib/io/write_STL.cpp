@@ -5,66 +5,141 @@
 
 #include "write_STL.h"
 
+#include <assert.h>
 #include <iostream>
+#include <stdint.h>
+#include <string.h>
 
 namespace caxlib
 {
 
-CAX_INLINE
-void write_STL(const char                   * filename,
-               const std::vector<double>    & xyz,
-               const std::vector<u_int>     & tri)
+namespace
 {
-    setlocale(LC_NUMERIC, "en_US.UTF-8"); // makes sure "." is the decimal separator
+    // position of vertex VID, rotated by the (row major) matrix R around C.
+    // R == NULL means no rotation
+    //
+    inline vec3d stl_vertex(const double * xyz, const size_t n_xyz, const u_int vid, const double * R, const vec3d & c)
+    {
+        assert(3*(size_t)vid+2 < n_xyz);
+        vec3d p(xyz[3*vid+0], xyz[3*vid+1], xyz[3*vid+2]);
 
-    std::vector<double> t_norm;
+        if (R == NULL) return p;
 
-    t_norm.clear();
-    t_norm.resize(tri.size());
+        p -= c;
+        return vec3d(R[0] * p.x() + R[1] * p.y() + R[2] * p.z(),
+                     R[3] * p.x() + R[4] * p.y() + R[5] * p.z(),
+                     R[6] * p.x() + R[7] * p.y() + R[8] * p.z()) + c;
+    }
 
-    for(int tid=0; tid<tri.size() /3; ++tid)
+    inline vec3d stl_normal(const vec3d & v0, const vec3d & v1, const vec3d & v2)
     {
-        int tid_ptr = tid * 3;
-
-        vec3d v0 = vec3d (xyz.at(tri[tid_ptr+0] *3), xyz.at(tri[tid_ptr+0] *3 +1), xyz.at(tri[tid_ptr+0] *3 +2));
-        vec3d v1 = vec3d (xyz.at(tri[tid_ptr+1] *3), xyz.at(tri[tid_ptr+1] *3 +1), xyz.at(tri[tid_ptr+1] *3 +2));
-        vec3d v2 = vec3d (xyz.at(tri[tid_ptr+2] *3), xyz.at(tri[tid_ptr+2] *3 +1), xyz.at(tri[tid_ptr+2] *3 +2));
-
         vec3d u = v1 - v0;    u.normalize();
         vec3d v = v2 - v0;    v.normalize();
         vec3d n = u.cross(v); n.normalize();
-
-        t_norm[tid_ptr + 0] = n.x();
-        t_norm[tid_ptr + 1] = n.y();
-        t_norm[tid_ptr + 2] = n.z();
+        return n;
     }
 
-
-    FILE *fp;
-
-    if ((fp = fopen(filename,"w")) == NULL)
+    // triangles are written one at a time (binary records are buffered), so
+    // that no rotated copy of the mesh (nor of its normals) is ever made
+    //
+    inline void stream_STL(const char                * filename,
+                           const double              * xyz,
+                           const size_t                n_xyz,
+                           const u_int               * tri,
+                           const size_t                n_tri,
+                           const double              * R,
+                           const vec3d               & c,
+                           const StlFormat             format)
     {
-      std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : write_STL() : can't open " << filename << " for output" << std::endl;
-      exit(-1);
+        FILE *fp = fopen(filename, (format == STL_BINARY) ? "wb" : "w");
+
+        if (fp == NULL)
+        {
+            std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : write_STL() : can't open " << filename << " for output" << std::endl;
+            exit(-1);
+        }
+
+        uint32_t n_tris = n_tri / 3;
+
+        if (format == STL_BINARY)
+        {
+            // little endian, as the format requires (and x86 does)
+            //
+            char header[80] = "binary STL written by CAxLib";
+            fwrite(header,  1, 80, fp);
+            fwrite(&n_tris, 4, 1,  fp);
+
+            const size_t REC   = 50;
+            const size_t BATCH = 4096;
+            std::vector<char> buf(REC * BATCH, 0);
+
+            for(uint32_t beg=0; beg<n_tris; beg+=BATCH)
+            {
+                uint32_t end = std::min<uint32_t>(n_tris, beg + BATCH);
+                char   * rec = &buf[0];
+
+                for(uint32_t tid=beg; tid<end; ++tid, rec+=REC)
+                {
+                    vec3d v0 = stl_vertex(xyz, n_xyz, tri[3*tid+0], R, c);
+                    vec3d v1 = stl_vertex(xyz, n_xyz, tri[3*tid+1], R, c);
+                    vec3d v2 = stl_vertex(xyz, n_xyz, tri[3*tid+2], R, c);
+                    vec3d n  = stl_normal(v0, v1, v2);
+
+                    float f[12] = { (float)n.x(),  (float)n.y(),  (float)n.z(),
+                                    (float)v0.x(), (float)v0.y(), (float)v0.z(),
+                                    (float)v1.x(), (float)v1.y(), (float)v1.z(),
+                                    (float)v2.x(), (float)v2.y(), (float)v2.z() };
+                    memcpy(rec, f, 48); // the last two bytes (attributes) stay 0
+                }
+                fwrite(&buf[0], REC, end - beg, fp);
+            }
+        }
+        else
+        {
+            setlocale(LC_NUMERIC, "en_US.UTF-8"); // makes sure "." is the decimal separator
+
+            fprintf(fp,"solid JMESH_STL\n");
+
+            for(uint32_t tid=0; tid<n_tris; ++tid)
+            {
+                vec3d v0 = stl_vertex(xyz, n_xyz, tri[3*tid+0], R, c);
+                vec3d v1 = stl_vertex(xyz, n_xyz, tri[3*tid+1], R, c);
+                vec3d v2 = stl_vertex(xyz, n_xyz, tri[3*tid+2], R, c);
+                vec3d n  = stl_normal(v0, v1, v2);
+
+                fprintf(fp," facet normal %lf %lf %lf\n", n.x(), n.y(), n.z());
+                fprintf(fp,"  outer loop\n");
+                fprintf(fp,"   vertex %lf %lf %lf\n", v0.x(), v0.y(), v0.z());
+                fprintf(fp,"   vertex %lf %lf %lf\n", v1.x(), v1.y(), v1.z());
+                fprintf(fp,"   vertex %lf %lf %lf\n", v2.x(), v2.y(), v2.z());
+                fprintf(fp,"  endloop\n");
+                fprintf(fp," endfacet\n");
+            }
+            fprintf(fp,"endsolid JMESH_STL\n");
+        }
+
+        fclose(fp);
     }
+}
 
-    fprintf(fp,"solid JMESH_STL\n");
+CAX_INLINE
+void write_STL(const char                   * filename,
+               const std::vector<double>    & xyz,
+               const std::vector<u_int>     & tri,
+               const StlFormat                format)
+{
+    write_STL(filename, xyz.data(), xyz.size(), tri.data(), tri.size(), format);
+}
 
-    for (uint i=0; i < tri.size() / 3; i++)
-    {
-        uint tid = i*3;
-
-        fprintf(fp," facet normal %lf %lf %lf\n", t_norm[tid], t_norm[tid+1], t_norm[tid+2]);
-        fprintf(fp,"  outer loop\n");
-        fprintf(fp,"   vertex %lf %lf %lf\n", xyz.at(tri.at(tid+0) * 3), xyz.at(tri.at(tid+0) * 3 +1), xyz.at(tri.at(tid+0) * 3 +2));
-        fprintf(fp,"   vertex %lf %lf %lf\n", xyz.at(tri.at(tid+1) * 3), xyz.at(tri.at(tid+1) * 3 +1), xyz.at(tri.at(tid+1) * 3 +2));
-        fprintf(fp,"   vertex %lf %lf %lf\n", xyz.at(tri.at(tid+2) * 3), xyz.at(tri.at(tid+2) * 3 +1), xyz.at(tri.at(tid+2) * 3 +2));
-        fprintf(fp,"  endloop\n");
-        fprintf(fp," endfacet\n");
-     }
-     fprintf(fp,"endsolid JMESH_STL\n");
-
-     fclose(fp);
+CAX_INLINE
+void write_STL(const char                   * filename,
+               const double                 * xyz,
+               const size_t                   n_xyz,
+               const u_int                  * tri,
+               const size_t                   n_tri,
+               const StlFormat                format)
+{
+    stream_STL(filename, xyz, n_xyz, tri, n_tri, NULL, vec3d(0,0,0), format);
 }
 
 CAX_INLINE
@@ -72,35 +147,23 @@ void export_STL(const char                  * filename,
                 const std::vector<double>   & xyz,
                 const std::vector<u_int>    & tri,
                 const Bbox                  & bb,
-                const GlobalAnnotations     & glob_ann)
+                const GlobalAnnotations     & glob_ann,
+                const StlFormat               format)
 {
-    setlocale(LC_NUMERIC, "en_US.UTF-8"); // makes sure "." is the decimal separator
-
-    std::vector<double> rotated_xyz;
-    rotated_xyz.resize(xyz.size());
-
-    vec3d c = bb.center();
-
-    // Rotate geometry
-
-    for(uint vid=0; vid < xyz.size(); vid += 3)
-    {
-        vec3d pos = vec3d(xyz[vid+0], xyz[vid+1], xyz[vid+2]) - c;
-
-        vec3d tmp;
-        tmp[0] = glob_ann.orientation[0] * pos.x() + glob_ann.orientation[1] * pos.y() + glob_ann.orientation[2] * pos.z();
-        tmp[1] = glob_ann.orientation[3] * pos.x() + glob_ann.orientation[4] * pos.y() + glob_ann.orientation[5] * pos.z();
-        tmp[2] = glob_ann.orientation[6] * pos.x() + glob_ann.orientation[7] * pos.y() + glob_ann.orientation[8] * pos.z();
-        pos = tmp;
-
-        pos += c;
-
-        rotated_xyz.at(vid + 0) = pos.x();
-        rotated_xyz.at(vid + 1) = pos.y();
-        rotated_xyz.at(vid + 2) = pos.z();
-    }
+    export_STL(filename, xyz.data(), xyz.size(), tri.data(), tri.size(), bb, glob_ann, format);
+}
 
-    write_STL(filename, rotated_xyz, tri);
+CAX_INLINE
+void export_STL(const char                  * filename,
+                const double                * xyz,
+                const size_t                  n_xyz,
+                const u_int                 * tri,
+                const size_t                  n_tri,
+                const Bbox                  & bb,
+                const GlobalAnnotations     & glob_ann,
+                const StlFormat               format)
+{
+    stream_STL(filename, xyz, n_xyz, tri, n_tri, glob_ann.orientation, bb.center(), format);
 }
 
 
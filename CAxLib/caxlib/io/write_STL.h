@@ -11,17 +11,53 @@
 namespace caxlib
 {
 
+// Binary STL (80 bytes header, then 50 bytes per triangle, in single
+// precision) is about 5 times smaller than ASCII STL, and much faster to
+// write and parse
+//
+typedef enum
+{
+    STL_BINARY,
+    STL_ASCII
+}
+StlFormat;
+
 CAX_INLINE
 void write_STL(const char                * filename,
                const std::vector<double> & xyz,
-               const std::vector<u_int>  & tri);
+               const std::vector<u_int>  & tri,
+               const StlFormat             format = STL_BINARY);
+
+// same as above, for the N_XYZ coordinates at XYZ and the N_TRI indices at TRI
+//
+CAX_INLINE
+void write_STL(const char                * filename,
+               const double              * xyz,
+               const size_t                n_xyz,
+               const u_int               * tri,
+               const size_t                n_tri,
+               const StlFormat             format = STL_BINARY);
 
+// same as write_STL(), with the mesh rotated around the center of BB by the
+// orientation matrix in GLOB_ANN. Vertices are rotated while they are written
+//
 CAX_INLINE
 void export_STL(const char                  * filename,
                 const std::vector<double>   & xyz,
                 const std::vector<u_int>    & tri,
                 const Bbox                  & bb,
-                const GlobalAnnotations     & glob_ann);
+                const GlobalAnnotations     & glob_ann,
+                const StlFormat               format = STL_BINARY);
+
+CAX_INLINE
+void export_STL(const char                  * filename,
+                const double                * xyz,
+                const size_t                  n_xyz,
+                const u_int                 * tri,
+                const size_t                  n_tri,
+                const Bbox                  & bb,
+                const GlobalAnnotations     & glob_ann,
+                const StlFormat               format = STL_BINARY);
 
 }
 
@@ -96,16 +96,67 @@ void create_zip (const std::string zip_filename, const std::string off_filename,
     remove (ann_filename.c_str());
 }
 
+// add BUF (which must stay alive until the archive is closed) to ARCHIVE
+//
+CAX_INLINE
+void add_to_zip(zip * archive, const std::string & name, const std::string & buf, const ZipCompression compression)
+{
+    caxlib::logger << " Adding " << name << " (" << buf.size() << " bytes)" << endl;
+
+    zip_source *source = zip_source_buffer(archive, buf.c_str(), buf.size(), 0);
+
+    if(source == NULL)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : write_ZIP() : impossible to buffer " << name << endl;
+        exit(-1);
+    }
+
+    zip_int64_t index = zip_file_add(archive, name.c_str(), source, ZIP_FL_OVERWRITE);
+
+    if(index < 0)
+    {
+        zip_source_free(source);
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : write_ZIP() : impossible to add " << name << endl;
+        exit(-1);
+    }
+
+    // the compression level is honored since libzip 1.3. Older versions
+    // deflate with their default level anyway
+    //
+    switch (compression)
+    {
+        case ZIP_COMPRESSION_STORE : zip_set_file_compression(archive, index, ZIP_CM_STORE,   0); break;
+        case ZIP_COMPRESSION_FAST  : zip_set_file_compression(archive, index, ZIP_CM_DEFLATE, 1); break;
+        case ZIP_COMPRESSION_BEST  : zip_set_file_compression(archive, index, ZIP_CM_DEFLATE, 9); break;
+        default : break;
+    }
+}
+
 CAX_INLINE
 void write_ZIP (const char                                  * filename,
                 const std::vector<double>                   & xyz,
                 const std::vector<u_int>                    & tri,
                 const GlobalAnnotations                     & glob_ann,
                 const std::vector<VertexAnnotations>   & vertex_ann,
-                const std::vector<TriangleAnnotations> & triangle_ann )
+                const std::vector<TriangleAnnotations> & triangle_ann,
+                const ZipCompression                          compression,
+                const AnnListEncoding                         ann_encoding)
 {
-    setlocale(LC_NUMERIC, "en_US.UTF-8"); // makes sure "." is the decimal separator
+    write_ZIP(filename, xyz.data(), xyz.size(), tri.data(), tri.size(), glob_ann, vertex_ann, triangle_ann, compression, ann_encoding);
+}
 
+CAX_INLINE
+void write_ZIP (const char                                  * filename,
+                const double                                * xyz,
+                const size_t                                  n_xyz,
+                const u_int                                 * tri,
+                const size_t                                  n_tri,
+                const GlobalAnnotations                     & glob_ann,
+                const std::vector<VertexAnnotations>   & vertex_ann,
+                const std::vector<TriangleAnnotations> & triangle_ann,
+                const ZipCompression                          compression,
+                const AnnListEncoding                         ann_encoding)
+{
     std::string basename = filename;
 
     // LibZip automatically adds ".zip" extension.
@@ -116,16 +167,36 @@ void write_ZIP (const char                                  * filename,
         basename = basename.substr(0, basename.length() -4);
     }
 
-    std::string off_filename = basename + "off";
-    std::string ann_filename = basename + "ann";
     std::string zip_filename = basename + "zip";
+    std::string entry_name   = basename.substr(basename.find_last_of("/\\") + 1);
 
-    write_OFF(off_filename.c_str(), xyz, tri);
+    // OFF and ANN are serialized in memory and added from there: no
+    // temporary files
+    //
+    std::string off, ann;
+    serialize_OFF(xyz, n_xyz, tri, n_tri, off);
+    serialize_ANN(glob_ann, vertex_ann, triangle_ann, ann, ann_encoding);
 
-    write_ANN(ann_filename.c_str(), glob_ann, vertex_ann, triangle_ann);
+    caxlib::logger << " Creating archive " << zip_filename << endl;
 
-    create_zip (zip_filename.c_str(), off_filename.c_str(), ann_filename.c_str());
+    int  error   = 0;
+    zip *archive = zip_open(zip_filename.c_str(), ZIP_CREATE | ZIP_TRUNCATE, &error);
 
+    if(archive == NULL || error != 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : write_ZIP() : impossible to create " << zip_filename << endl;
+        exit(-1);
+    }
+
+    add_to_zip(archive, entry_name + "off", off, compression);
+    add_to_zip(archive, entry_name + "ann", ann, compression);
+
+    if (zip_close(archive) != 0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : write_ZIP() : impossible to write " << zip_filename << " (" << zip_strerror(archive) << ")" << endl;
+        zip_discard(archive);
+        exit(-1);
+    }
 }
 
 }
@@ -3,7 +3,9 @@
 
 #include "../caxlib.h"
 #include "../trimesh/annotations.h"
+#include "write_ANN.h"
 
+#include <string>
 #include <sys/types.h>
 #include <vector>
 
@@ -14,13 +16,42 @@ CAX_INLINE
 void create_zip (const std::string zip_filename, const std::string off_filename, const std::string ann_filename);
 
 
+// Compression of the archive entries: no compression, or deflate at the
+// default, fastest or best level. Small parts are often faster to store
+// than to compress
+//
+typedef enum
+{
+    ZIP_COMPRESSION_DEFAULT,
+    ZIP_COMPRESSION_STORE,
+    ZIP_COMPRESSION_FAST,
+    ZIP_COMPRESSION_BEST
+}
+ZipCompression;
+
 CAX_INLINE
 void write_ZIP( const char                * filename,
                 const std::vector<double>       & xyz,
                 const std::vector<u_int>        & tri,
                 const GlobalAnnotations         & glob_ann,
                 const std::vector<VertexAnnotations>    & vertex_ann,
-                const std::vector<TriangleAnnotations>  & triangle_ann);
+                const std::vector<TriangleAnnotations>  & triangle_ann,
+                const ZipCompression              compression = ZIP_COMPRESSION_DEFAULT,
+                const AnnListEncoding             ann_encoding = ANN_LISTS_IDS);
+
+// same as above, for the N_XYZ coordinates at XYZ and the N_TRI indices at TRI
+//
+CAX_INLINE
+void write_ZIP( const char                * filename,
+                const double                    * xyz,
+                const size_t                      n_xyz,
+                const u_int                     * tri,
+                const size_t                      n_tri,
+                const GlobalAnnotations         & glob_ann,
+                const std::vector<VertexAnnotations>    & vertex_ann,
+                const std::vector<TriangleAnnotations>  & triangle_ann,
+                const ZipCompression              compression = ZIP_COMPRESSION_DEFAULT,
+                const AnnListEncoding             ann_encoding = ANN_LISTS_IDS);
 }
 
 #ifndef  CAX_STATIC_LIB
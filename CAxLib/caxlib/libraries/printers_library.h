@@ -13,17 +13,17 @@ namespace caxlib
     typedef struct
     {
         std::string           name;
-        double                layer_thickness_min;
-        double                layer_thickness_max;
-        double                layer_thickness;
-        double                laser_beam_diameter_min;
-        double                laser_beam_diameter_max;
-        double                laser_beam_diameter;
-        double                chamber_temperature_min;
-        double                chamber_temperature_max;
-        double                chamber_temperature;
-        double                chamber_dimension[3];
-        double                weight_max;
+        double                layer_thickness_min      = 0.0;
+        double                layer_thickness_max      = 0.0;
+        double                layer_thickness          = 0.0;
+        double                laser_beam_diameter_min  = 0.0;
+        double                laser_beam_diameter_max  = 0.0;
+        double                laser_beam_diameter      = 0.0;
+        double                chamber_temperature_min  = 0.0;
+        double                chamber_temperature_max  = 0.0;
+        double                chamber_temperature      = 0.0;
+        double                chamber_dimension[3]     = { 0.0, 0.0, 0.0 };
+        double                weight_max               = 0.0;
         std::vector<Bbox>     no_print_zones;
         std::vector<Material> supported_materials;
     }
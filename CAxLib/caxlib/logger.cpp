@@ -44,6 +44,12 @@ void Logger::disable()
     dispatch_to_file = false;
 }
 
+CAX_INLINE
+bool Logger::is_enabled() const
+{
+    return dispatch_to_cout || dispatch_to_file;
+}
+
 CAX_INLINE
 void Logger::set_log_file(const char * filename)
 {
@@ -20,6 +20,7 @@ struct Logger : std::ostream, std::streambuf
     void dispatch_file(char c);
     void enable();
     void disable();
+    bool is_enabled() const;
     void set_log_file(const char *filename);
 
     bool dispatch_to_cout;
@@ -0,0 +1,128 @@
+#ifndef MAPPED_VECTOR_H
+#define MAPPED_VECTOR_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace caxlib
+{
+
+// Array that either owns its elements (in a std::vector), or borrows them
+// read only from memory that someone else owns, e.g. a memory mapped file
+// kept alive by a shared pointer. Reading costs the same in both cases. Any
+// non const access to a borrowed array makes a private copy first (copy on
+// write), so that borrowed memory is never written. Copies of a borrowed
+// array share the borrowed memory.
+//
+template<typename T>
+class MappedVector
+{
+    public:
+
+        typedef T           value_type;
+        typedef T         * iterator;
+        typedef const T   * const_iterator;
+
+        MappedVector() : ptr(NULL), n(0) {}
+
+        MappedVector(const MappedVector & v) : vec(v.vec), keep(v.keep), ptr(v.ptr), n(v.n) { sync(); }
+
+        MappedVector & operator=(const MappedVector & v)
+        {
+            vec  = v.vec;
+            keep = v.keep;
+            ptr  = v.ptr;
+            n    = v.n;
+            sync();
+            return *this;
+        }
+
+        MappedVector & operator=(const std::vector<T> & v)
+        {
+            keep.reset();
+            vec = v;
+            sync();
+            return *this;
+        }
+
+        // use the N elements at P, which stay alive as long as KEEP does
+        //
+        void borrow(const T * p, const size_t n, const std::shared_ptr<const void> & keep)
+        {
+            std::vector<T>().swap(vec);
+            this->keep = keep;
+            this->ptr  = p;
+            this->n    = n;
+        }
+
+        bool is_borrowed() const { return keep != nullptr; }
+
+        size_t size()     const { return n;      }
+        bool   empty()    const { return n == 0; }
+        size_t capacity() const { return vec.capacity(); } // owned elements only
+
+        const T * data()  const { return ptr;     }
+        const T * begin() const { return ptr;     }
+        const T * end()   const { return ptr + n; }
+
+        T * data()  { detach(); return vec.data(); }
+        T * begin() { detach(); return vec.data(); }
+        T * end()   { detach(); return vec.data() + vec.size(); }
+
+        const T & operator[](const size_t i) const { assert(i < n); return ptr[i]; }
+              T & operator[](const size_t i)       { assert(i < n); detach(); return vec[i]; }
+
+        const T & at(const size_t i) const
+        {
+            if (i >= n) throw std::out_of_range("MappedVector::at");
+            return ptr[i];
+        }
+
+        T & at(const size_t i)
+        {
+            if (i >= n) throw std::out_of_range("MappedVector::at");
+            detach();
+            return vec[i];
+        }
+
+        void clear()                               { keep.reset(); vec.clear(); sync(); }
+        void reserve(const size_t m)               { detach(); vec.reserve(m);      sync(); }
+        void resize(const size_t m)                { detach(); vec.resize(m);       sync(); }
+        void resize(const size_t m, const T & val) { detach(); vec.resize(m, val);  sync(); }
+        void push_back(const T & val)              { detach(); vec.push_back(val);  sync(); }
+        void swap(std::vector<T> & v)              { detach(); vec.swap(v);         sync(); }
+
+        // the elements as a std::vector. A borrowed array is copied (and
+        // stops borrowing), which invalidates the pointers it handed out
+        //
+        const std::vector<T> & vector() const { detach(); return vec; }
+
+    private:
+
+        mutable std::vector<T>              vec;
+        mutable std::shared_ptr<const void> keep;
+        mutable const T                   * ptr;
+        mutable size_t                      n;
+
+        void detach() const
+        {
+            if (keep == nullptr) return;
+            vec.assign(ptr, ptr + n);
+            keep.reset();
+            sync();
+        }
+
+        void sync() const
+        {
+            if (keep != nullptr) return;
+            ptr = vec.data();
+            n   = vec.size();
+        }
+};
+
+}
+
+#endif // MAPPED_VECTOR_H
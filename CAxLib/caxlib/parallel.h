@@ -0,0 +1,142 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "caxlib.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// parallel_for() spawns its own std::threads by default. Build with
+// -DCAX_OPENMP (and -fopenmp) to run it on the OpenMP runtime instead
+//
+#ifdef CAX_OPENMP
+#include <omp.h>
+#endif
+
+namespace caxlib
+{
+
+// indices per block in parallel_blocks() and parallel_reduce()
+//
+static const int PARALLEL_BLOCK = 4096;
+
+// number of threads used by parallel_for() (one per core)
+//
+CAX_INLINE int num_threads()
+{
+#ifdef CAX_OPENMP
+    return std::max(1, omp_get_max_threads());
+#else
+    return std::max(1, (int)std::thread::hardware_concurrency());
+#endif
+}
+
+// true for the threads spawned by parallel_for(), or that belong to any other
+// pool that already keeps all the cores busy (set it on them). parallel_for()
+// does not spawn more threads when called from them
+//
+CAX_INLINE bool & is_worker_thread()
+{
+    static thread_local bool worker = false;
+    return worker;
+}
+
+// Call func(i) for each i in [beg,end). The range is split in contiguous
+// chunks of (about) the same size, one per thread, so it suits loops whose
+// iterations all cost the same. func must be thread safe: the lazy evaluation
+// of mesh relations is not (require() whatever is needed before calling
+// parallel_for), and each thread has its own logger and timers
+//
+template<typename Func>
+CAX_INLINE void parallel_for(const int beg, const int end, const Func & func)
+{
+    int n         = end - beg;
+    int n_threads = std::min(num_threads(), n);
+
+    if (n_threads <= 1 || is_worker_thread())
+    {
+        for(int i=beg; i<end; ++i) func(i);
+        return;
+    }
+
+#ifdef CAX_OPENMP
+    if (omp_in_parallel())
+    {
+        for(int i=beg; i<end; ++i) func(i);
+        return;
+    }
+
+    #pragma omp parallel for schedule(static) num_threads(n_threads)
+    for(int i=beg; i<end; ++i) func(i);
+#else
+    int chunk = (n + n_threads - 1) / n_threads;
+
+    std::vector<std::thread> threads;
+    for(int b=beg; b<end; b+=chunk)
+    {
+        int e = std::min(end, b + chunk);
+        threads.push_back(std::thread([&func, b, e]()
+        {
+            is_worker_thread() = true;
+            for(int i=b; i<e; ++i) func(i);
+        }));
+    }
+    for(std::thread & t : threads) t.join();
+#endif
+}
+
+// Call func(b,e) for consecutive blocks [b,e) of PARALLEL_BLOCK indices that
+// cover [beg,end), in parallel. Meant for loops with cheap iterations (e.g.
+// per element kernels), that would not pay the threads back on small meshes:
+// ranges of a single block run on the calling thread
+//
+template<typename Func>
+CAX_INLINE void parallel_blocks(const int beg, const int end, const Func & func)
+{
+    int n_blocks = (std::max(0, end - beg) + PARALLEL_BLOCK - 1) / PARALLEL_BLOCK;
+
+    parallel_for(0, n_blocks, [&](const int k)
+    {
+        func(beg + k * PARALLEL_BLOCK, std::min(end, beg + (k+1) * PARALLEL_BLOCK));
+    });
+}
+
+// Reduce [beg,end) with reduce(a,b), starting from init: func(b,e) returns the
+// value of a block (see parallel_blocks()), and blocks are combined in order.
+// Blocks do not depend on the number of threads, so neither does the result
+// (e.g. floating point sums are deterministic)
+//
+template<typename T, typename Func, typename Reduce>
+CAX_INLINE T parallel_reduce(const int beg, const int end, const T & init, const Func & func, const Reduce & reduce)
+{
+    int n_blocks = (std::max(0, end - beg) + PARALLEL_BLOCK - 1) / PARALLEL_BLOCK;
+
+    std::vector<T> partial(n_blocks, init);
+    parallel_for(0, n_blocks, [&](const int k)
+    {
+        partial[k] = func(beg + k * PARALLEL_BLOCK, std::min(end, beg + (k+1) * PARALLEL_BLOCK));
+    });
+
+    T res = init;
+    for(const T & p : partial) res = reduce(res, p);
+    return res;
+}
+
+// sum of func(i) for each i in [beg,end) (see parallel_reduce())
+//
+template<typename Func>
+CAX_INLINE double parallel_sum(const int beg, const int end, const Func & func)
+{
+    return parallel_reduce(beg, end, 0.0, [&](const int b, const int e)
+    {
+        double sum = 0.0;
+        for(int i=b; i<e; ++i) sum += func(i);
+        return sum;
+    },
+    [](const double a, const double b) { return a + b; });
+}
+
+}
+
+#endif // PARALLEL_H
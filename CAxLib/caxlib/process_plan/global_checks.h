@@ -43,9 +43,16 @@ bool check_size(Trimesh & m)
     const Printer & printer = m.global_annotations().printer;
     bool  too_big = false;
 
-    if (m.bbox().delta_x() < printer.chamber_dimension[0]) too_big = true;
-    if (m.bbox().delta_y() < printer.chamber_dimension[1]) too_big = true;
-    if (m.bbox().delta_z() < printer.chamber_dimension[2]) too_big = true;
+    // extents along the axes, from the convex hull (which is then ready for
+    // the orientation, see orient())
+    //
+    vec3d axes[3] = { vec3d(1,0,0), vec3d(0,1,0), vec3d(0,0,1) };
+    for(int i=0; i<3; ++i)
+    {
+        double min, max;
+        m.extent_along(axes[i], min, max);
+        if (max - min > printer.chamber_dimension[i]) too_big = true;
+    }
 
     if (too_big)
     {
@@ -0,0 +1,234 @@
+#ifndef NORMAL_HISTOGRAM_H
+#define NORMAL_HISTOGRAM_H
+
+#include "../caxlib.h"
+#include "../trimesh/trimesh.h"
+
+namespace caxlib
+{
+
+// Area weighted histogram of the triangle normals of a mesh. The sphere of
+// directions is binned with a cube map (6 faces, res x res bins each, equal
+// angle mapping), and the triangles are sorted by bin so that the ones in a
+// bin can be visited without touching the others.
+//
+// For each bin it stores the total area, the (unit) area weighted mean of its
+// normals and the radius of the cone around it that contains all of them.
+// Quantities that are linear in the normals (e.g. the cusp height error) come
+// exactly from area_normal, while the overhang area of a direction is bounded
+// from below and above in O(bins) (see overhang_area_bounds()), and computed
+// exactly visiting only the triangles of the bins that straddle the overhang
+// threshold (see overhang_area())
+//
+typedef struct
+{
+    int                 res;
+    std::vector<double> bin_area;
+    std::vector<vec3d>  bin_dir;
+    std::vector<double> bin_radius;  // radians. M_PI if the bin cannot be bounded
+    std::vector<int>    bin_beg;     // triangles of bin b are in [bin_beg[b], bin_beg[b+1])
+    std::vector<vec3d>  tri_normal;  // sorted by bin
+    std::vector<double> tri_area;    // sorted by bin
+    vec3d               area_normal; // sum of area * normal
+    double              tot_area;
+}
+NormalHistogram;
+
+// Overhang threshold, expanded per bin (see overhang_area_bounds())
+//
+typedef struct
+{
+    double              cos_thresh;
+    std::vector<double> cos_full;    // bin dir below it: the whole bin is overhanging
+    std::vector<double> cos_none;    // bin dir above it: nothing in the bin is overhanging
+}
+OverhangThresh;
+
+CAX_INLINE
+int normal_bin(const vec3d & n, const int res)
+{
+    double ax = fabs(n.x());
+    double ay = fabs(n.y());
+    double az = fabs(n.z());
+
+    int    face;
+    double u, v, ma;
+    if (ax >= ay && ax >= az) { face = (n.x() >= 0) ? 0 : 1; u = n.y(); v = n.z(); ma = ax; }
+    else if (ay >= az)        { face = (n.y() >= 0) ? 2 : 3; u = n.x(); v = n.z(); ma = ay; }
+    else                      { face = (n.z() >= 0) ? 4 : 5; u = n.x(); v = n.y(); ma = az; }
+
+    if (!(ma > 0)) return 0; // null (or NaN) normal
+
+    // equal angle mapping: bins span (about) the same solid angle
+    //
+    int i = (atan(u/ma) / (M_PI/4.0) + 1.0) * 0.5 * res;
+    int j = (atan(v/ma) / (M_PI/4.0) + 1.0) * 0.5 * res;
+    i = std::min(std::max(i, 0), res-1);
+    j = std::min(std::max(j, 0), res-1);
+
+    return (face * res + i) * res + j;
+}
+
+CAX_INLINE
+void build_normal_histogram(const Trimesh & m, const int res, NormalHistogram & h)
+{
+    timer_start("Build normal histogram");
+
+    m.require(Trimesh::T_NORMALS);
+
+    int nt     = m.num_triangles();
+    int n_bins = 6 * res * res;
+
+    h.res         = res;
+    h.area_normal = vec3d(0,0,0);
+    h.tot_area    = 0.0;
+    h.bin_area.assign(n_bins, 0.0);
+    h.bin_dir.assign(n_bins, vec3d(0,0,0));
+    h.bin_radius.assign(n_bins, 0.0);
+    h.bin_beg.assign(n_bins+1, 0);
+    h.tri_normal.resize(nt);
+    h.tri_area.resize(nt);
+
+    std::vector<int> bin(nt);
+    for(int tid=0; tid<nt; ++tid)
+    {
+        bin[tid] = normal_bin(m.triangle_normal(tid), res);
+        ++h.bin_beg[bin[tid]+1];
+    }
+    for(int b=0; b<n_bins; ++b) h.bin_beg[b+1] += h.bin_beg[b];
+
+    std::vector<int> pos(h.bin_beg.begin(), h.bin_beg.end()-1);
+    for(int tid=0; tid<nt; ++tid)
+    {
+        vec3d  n    = m.triangle_normal(tid);
+        double area = m.element_mass(tid);
+        int    b    = bin[tid];
+
+        h.tri_normal[pos[b]] = n;
+        h.tri_area[pos[b]]   = area;
+        ++pos[b];
+
+        h.bin_area[b] += area;
+        h.bin_dir[b]  += n * area;
+        h.area_normal += n * area;
+        h.tot_area    += area;
+    }
+
+    for(int b=0; b<n_bins; ++b)
+    {
+        if (h.bin_beg[b] == h.bin_beg[b+1]) continue;
+
+        // degenerate triangles do not have a unit normal (see vec3::normalize()),
+        // and the bounds on the angles do not hold for them
+        //
+        double len = h.bin_dir[b].length();
+        bool   ok  = (len > 0);
+        if (ok) h.bin_dir[b] /= len;
+
+        double radius = 0.0;
+        for(int i=h.bin_beg[b]; ok && i<h.bin_beg[b+1]; ++i)
+        {
+            const vec3d & n = h.tri_normal[i];
+            if (fabs(n.length() - 1.0) > 1e-10) ok = false;
+            else radius = std::max(radius, acos(std::min(1.0, std::max(-1.0, n.dot(h.bin_dir[b])))));
+        }
+
+        // pad the radius so that the round off in the dot products can
+        // never put a triangle on the wrong side of the threshold
+        //
+        h.bin_radius[b] = ok ? radius + 1e-9 : M_PI;
+    }
+
+    logger << nt << " normals in " << n_bins << " bins" << endl;
+
+    timer_stop("Build normal histogram");
+}
+
+// Triangles whose normal n satisfies n.dot(build_dir) <= cos_thresh are
+// overhangs (i.e. acos(n.dot(build_dir)) - 90 >= angle_thresh_deg, the same
+// test of Trimesh::get_overhangs()). Given the angle a between build_dir and
+// the direction of a bin, the angles of its normals are in [a-r, a+r], with r
+// the radius of the bin. Comparing cosines, a >= thresh + r means that the
+// whole bin is overhanging, a < thresh - r that nothing in the bin is
+//
+CAX_INLINE
+void overhang_thresh(const NormalHistogram & h, const double angle_thresh_deg, OverhangThresh & t)
+{
+    double thresh = (90.0 + angle_thresh_deg) * M_PI / 180.0;
+
+    t.cos_thresh = cos(thresh);
+    t.cos_full.resize(h.bin_radius.size());
+    t.cos_none.resize(h.bin_radius.size());
+
+    for(size_t b=0; b<h.bin_radius.size(); ++b)
+    {
+        double r = h.bin_radius[b];
+        t.cos_full[b] = (thresh + r <= M_PI) ? cos(thresh + r) : -2.0; // never
+        t.cos_none[b] = (thresh - r >= 0.0 ) ? cos(thresh - r) :  2.0; // never
+    }
+}
+
+// Lower and upper bound of the overhang area for (unit) BUILD_DIR, plus an
+// estimate in between them, that assigns each straddling bin as a whole
+// according to its direction. O(bins)
+//
+CAX_INLINE
+void overhang_area_bounds(const NormalHistogram & h,
+                          const OverhangThresh  & t,
+                          const vec3d           & build_dir,
+                          double                & lo,
+                          double                & hi,
+                          double                & estimate)
+{
+    lo = hi = estimate = 0.0;
+    for(size_t b=0; b<h.bin_area.size(); ++b)
+    {
+        if (h.bin_area[b] == 0.0) continue;
+
+        double c = h.bin_dir[b].dot(build_dir);
+        if (c <= t.cos_full[b])
+        {
+            lo       += h.bin_area[b];
+            hi       += h.bin_area[b];
+            estimate += h.bin_area[b];
+        }
+        else if (c <= t.cos_none[b])
+        {
+            hi += h.bin_area[b];
+            if (c <= t.cos_thresh) estimate += h.bin_area[b];
+        }
+    }
+}
+
+// Exact overhang area for (unit) BUILD_DIR. Only the triangles of the bins
+// that straddle the threshold are visited
+//
+CAX_INLINE
+double overhang_area(const NormalHistogram & h,
+                     const OverhangThresh  & t,
+                     const vec3d           & build_dir)
+{
+    double area = 0.0;
+    for(size_t b=0; b<h.bin_area.size(); ++b)
+    {
+        if (h.bin_area[b] == 0.0) continue;
+
+        double c = h.bin_dir[b].dot(build_dir);
+        if (c <= t.cos_full[b])
+        {
+            area += h.bin_area[b];
+        }
+        else if (c <= t.cos_none[b])
+        {
+            for(int i=h.bin_beg[b]; i<h.bin_beg[b+1]; ++i)
+            {
+                if (h.tri_normal[i].dot(build_dir) <= t.cos_thresh) area += h.tri_area[i];
+            }
+        }
+    }
+    return area;
+}
+
+}
+
+#endif // NORMAL_HISTOGRAM_H
@@ -7,8 +7,14 @@
 #define ORIENT_H
 
 #include "../caxlib.h"
+#include "../parallel.h"
 #include "../sphere_coverage.h"
+#include "../timer.h"
 #include "../trimesh/trimesh.h"
+#include "normal_histogram.h"
+#include "support_structures.h"
+
+#include <algorithm>
 
 namespace caxlib
 {
@@ -22,54 +28,321 @@ void define_rotation(const vec3d & build_dir, vec3d & axis, double & angle)
     assert(!std::isnan(angle));
 }
 
+// Size of the bounding box of M once rotated so that BUILD_DIR becomes the
+// z axis (see define_rotation()). The mesh is not copied nor rotated: the
+// vertices of its convex hull are projected onto the rows of the rotation
+// matrix, that are the x, y and z axes of the rotated frame
+//
 CAX_INLINE
-bool rotated_bbox_exceeds_chamber_size(const Trimesh & m, const vec3d & build_dir)
+void rotated_bbox_deltas(const Trimesh & m, const vec3d & build_dir, double deltas[3])
 {
-    Trimesh tmp_m = m;
-    vec3d   axis;
-    double  angle;
+    vec3d  axis;
+    double angle;
+    double R[3][3];
     define_rotation(build_dir, axis, angle);
-    tmp_m.rotate(axis, angle);
+    bake_rotation_matrix(axis, angle, R);
+
+    for(int j=0; j<3; ++j)
+    {
+        double min, max;
+        m.extent_along(vec3d(R[j][0], R[j][1], R[j][2]), min, max);
+        deltas[j] = max - min;
+    }
+}
 
-    if (tmp_m.bbox().delta_x() > m.global_annotations().printer.chamber_dimension[0])  return true;
-    if (tmp_m.bbox().delta_y() > m.global_annotations().printer.chamber_dimension[1])  return true;
-    if (tmp_m.bbox().delta_z() > m.global_annotations().printer.chamber_dimension[2]) return true;
+CAX_INLINE
+bool rotated_bbox_exceeds_chamber_size(const Trimesh & m, const vec3d & build_dir)
+{
+    double deltas[3];
+    rotated_bbox_deltas(m, build_dir, deltas);
+
+    if (deltas[0] > m.global_annotations().printer.chamber_dimension[0]) return true;
+    if (deltas[1] > m.global_annotations().printer.chamber_dimension[1]) return true;
+    if (deltas[2] > m.global_annotations().printer.chamber_dimension[2]) return true;
     return false;
 }
 
 CAX_INLINE
 double rotated_bbox_delta_z(const Trimesh & m, const vec3d & build_dir)
 {
-    Trimesh tmp_m = m;
-    vec3d   axis;
-    double  angle;
+    double deltas[3];
+    rotated_bbox_deltas(m, build_dir, deltas);
+    return deltas[2];
+}
+
+// Normals of the rotated mesh (R * n) are dotted with build_dir, which is
+// the same as dotting the original normals with R^T * build_dir
+//
+CAX_INLINE
+vec3d cusp_height_dir(const vec3d & build_dir)
+{
+    vec3d  axis;
+    double angle;
+    double R[3][3];
     define_rotation(build_dir, axis, angle);
-    tmp_m.rotate(axis, angle);
-    return tmp_m.bbox().delta_z();
+    bake_rotation_matrix(axis, angle, R);
+
+    return vec3d(R[0][0] * build_dir.x() + R[1][0] * build_dir.y() + R[2][0] * build_dir.z(),
+                 R[0][1] * build_dir.x() + R[1][1] * build_dir.y() + R[2][1] * build_dir.z(),
+                 R[0][2] * build_dir.x() + R[1][2] * build_dir.y() + R[2][2] * build_dir.z());
 }
 
 CAX_INLINE
 double cusp_height_error(const Trimesh & m, const vec3d & build_dir)
 {
-    Trimesh tmp_m = m;
-    vec3d   axis;
-    double  angle;
-    define_rotation(build_dir, axis, angle);
-    tmp_m.rotate(axis, angle);
+    vec3d w = cusp_height_dir(build_dir);
 
     double M   = 0.0;
     double ch  = 0.0;
-    for(uint tid=0; tid<tmp_m.num_triangles(); ++tid)
+    for(int tid=0; tid<m.num_triangles(); ++tid)
     {
-        vec3d  n = tmp_m.triangle_normal(tid);
-        double m = tmp_m.element_mass(tid);
-        ch += m * (n.dot(build_dir));
-        M += m;
+        vec3d  n    = m.triangle_normal(tid);
+        double mass = m.element_mass(tid);
+        ch += mass * (n.dot(w));
+        M  += mass;
     }
     ch/=M;
     return ch;
 }
 
+// Score of a candidate build direction. Directions for which the part does
+// not fit the printing chamber are not scored (obj is FLT_MAX)
+//
+typedef struct
+{
+    vec3d  build_dir;
+    bool   fits_chamber;
+    bool   exact;        // false if sup_area (hence obj) is estimated from the normal histogram
+    double sup_area;     // overhang area over total area  (\in [0,1])
+    double cusp_height;  // see cusp_height_error()        (\in [0,1])
+    double height;       // see rotated_bbox_delta_z()     (NOT IN [0,1]!)
+    double sup_volume;   // see evaluate_support_volume()  (\in [0,1], 0 unless scored by it)
+    double obj;          // weighted sum of the above
+}
+OrientationScore;
+
+// Add the support volume (see estimate_supports(), with the given pixel size)
+// weighted by WGT_SUP_VOLUME to the obj of the directions in SCORES that fit
+// the chamber. The volume is divided by the total area of M times the
+// diagonal of its bbox: overhangs project onto at most the total area, and no
+// support is taller than the diagonal, so that it is in [0,1] as the other
+// metrics, whatever the size of the part, and the same scale is used for all
+// directions. Directions are evaluated in parallel, one per thread: each
+// costs a rasterization of the mesh, hence it is meant for the few tens or
+// hundreds of candidates scored by orient()
+//
+CAX_INLINE
+void evaluate_support_volume(const Trimesh                 & m,
+                             const double                    wgt_sup_volume,
+                             const double                    angle_thresh_deg,
+                             const double                    pixel,
+                             std::vector<OrientationScore> & scores)
+{
+    timer_start("Evaluate support volumes");
+
+    // lazy relations cannot be built from multiple threads
+    //
+    m.require(Trimesh::T_NORMALS);
+
+    double tot_area = parallel_sum(0, m.num_triangles(), [&](const int tid)
+    {
+        return m.element_mass(tid);
+    });
+    double scale = tot_area * m.bbox().diag();
+
+    parallel_for(0, scores.size(), [&](const int i)
+    {
+        OrientationScore & s = scores[i];
+        if (!s.fits_chamber) return;
+
+        vec3d  axis;
+        double angle;
+        double R[3][3];
+        define_rotation(s.build_dir, axis, angle);
+        bake_rotation_matrix(axis, angle, R);
+
+        SupportEstimate est;
+        estimate_supports(m, R, angle_thresh_deg, pixel, est);
+
+        s.sup_volume = (scale > 0.0) ? est.volume / scale : 0.0;
+        s.obj       += wgt_sup_volume * s.sup_volume;
+    });
+
+    timer_stop("Evaluate support volumes");
+}
+
+// Score all the directions in DIRS (see orient() for the metrics). Directions
+// are evaluated in parallel, one chunk per core, and the mesh is never copied
+// nor rotated. Each direction costs a sweep over the vertices of the convex
+// hull (bbox) and one over the bins of the normal histogram H: the cusp height
+// is exact, while the overhang area is estimated and bounded. Then, only the
+// directions whose lower bound may beat the best upper bound are refined with
+// the exact overhang area, that visits the triangles of the bins straddling the
+// threshold. If WGT_SUP_VOLUME is positive, the support volume (see
+// evaluate_support_volume(), on a raster of 256 pixels along the longest bbox
+// side) is added to the obj of all the directions that fit the chamber, and to
+// their bounds, before pruning. The direction with the lowest obj is
+// therefore always exact
+//
+CAX_INLINE
+void evaluate_orientations(const Trimesh                   & m,
+                           const NormalHistogram           & h,
+                           const std::vector<vec3d>        & dirs,
+                           const double                      wgt_srf_quality,
+                           const double                      wgt_print_time,
+                           const double                      wgt_supports,
+                           const double                      angle_thresh_deg,
+                           std::vector<OrientationScore>   & scores,
+                           const double                      wgt_sup_volume = 0.0)
+{
+    scores.clear();
+    if (dirs.empty()) return;
+
+    timer_start("Evaluate build orientations");
+
+    // lazy relations cannot be built from multiple threads
+    //
+    m.require(Trimesh::CONVEX_HULL);
+
+    OverhangThresh thresh;
+    overhang_thresh(h, angle_thresh_deg, thresh);
+
+    const double * chamber = m.global_annotations().printer.chamber_dimension;
+
+    scores.resize(dirs.size());
+
+    std::vector<double> obj_lo(dirs.size(), FLT_MAX);
+    std::vector<double> obj_hi(dirs.size(), FLT_MAX);
+
+    parallel_for(0, dirs.size(), [&](const int i)
+    {
+        OrientationScore & s = scores[i];
+
+        s.build_dir = dirs[i];
+        s.build_dir.normalize();
+
+        double deltas[3];
+        rotated_bbox_deltas(m, s.build_dir, deltas);
+
+        s.fits_chamber = (deltas[0] <= chamber[0] && deltas[1] <= chamber[1] && deltas[2] <= chamber[2]);
+        s.exact        = false;
+        s.height       = deltas[2];
+        s.sup_area     = 0.0;
+        s.sup_volume   = 0.0;
+        s.cusp_height  = 0.0;
+        s.obj          = FLT_MAX;
+
+        if (!s.fits_chamber) return;
+
+        double lo, hi, estimate;
+        overhang_area_bounds(h, thresh, s.build_dir, lo, hi, estimate);
+
+        s.cusp_height = h.area_normal.dot(cusp_height_dir(s.build_dir)) / h.tot_area;
+        s.sup_area    = estimate / h.tot_area;
+
+        double base = wgt_srf_quality * s.cusp_height +
+                      wgt_print_time  * s.height;
+
+        s.obj     = base + wgt_supports * s.sup_area;
+        obj_lo[i] = base + std::min(wgt_supports * lo, wgt_supports * hi) / h.tot_area;
+        obj_hi[i] = base + std::max(wgt_supports * lo, wgt_supports * hi) / h.tot_area;
+    });
+
+    // the bounds must cover the whole obj, support volume included
+    //
+    if (wgt_sup_volume > 0.0)
+    {
+        double pixel = std::max(m.bbox().delta_x(), std::max(m.bbox().delta_y(), m.bbox().delta_z())) / 256.0;
+        evaluate_support_volume(m, wgt_sup_volume, angle_thresh_deg, pixel, scores);
+
+        for(size_t i=0; i<dirs.size(); ++i)
+        {
+            if (!scores[i].fits_chamber) continue;
+            obj_lo[i] += wgt_sup_volume * scores[i].sup_volume;
+            obj_hi[i] += wgt_sup_volume * scores[i].sup_volume;
+        }
+    }
+
+    double cutoff = *std::min_element(obj_hi.begin(), obj_hi.end());
+
+    std::vector<int> refine;
+    for(size_t i=0; i<dirs.size(); ++i)
+    {
+        if (scores[i].fits_chamber && obj_lo[i] <= cutoff) refine.push_back(i);
+    }
+
+    parallel_for(0, refine.size(), [&](const int i)
+    {
+        OrientationScore & s = scores[refine[i]];
+
+        s.exact    = true;
+        s.sup_area = overhang_area(h, thresh, s.build_dir) / h.tot_area;
+        s.obj      = wgt_srf_quality * s.cusp_height +
+                     wgt_print_time  * s.height      +
+                     wgt_supports    * s.sup_area    +
+                     wgt_sup_volume  * s.sup_volume;
+    });
+
+    logger << refine.size() << " of " << dirs.size() << " build dirs refined with the exact overhang area" << endl;
+
+    timer_stop("Evaluate build orientations");
+}
+
+CAX_INLINE
+void evaluate_orientations(const Trimesh                   & m,
+                           const std::vector<vec3d>        & dirs,
+                           const double                      wgt_srf_quality,
+                           const double                      wgt_print_time,
+                           const double                      wgt_supports,
+                           const double                      angle_thresh_deg,
+                           std::vector<OrientationScore>   & scores,
+                           const double                      wgt_sup_volume = 0.0)
+{
+    NormalHistogram h;
+    build_normal_histogram(m, 16, h);
+    evaluate_orientations(m, h, dirs, wgt_srf_quality, wgt_print_time, wgt_supports, angle_thresh_deg, scores, wgt_sup_volume);
+}
+
+// Mark the overhangs of M for BUILD_DIR, and store the rotation that brings
+// BUILD_DIR onto the z axis in its global annotations
+//
+CAX_INLINE
+void set_build_orientation(Trimesh & m, const vec3d & build_dir, const double angle_thresh_deg)
+{
+    // overhangs are listed only for the selected direction
+    //
+    std::vector<int> supports;
+    bool log = logger.is_enabled();
+    logger.disable();
+    m.get_overhangs(build_dir, angle_thresh_deg, supports);
+    if (log) logger.enable();
+
+    for(int tid : supports)
+    {
+        m.set_overhangs(tid, true);
+    }
+
+    vec3d  axis;
+    double angle;
+    define_rotation(build_dir, axis, angle);
+    //m.rotate(axis, angle); NO! (april 6th, 2017)
+
+    double R[3][3];
+    bake_rotation_matrix(axis, angle, R);
+    // orrible - to be changed
+    for(int i=0; i<3; ++i)
+    for(int j=0; j<3; ++j)
+    {
+        m.global_annotations().orientation[3*i+j] = R[i][j];
+    }
+
+    logger << "Selected Build Orientation: " << build_dir << newl;
+    logger << "Rotation Matrix: "            << newl;
+    logger << R[0][0] << "\t" << R[0][1] << "\t" << R[0][2] << newl;
+    logger << R[1][0] << "\t" << R[1][1] << "\t" << R[1][2] << newl;
+    logger << R[2][0] << "\t" << R[2][1] << "\t" << R[2][2] << newl << flush;
+}
+
 /* Choose the best orientation according to three metrics (or any combination of them).
  * Metrics are:
  *
@@ -79,7 +352,11 @@ double cusp_height_error(const Trimesh & m, const vec3d & build_dir)
  *
  * The influence of these metrics is defined by three scalars (wgt_srf_quality, wgt_print_time, wgt_supports).
  * This function minimizes a functional defined as the weighted sum of these three components. Weigths must
- * sum up to 1.
+ * sum up to 1. If wgt_sup_volume is positive, the (normalized) volume of the supports (see
+ * evaluate_support_volume()) is added to the functional as well (see evaluate_orientations()).
+ *
+ * Candidate directions are n_dirs points evenly spread on the sphere (see sphere_coverage(), and seed
+ * to make them reproducible). See orient_adaptive() for a finer search at a fraction of the cost.
 */
 CAX_INLINE
 bool orient(Trimesh       & m,
@@ -87,78 +364,190 @@ bool orient(Trimesh       & m,
             const double    wgt_print_time = 0.0,
             const double    wgt_supports = 1.0,
             const double    angle_thresh_deg = 30.0,
-            const int       n_dirs = 100)
+            const int       n_dirs = 100,
+            std::vector<OrientationScore> * scores = NULL, // if not NULL, the score of each direction
+            const int       seed = -1,
+            const double    wgt_sup_volume = 0.0)
 {
     std::vector<vec3d> dir_pool;
-    sphere_coverage(n_dirs, dir_pool);
+    sphere_coverage(n_dirs, dir_pool, seed);
 
-    double           best_obj = FLT_MAX; //weighted sum of cusp height,
-    vec3d            best_dir;
-    std::vector<int> best_supports;
+    std::vector<OrientationScore> tmp_scores;
+    std::vector<OrientationScore> & all_scores = (scores != NULL) ? *scores : tmp_scores;
+    evaluate_orientations(m, dir_pool, wgt_srf_quality, wgt_print_time, wgt_supports, angle_thresh_deg, all_scores, wgt_sup_volume);
 
-    logger.disable();
+    double best_obj = FLT_MAX; //weighted sum of cusp height,
+    vec3d  best_dir;
+    int    n_skipped = 0;
 
-    for(vec3d build_dir : dir_pool)
+    for(const OrientationScore & s : all_scores)
     {
-        if (rotated_bbox_exceeds_chamber_size(m, build_dir))
+        if (!s.fits_chamber)
         {
-            logger << "Skip build dir " << build_dir << " because the part would not fit the printing chamber" << endl;
+            ++n_skipped;
             continue;
         }
+        if (s.obj < best_obj)
+        {
+            best_obj = s.obj;
+            best_dir = s.build_dir;
+        }
+    }
 
-        build_dir.normalize();
+    logger << n_skipped << " build dirs skipped because the part would not fit the printing chamber" << endl;
 
-        std::vector<int> overhangs;
-        double sup_area    = m.get_overhangs(build_dir, angle_thresh_deg, overhangs); // \in [0,1]
-        double cusp_height = cusp_height_error(m, build_dir);                         // \in [0,1]
-        double height      = rotated_bbox_delta_z(m, build_dir);                      // NOT IN [0,1]!!!!!!!
+    if (best_obj == FLT_MAX)
+    {
+        m.global_annotations().no_legal_orientation = true;
+        logger << "The part cannot be oriented so as to fit the printing chamber!" << endl;
+        return false;
+    }
 
-        double obj = wgt_srf_quality * cusp_height +
-                     wgt_print_time  * height      +
-                     wgt_supports    * sup_area;
+    set_build_orientation(m, best_dir, angle_thresh_deg);
+    return true;
+}
+
+// Local search on the sphere starting from BEST (which must be exactly scored,
+// see evaluate_orientations()). At each step, two staggered rings of eight
+// directions each, at angular distance STEP and STEP/2 around the current one,
+// are scored: the search moves to the best of them if it improves, otherwise
+// it halves the step, until the step gets below MIN_STEP (radians). Every
+// scored direction is appended to SCORES
+//
+CAX_INLINE
+void refine_orientation(const Trimesh                 & m,
+                        const NormalHistogram         & h,
+                        const double                    wgt_srf_quality,
+                        const double                    wgt_print_time,
+                        const double                    wgt_supports,
+                        const double                    angle_thresh_deg,
+                        double                          step,
+                        const double                    min_step,
+                        OrientationScore              & best,
+                        std::vector<OrientationScore> & scores)
+{
+    while (step >= min_step)
+    {
+        // tangent frame at the current direction
+        //
+        const vec3d & d = best.build_dir;
+        vec3d u = d.cross((fabs(d.x()) < 0.9) ? vec3d(1,0,0) : vec3d(0,1,0)); u.normalize();
+        vec3d v = d.cross(u);
 
-        if (obj < best_obj)
+        std::vector<vec3d> dirs;
+        for(int k=0; k<8; ++k)
         {
-            best_obj      = obj;
-            best_dir      = build_dir;
-            best_supports = overhangs;
+            vec3d t = u * cos(k * M_PI/4.0) + v * sin(k * M_PI/4.0);
+            dirs.push_back(d * cos(step) + t * sin(step));
+            t = u * cos((k+0.5) * M_PI/4.0) + v * sin((k+0.5) * M_PI/4.0);
+            dirs.push_back(d * cos(0.5*step) + t * sin(0.5*step));
         }
+
+        std::vector<OrientationScore> ring;
+        evaluate_orientations(m, h, dirs, wgt_srf_quality, wgt_print_time, wgt_supports, angle_thresh_deg, ring);
+        scores.insert(scores.end(), ring.begin(), ring.end());
+
+        // the lowest obj of a batch is always exact
+        //
+        int k_best = 0;
+        for(size_t k=1; k<ring.size(); ++k) if (ring[k].obj < ring[k_best].obj) k_best = k;
+
+        if (ring[k_best].obj < best.obj) best = ring[k_best];
+        else step *= 0.5;
     }
+}
 
-    if (best_obj == FLT_MAX)
+/* Same as orient(), but with a coarse to fine search. The n_coarse directions spread on the sphere
+ * (see sphere_coverage() for the seed) are scored first, then the best n_basins among them that are
+ * far apart from each other are locally refined (see refine_orientation()), until the angular
+ * accuracy gets below accuracy_deg. The search starts with a step of half the spacing of the
+ * coarse directions, so a few hundreds evaluations reach an accuracy that uniform sampling would
+ * pay with tens of thousands of directions.
+*/
+CAX_INLINE
+bool orient_adaptive(Trimesh       & m,
+                     const double    wgt_srf_quality = 0.0,
+                     const double    wgt_print_time = 0.0,
+                     const double    wgt_supports = 1.0,
+                     const double    angle_thresh_deg = 30.0,
+                     const int       n_coarse = 100,
+                     const int       n_basins = 4,
+                     const double    accuracy_deg = 0.5,
+                     std::vector<OrientationScore> * scores = NULL, // if not NULL, the score of each direction
+                     const int       seed = -1)
+{
+    NormalHistogram h;
+    build_normal_histogram(m, 16, h);
+
+    std::vector<vec3d> dir_pool;
+    sphere_coverage(n_coarse, dir_pool, seed);
+
+    std::vector<OrientationScore> tmp_scores;
+    std::vector<OrientationScore> & all_scores = (scores != NULL) ? *scores : tmp_scores;
+    evaluate_orientations(m, h, dir_pool, wgt_srf_quality, wgt_print_time, wgt_supports, angle_thresh_deg, all_scores);
+
+    // angular spacing of the coarse directions (each covers 4pi/n_coarse)
+    //
+    double spacing = sqrt(4.0 * M_PI / n_coarse);
+
+    std::vector<int> order;
+    for(size_t i=0; i<all_scores.size(); ++i) if (all_scores[i].fits_chamber) order.push_back(i);
+    std::sort(order.begin(), order.end(), [&](const int a, const int b)
+    {
+        return all_scores[a].obj < all_scores[b].obj;
+    });
+
+    logger << all_scores.size() - order.size() << " build dirs skipped because the part would not fit the printing chamber" << endl;
+
+    if (order.empty())
     {
         m.global_annotations().no_legal_orientation = true;
         logger << "The part cannot be oriented so as to fit the printing chamber!" << endl;
         return false;
     }
 
-    logger.enable();
-
-    for(int tid : best_supports)
+    // seeds of the local searches: the best directions, at least two coarse
+    // spacings apart from each other
+    //
+    std::vector<OrientationScore> basins;
+    for(int i : order)
     {
-        m.set_overhangs(tid, true);
+        if ((int)basins.size() >= n_basins) break;
+
+        bool far = true;
+        for(const OrientationScore & b : basins)
+        {
+            if (b.build_dir.dot(all_scores[i].build_dir) > cos(2.0 * spacing)) far = false;
+        }
+        if (far) basins.push_back(all_scores[i]);
     }
 
-    vec3d  axis;
-    double angle;
-    define_rotation(best_dir, axis, angle);
-    //m.rotate(axis, angle); NO! (april 6th, 2017)
+    OrientationScore best;
+    best.obj = FLT_MAX;
 
-    double R[3][3];
-    bake_rotation_matrix(axis, angle, R);
-    // orrible - to be changed
-    for(int i=0; i<3; ++i)
-    for(int j=0; j<3; ++j)
+    bool log = logger.is_enabled();
+    logger.disable();
+    for(OrientationScore & b : basins)
     {
-        m.global_annotations().orientation[3*i+j] = R[i][j];
+        // the seed must be exactly scored
+        //
+        if (!b.exact)
+        {
+            std::vector<OrientationScore> tmp;
+            evaluate_orientations(m, h, std::vector<vec3d>(1, b.build_dir), wgt_srf_quality, wgt_print_time, wgt_supports, angle_thresh_deg, tmp);
+            b = tmp.front();
+        }
+
+        refine_orientation(m, h, wgt_srf_quality, wgt_print_time, wgt_supports, angle_thresh_deg,
+                           0.5 * spacing, accuracy_deg * M_PI / 180.0, b, all_scores);
+
+        if (b.obj < best.obj) best = b;
     }
+    if (log) logger.enable();
 
-    logger << "Selected Build Orientation: " << best_dir << newl;
-    logger << "Rotation Matrix: "            << newl;
-    logger << R[0][0] << "\t" << R[0][1] << "\t" << R[0][2] << newl;
-    logger << R[1][0] << "\t" << R[1][1] << "\t" << R[1][2] << newl;
-    logger << R[2][0] << "\t" << R[2][1] << "\t" << R[2][2] << newl << flush;
+    logger << all_scores.size() << " build dirs evaluated (" << basins.size() << " basins refined)" << endl;
 
+    set_build_orientation(m, best.build_dir, angle_thresh_deg);
     return true;
 }
 
@@ -8,16 +8,32 @@
 
 #include "../caxlib.h"
 #include "../trimesh/trimesh.h"
+#include "../adjacency_list.h"
 #include "../intersection.h"
+#include "../parallel.h"
 #include "../vec2.h"
 #include "../intersection.h"
 #include "../triangle.h"
 
+#include <cmath>
+
 
 namespace caxlib
 {
 
 typedef std::pair<vec2d,vec2d> seg2d;
+
+// directions of the support lines generated by rasterize_support_lines()
+//
+enum
+{
+    SUPPORTS_X  = 0x01, // lines at constant X (i.e. running along Y)
+    SUPPORTS_Y  = 0x02, // lines at constant Y (i.e. running along X)
+    SUPPORTS_XY = SUPPORTS_X | SUPPORTS_Y
+};
+
+static const int SUPPORT_MAX_LINES = 4096; // support lines per direction, at most
+
 typedef struct
 {
     int tid;                      // triangle containing the segment
@@ -38,20 +54,81 @@ typedef struct
     double ground_area_ratio = 0.0; // ratio between cumulative support area and total overhang area (P in Jaiko's email)
     double lifted_area_ratio = 0.0; // ratio between cumulative support area and total overhang area (p in Jaiko's email)
     double vertex_area       = 0.0; // (V in Jaiko's email)
-    double support_height    = 0.0; // (D in Jaiko's email)
+    double support_height    = 0.0; // overhang vertices: down to where the support lands, others: z in the build frame (D in Jaiko's email)
 }
 VertexCumulativeSupportData;
 
+typedef struct
+{
+    double overhang_area = 0.0; // area of the overhangs, projected on the build plate
+    double contact_area  = 0.0; // projected area where supports land on the part (not on the plate)
+    double volume        = 0.0; // volume of the supports (see estimate_supports())
+}
+SupportEstimate;
+
+// Uniform grid over the xy bounding box of a mesh. Cell (i,j) lists the
+// triangles whose xy bounding box overlaps it, so that a segment only
+// visits the triangles of the cells it crosses
+//
+typedef struct
+{
+    vec2d         origin;
+    double        cell;   // side of the (square) cells
+    int           nx, ny;
+    AdjacencyList cells;  // row j*nx+i: ids of the triangles in cell (i,j)
+}
+TriangleGrid2D;
+
+// Height field of the upward facing surfaces of a mesh, as seen from above
+// (the build direction). Each pixel stores the sorted heights of all the
+// surfaces over its center, so that supports can land on the part instead of
+// on the floor. Pixels are grouped in square tiles, which are rasterized
+// independently
+//
+static const int HEIGHT_FIELD_TILE       = 64;   // pixels per tile side
+static const int HEIGHT_FIELD_MAX_PIXELS = 4096; // pixels per bbox side, at most
+
+typedef struct
+{
+    std::vector<int>    offset; // heights of (tile local) pixel p are z[offset[p]] ... z[offset[p+1]-1]
+    std::vector<double> z;
+}
+HeightFieldTile;
+
+typedef struct
+{
+    vec2d  origin;
+    double pixel;            // side of the (square) pixels
+    int    nx, ny;           // pixels
+    int    tiles_x, tiles_y; // tiles
+    std::vector<HeightFieldTile> tiles;
+}
+HeightField;
+
+CAX_INLINE void height_field_pixels(const HeightField &, const vec3d &, const vec3d &, const vec3d &, int &, int &, int &, int &);
+CAX_INLINE void build_height_field(const Trimesh &, const std::vector<vec3d> &, const double, HeightField &);
+CAX_INLINE void build_height_field(const Trimesh &, const double, HeightField &);
+CAX_INLINE double landing_height(const HeightField &, const double, const double, const double, const double);
+CAX_INLINE void estimate_supports(const Trimesh &, const double [3][3], const double, const double, SupportEstimate &, std::vector<VertexCumulativeSupportData> * = NULL);
+CAX_INLINE void build_triangle_grid(const Trimesh &, TriangleGrid2D &);
+CAX_INLINE void triangle_grid_candidates(const TriangleGrid2D &, const seg2d &, std::vector<int> &);
 CAX_INLINE void project_overhangs(const std::vector<int> &, const float, Trimesh &, Trimesh &);
 CAX_INLINE void draw_2d_support_lines(const Trimesh &, const int, std::vector<seg2d> &);
 CAX_INLINE void split_2d_support_lines(const Trimesh &, const std::vector<seg2d> &, const double, std::vector<tri_seg_inters> &);
-CAX_INLINE void extrude_supports(const std::vector<tri_seg_inters> &, const Trimesh &, const Trimesh &, const std::vector<int> &, const double, std::vector<VertexCumulativeSupportData> &, Trimesh &);
+CAX_INLINE void rasterize_support_lines(const Trimesh &, const double, const int, std::vector<tri_seg_inters> &);
+CAX_INLINE void extrude_supports(const std::vector<tri_seg_inters> &, const Trimesh &, const Trimesh &, const HeightField &, const double, const std::vector<int> &, const double, std::vector<VertexCumulativeSupportData> &, Trimesh &);
 
 
+// Supports are laid on a cross-hatched grid with the given pitch. If pitch is
+// not positive (or not finite), the laser beam diameter of the printer is used
+// and, if the printer is not known either, 20 lines per direction across the
+// bbox
+//
 CAX_INLINE
 void create_support_structures(Trimesh & m,
                                const double thickness,
-                               std::vector<VertexCumulativeSupportData> & per_vertex_supports_data)
+                               std::vector<VertexCumulativeSupportData> & per_vertex_supports_data,
+                               const double pitch = 0.0)
 {
     // ROTATE MESH ACCORDING TO BEST ORIENTATION (ANNOTATIONS)
     double R[3][3];
@@ -70,14 +147,20 @@ void create_support_structures(Trimesh & m,
     Trimesh m_overhangs; // trimesh created projecting overhang triangles to the floor
     project_overhangs(overhang_tids, z_floor, m, m_overhangs);
 
-    std::vector<seg2d> supp_lines;
-    draw_2d_support_lines(m, 20, supp_lines);
+    auto valid_pitch = [](const double p) { return std::isfinite(p) && p > 0.0; };
+
+    double grid_pitch = pitch;
+    if (!valid_pitch(grid_pitch)) grid_pitch = m.global_annotations().printer.laser_beam_diameter;
+    if (!valid_pitch(grid_pitch)) grid_pitch = std::max(m.bbox().delta_x(), m.bbox().delta_y()) / 20.0;
 
     std::vector<tri_seg_inters> supp_segments;
-    split_2d_support_lines(m_overhangs, supp_lines, z_floor, supp_segments);
+    rasterize_support_lines(m_overhangs, grid_pitch, SUPPORTS_XY, supp_segments);
+
+    HeightField landing;
+    build_height_field(m, grid_pitch * 0.5, landing);
 
     Trimesh m_supports;
-    extrude_supports(supp_segments, m, m_overhangs, overhang_tids, thickness, per_vertex_supports_data, m_supports);
+    extrude_supports(supp_segments, m, m_overhangs, landing, z_floor, overhang_tids, thickness, per_vertex_supports_data, m_supports);
 
     m += m_supports;
 
@@ -139,22 +222,156 @@ void draw_2d_support_lines(const Trimesh            & m,
 
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
+CAX_INLINE
+void build_triangle_grid(const Trimesh & m, TriangleGrid2D & g)
+{
+    int n_tris = m.num_triangles();
+
+    vec2d min( DBL_MAX,  DBL_MAX);
+    vec2d max(-DBL_MAX, -DBL_MAX);
+    for(int vid=0; vid<m.num_vertices(); ++vid)
+    {
+        vec3d p = m.vertex(vid);
+        min = vec2d(std::min(min.x(), p.x()), std::min(min.y(), p.y()));
+        max = vec2d(std::max(max.x(), p.x()), std::max(max.y(), p.y()));
+    }
+    if (m.num_vertices() == 0) min = max = vec2d(0,0);
+
+    // about one cell per triangle
+    //
+    double w = max.x() - min.x();
+    double h = max.y() - min.y();
+    double a = w * h;
+
+    g.origin = min;
+    g.cell   = (a > 0) ? sqrt(a / std::max(1, n_tris)) : std::max(std::max(w, h) / std::max(1, n_tris), 1.0);
+    g.nx     = std::min(4096, (int)(w / g.cell) + 1);
+    g.ny     = std::min(4096, (int)(h / g.cell) + 1);
+    g.cell   = std::max(g.cell, std::max(w / g.nx, h / g.ny) * (1.0 + 1e-12));
+
+    auto cell_range = [&g](const double min, const double max, const double o, const int n, int & beg, int & end)
+    {
+        beg = std::max(0, std::min(n-1, (int)floor((min - o) / g.cell)));
+        end = std::max(0, std::min(n-1, (int)floor((max - o) / g.cell)));
+    };
+
+    // two passes (count, then insert), as AdjacencyList wants
+    //
+    g.cells.reset(g.nx * g.ny);
+    for(int pass=0; pass<2; ++pass)
+    {
+        for(int tid=0; tid<n_tris; ++tid)
+        {
+            vec3d p0 = m.triangle_vertex(tid,0);
+            vec3d p1 = m.triangle_vertex(tid,1);
+            vec3d p2 = m.triangle_vertex(tid,2);
+
+            int i0, i1, j0, j1;
+            cell_range(std::min(p0.x(), std::min(p1.x(), p2.x())), std::max(p0.x(), std::max(p1.x(), p2.x())), g.origin.x(), g.nx, i0, i1);
+            cell_range(std::min(p0.y(), std::min(p1.y(), p2.y())), std::max(p0.y(), std::max(p1.y(), p2.y())), g.origin.y(), g.ny, j0, j1);
+
+            for(int j=j0; j<=j1; ++j)
+            for(int i=i0; i<=i1; ++i)
+            {
+                if (pass == 0) g.cells.count (j * g.nx + i);
+                else           g.cells.insert(j * g.nx + i, tid);
+            }
+        }
+        if (pass == 0) g.cells.alloc();
+    }
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// ids (sorted, without duplicates) of the triangles in the cells crossed by S.
+// Ranges are slightly enlarged, so that intersections computed with a
+// different rounding are never missed
+//
+CAX_INLINE
+void triangle_grid_candidates(const TriangleGrid2D & g, const seg2d & s, std::vector<int> & tids)
+{
+    tids.clear();
+
+    const vec2d & p = (s.first.x() <= s.second.x()) ? s.first  : s.second;
+    const vec2d & q = (s.first.x() <= s.second.x()) ? s.second : s.first;
+    const double  eps = 1e-9 * g.cell;
+
+    auto cell = [&g](const double v, const double o, const int n)
+    {
+        return std::max(0, std::min(n-1, (int)floor((v - o) / g.cell)));
+    };
+
+    int i0 = cell(p.x() - eps, g.origin.x(), g.nx);
+    int i1 = cell(q.x() + eps, g.origin.x(), g.nx);
+
+    for(int i=i0; i<=i1; ++i)
+    {
+        // part of the segment within column i
+        //
+        double xa = std::max(p.x(), std::min(q.x(), g.origin.x() +  i      * g.cell));
+        double xb = std::max(p.x(), std::min(q.x(), g.origin.x() + (i + 1) * g.cell));
+        double ya = p.y();
+        double yb = q.y();
+        if (q.x() > p.x())
+        {
+            double t = (q.y() - p.y()) / (q.x() - p.x());
+            ya = p.y() + t * (xa - p.x());
+            yb = p.y() + t * (xb - p.x());
+        }
+
+        int j0 = cell(std::min(ya, yb) - eps, g.origin.y(), g.ny);
+        int j1 = cell(std::max(ya, yb) + eps, g.origin.y(), g.ny);
+
+        for(int j=j0; j<=j1; ++j)
+        {
+            for(int tid : g.cells.row(j * g.nx + i)) tids.push_back(tid);
+        }
+    }
+
+    std::sort(tids.begin(), tids.end());
+    tids.erase(std::unique(tids.begin(), tids.end()), tids.end());
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// Each line only visits the triangles of the grid cells it crosses, and lines
+// are processed in parallel. Segments come in the same order as testing every
+// line against every triangle would give (by line, then by triangle)
+//
 CAX_INLINE
 void split_2d_support_lines(const Trimesh                     & m_overhangs,
                             const std::vector<seg2d>          & supp_lines,
                             const double                        z_floor,
                                   std::vector<tri_seg_inters> & supp_segments)
 {
-    for(seg2d s : supp_lines)
+    TriangleGrid2D grid;
+    build_triangle_grid(m_overhangs, grid);
+
+    std::vector< std::vector<tri_seg_inters> > per_line(supp_lines.size());
+
+    parallel_for(0, supp_lines.size(), [&](const int lid)
     {
-        for(int tid=0; tid<m_overhangs.num_triangles(); ++tid)
+        const seg2d & s = supp_lines.at(lid);
+
+        std::vector<int> tids;
+        triangle_grid_candidates(grid, s, tids);
+
+        std::vector< std::vector<double> > inters; // useful if the line passes through a segment
+
+        for(int tid : tids)
         {
-            std::set< std::vector<double> > unique_inters; // useful if the line passes through a segment
+            vec3d v[3] =
+            {
+                m_overhangs.triangle_vertex(tid,0),
+                m_overhangs.triangle_vertex(tid,1),
+                m_overhangs.triangle_vertex(tid,2)
+            };
 
+            inters.clear();
             for(int i=0; i<3; ++i)
             {
-                vec3d beg = m_overhangs.triangle_vertex(tid, TRI_EDGES[i][0]);
-                vec3d end = m_overhangs.triangle_vertex(tid, TRI_EDGES[i][1]);
+                const vec3d & beg = v[TRI_EDGES[i][0]];
+                const vec3d & end = v[TRI_EDGES[i][1]];
 
                 std::vector<vec2d> res;
                 if (segment2D_intersection(s.first, s.second, vec2d(beg.x(), beg.y()), vec2d(end.x(), end.y()), res))
@@ -162,35 +379,469 @@ void split_2d_support_lines(const Trimesh                     & m_overhangs,
                     for(vec2d p : res)
                     {
                         std::vector<double> bary;
-                        bool check = triangle_barycentric_coords(m_overhangs.triangle_vertex(tid,0),
-                                                                 m_overhangs.triangle_vertex(tid,1),
-                                                                 m_overhangs.triangle_vertex(tid,2),
-                                                                 vec3d(p.x(), p.y(), z_floor),
-                                                                 bary);
+                        bool check = triangle_barycentric_coords(v[0], v[1], v[2], vec3d(p.x(), p.y(), z_floor), bary);
                         assert(check);
-                        unique_inters.insert(bary);
+                        inters.push_back(bary);
                     }
                 }
             }
 
-            if (unique_inters.size() == 2)
+            // unique intersections, in the order of a std::set
+            //
+            std::sort(inters.begin(), inters.end());
+            inters.erase(std::unique(inters.begin(), inters.end()), inters.end());
+
+            if (inters.size() == 2)
             {
                 tri_seg_inters tmp;
                 tmp.tid = tid;
-                tmp.bary_beg = *(unique_inters.begin());
-                tmp.bary_end = *(--(unique_inters.end()));
-                supp_segments.push_back(tmp);
+                tmp.bary_beg = inters.front();
+                tmp.bary_end = inters.back();
+                per_line.at(lid).push_back(tmp);
+            }
+        }
+    });
+
+    for(const std::vector<tri_seg_inters> & segs : per_line)
+    {
+        supp_segments.insert(supp_segments.end(), segs.begin(), segs.end());
+    }
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// Scanline rasterization of the (flat) overhang mesh on a grid with the given
+// pitch, anchored at the min corner of its bbox. Each triangle is crossed by
+// the lines within its own extent only, and the endpoints of each piece are
+// interpolated along the edges, so the cost is linear in the number of output
+// segments. A line running exactly along an edge is assigned to the triangle
+// on its positive side only (lines through the max of a triangle are skipped).
+// Segments are sorted by direction (X first) and then by triangle. The pitch
+// is enlarged if needed, so as to have at most SUPPORT_MAX_LINES lines per
+// direction
+//
+CAX_INLINE
+void rasterize_support_lines(const Trimesh                     & m_overhangs,
+                             const double                        pitch,
+                             const int                           directions,
+                                   std::vector<tri_seg_inters> & supp_segments)
+{
+    if (!std::isfinite(pitch) || pitch <= 0.0)
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : rasterize_support_lines() : invalid pitch " << pitch << endl;
+        exit(-1);
+    }
+
+    if (m_overhangs.num_triangles() == 0) return;
+
+    vec3d  origin = m_overhangs.bbox().min;
+    double step   = std::max(pitch, std::max(m_overhangs.bbox().delta_x(), m_overhangs.bbox().delta_y()) / SUPPORT_MAX_LINES);
+
+    // pieces of the lines at coord[a] = origin[a] + k*step that cross tid.
+    // If out is NULL they are only counted
+    //
+    auto scan = [&](const int tid, const int a, tri_seg_inters * out) -> int
+    {
+        int b = 1 - a; // coordinate along the lines
+
+        vec3d v[3] =
+        {
+            m_overhangs.triangle_vertex(tid,0),
+            m_overhangs.triangle_vertex(tid,1),
+            m_overhangs.triangle_vertex(tid,2)
+        };
+
+        double lo = std::min(v[0][a], std::min(v[1][a], v[2][a]));
+        double hi = std::max(v[0][a], std::max(v[1][a], v[2][a]));
+
+        int count = 0;
+        for(int k=(int)ceil((lo - origin[a]) / step); ; ++k)
+        {
+            double c = origin[a] + k * step;
+            if (c <  lo) continue;
+            if (c >= hi) break;
+
+            double min = DBL_MAX, max = -DBL_MAX;
+            int    e_min = 0, e_max = 0;
+            double t_min = 0,  t_max = 0;
+
+            for(int e=0; e<3; ++e)
+            {
+                const vec3d & p = v[TRI_EDGES[e][0]];
+                const vec3d & q = v[TRI_EDGES[e][1]];
+                if (p[a] == q[a]) continue;
+
+                double t = (c - p[a]) / (q[a] - p[a]);
+                if (t < 0.0 || t > 1.0) continue;
+
+                double y = p[b] + t * (q[b] - p[b]);
+                if (y < min) { min = y; e_min = e; t_min = t; }
+                if (y > max) { max = y; e_max = e; t_max = t; }
+            }
+
+            if (max <= min) continue; // the line only touches a vertex
+
+            if (out != NULL)
+            {
+                tri_seg_inters & seg = out[count];
+                seg.tid = tid;
+                seg.bary_beg.assign(3, 0.0);
+                seg.bary_end.assign(3, 0.0);
+                seg.bary_beg.at(TRI_EDGES[e_min][0]) += 1.0 - t_min;
+                seg.bary_beg.at(TRI_EDGES[e_min][1]) += t_min;
+                seg.bary_end.at(TRI_EDGES[e_max][0]) += 1.0 - t_max;
+                seg.bary_end.at(TRI_EDGES[e_max][1]) += t_max;
+            }
+            ++count;
+        }
+        return count;
+    };
+
+    int n_tris = m_overhangs.num_triangles();
+
+    for(int a=0; a<2; ++a)
+    {
+        if (!(directions & (a == 0 ? SUPPORTS_X : SUPPORTS_Y))) continue;
+
+        // count, then fill each triangle's slice of the output in parallel
+        //
+        std::vector<size_t> offset(n_tris + 1, 0);
+        parallel_for(0, n_tris, [&](const int tid)
+        {
+            offset.at(tid+1) = scan(tid, a, NULL);
+        });
+
+        offset.at(0) = supp_segments.size();
+        for(int tid=0; tid<n_tris; ++tid) offset.at(tid+1) += offset.at(tid);
+
+        supp_segments.resize(offset.back());
+        parallel_for(0, n_tris, [&](const int tid)
+        {
+            if (offset.at(tid+1) > offset.at(tid)) scan(tid, a, &supp_segments[offset.at(tid)]);
+        });
+    }
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// Pixels of HF whose centers fall in the xy bounding box of triangle (p0,p1,p2)
+// (empty if beg > end)
+//
+CAX_INLINE
+void height_field_pixels(const HeightField & hf, const vec3d & p0, const vec3d & p1, const vec3d & p2, int & i0, int & i1, int & j0, int & j1)
+{
+    i0 = std::max(0,       (int)ceil ((std::min(p0.x(), std::min(p1.x(), p2.x())) - hf.origin.x()) / hf.pixel - 0.5));
+    i1 = std::min(hf.nx-1, (int)floor((std::max(p0.x(), std::max(p1.x(), p2.x())) - hf.origin.x()) / hf.pixel - 0.5));
+    j0 = std::max(0,       (int)ceil ((std::min(p0.y(), std::min(p1.y(), p2.y())) - hf.origin.y()) / hf.pixel - 0.5));
+    j1 = std::min(hf.ny-1, (int)floor((std::max(p0.y(), std::max(p1.y(), p2.y())) - hf.origin.y()) / hf.pixel - 0.5));
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// Call func(i,j,z) for each pixel in [i0,i1]x[j0,j1] whose center is covered
+// by the xy projection of triangle (p0,p1,p2), with z interpolated at the
+// center. Triangles may face either up or down
+//
+template<typename Func>
+CAX_INLINE
+void rasterize_triangle(const HeightField & hf, const vec3d & p0, const vec3d & p1, const vec3d & p2, const int i0, const int i1, const int j0, const int j1, const Func & func)
+{
+    double area = (p1.x() - p0.x()) * (p2.y() - p0.y()) - (p1.y() - p0.y()) * (p2.x() - p0.x());
+    if (area == 0.0) return;
+
+    for(int j=j0; j<=j1; ++j)
+    for(int i=i0; i<=i1; ++i)
+    {
+        double x = hf.origin.x() + (i + 0.5) * hf.pixel;
+        double y = hf.origin.y() + (j + 0.5) * hf.pixel;
+
+        double w0 = ((p1.x() - x) * (p2.y() - y) - (p1.y() - y) * (p2.x() - x)) / area;
+        double w1 = ((p2.x() - x) * (p0.y() - y) - (p2.y() - y) * (p0.x() - x)) / area;
+        double w2 = 1.0 - w0 - w1;
+        if (w0 < -1e-12 || w1 < -1e-12 || w2 < -1e-12) continue;
+
+        func(i, j, w0 * p0.z() + w1 * p1.z() + w2 * p2.z());
+    }
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// Height field of M with its vertices moved to POS (e.g. rotated), so that
+// candidate build directions can be evaluated without copying the mesh
+//
+CAX_INLINE
+void build_height_field(const Trimesh & m, const std::vector<vec3d> & pos, const double pixel, HeightField & hf)
+{
+    const int T = HEIGHT_FIELD_TILE;
+
+    vec2d min( DBL_MAX,  DBL_MAX);
+    vec2d max(-DBL_MAX, -DBL_MAX);
+    for(const vec3d & p : pos)
+    {
+        min = vec2d(std::min(min.x(), p.x()), std::min(min.y(), p.y()));
+        max = vec2d(std::max(max.x(), p.x()), std::max(max.y(), p.y()));
+    }
+    if (pos.empty()) min = max = vec2d(0,0);
+
+    double w = max.x() - min.x();
+    double h = max.y() - min.y();
+
+    hf.origin  = min;
+    hf.pixel   = std::max(pixel, std::max(w, h) / HEIGHT_FIELD_MAX_PIXELS);
+    if (hf.pixel <= 0.0) hf.pixel = 1.0;
+    hf.nx      = (int)(w / hf.pixel) + 1;
+    hf.ny      = (int)(h / hf.pixel) + 1;
+    hf.tiles_x = (hf.nx + T - 1) / T;
+    hf.tiles_y = (hf.ny + T - 1) / T;
+    hf.tiles.clear();
+    hf.tiles.resize(hf.tiles_x * hf.tiles_y);
+
+    auto vertex = [&](const int tid, const int i) -> const vec3d &
+    {
+        return pos.at(m.triangle_vertex_id(tid,i));
+    };
+
+    auto facing_up = [&](const int tid)
+    {
+        vec3d u = vertex(tid,1) - vertex(tid,0);
+        vec3d v = vertex(tid,2) - vertex(tid,0);
+        return u.x() * v.y() - u.y() * v.x() > 0.0;
+    };
+
+    // bin the upward facing triangles into the tiles they overlap
+    //
+    AdjacencyList bins;
+    bins.reset(hf.tiles_x * hf.tiles_y);
+    for(int pass=0; pass<2; ++pass)
+    {
+        for(int tid=0; tid<m.num_triangles(); ++tid)
+        {
+            if (!facing_up(tid)) continue;
+
+            int i0, i1, j0, j1;
+            height_field_pixels(hf, vertex(tid,0), vertex(tid,1), vertex(tid,2), i0, i1, j0, j1);
+            if (i0 > i1 || j0 > j1) continue; // covers no pixel center
+
+            for(int j=j0/T; j<=j1/T; ++j)
+            for(int i=i0/T; i<=i1/T; ++i)
+            {
+                if (pass == 0) bins.count (j * hf.tiles_x + i);
+                else           bins.insert(j * hf.tiles_x + i, tid);
             }
         }
+        if (pass == 0) bins.alloc();
     }
+
+    // rasterize each tile on its own
+    //
+    parallel_for(0, hf.tiles.size(), [&](const int t)
+    {
+        int ti = t % hf.tiles_x;
+        int tj = t / hf.tiles_x;
+
+        std::vector< std::pair<int,double> > samples; // (tile local pixel, height)
+
+        for(int tid : bins.row(t))
+        {
+            int i0, i1, j0, j1;
+            height_field_pixels(hf, vertex(tid,0), vertex(tid,1), vertex(tid,2), i0, i1, j0, j1);
+            i0 = std::max(i0, ti * T); i1 = std::min(i1, ti * T + T - 1);
+            j0 = std::max(j0, tj * T); j1 = std::min(j1, tj * T + T - 1);
+
+            rasterize_triangle(hf, vertex(tid,0), vertex(tid,1), vertex(tid,2), i0, i1, j0, j1, [&](const int i, const int j, const double z)
+            {
+                samples.push_back(std::make_pair((j - tj * T) * T + (i - ti * T), z));
+            });
+        }
+
+        std::sort(samples.begin(), samples.end());
+
+        HeightFieldTile & tile = hf.tiles.at(t);
+        tile.offset.assign(T * T + 1, 0);
+        tile.z.resize(samples.size());
+        for(size_t k=0; k<samples.size(); ++k)
+        {
+            ++tile.offset.at(samples.at(k).first + 1);
+            tile.z.at(k) = samples.at(k).second;
+        }
+        for(int p=0; p<T*T; ++p) tile.offset.at(p+1) += tile.offset.at(p);
+    });
 }
 
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
+CAX_INLINE
+void build_height_field(const Trimesh & m, const double pixel, HeightField & hf)
+{
+    std::vector<vec3d> pos(m.num_vertices());
+    for(int vid=0; vid<m.num_vertices(); ++vid) pos.at(vid) = m.vertex(vid);
+
+    build_height_field(m, pos, pixel, hf);
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// height at which a support hanging from (x,y,z_top) lands: the highest
+// surface of the part below z_top in the pixel containing (x,y), or the
+// floor if there is none
+//
+CAX_INLINE
+double landing_height(const HeightField & hf, const double x, const double y, const double z_top, const double z_floor)
+{
+    const int T = HEIGHT_FIELD_TILE;
+
+    int i = (int)floor((x - hf.origin.x()) / hf.pixel);
+    int j = (int)floor((y - hf.origin.y()) / hf.pixel);
+    if (i < 0 || i >= hf.nx || j < 0 || j >= hf.ny) return z_floor;
+
+    const HeightFieldTile & tile = hf.tiles.at((j / T) * hf.tiles_x + (i / T));
+    int p = (j % T) * T + (i % T);
+
+    double tol = 1e-3 * hf.pixel; // surfaces this close to z_top touch it
+    for(int k=tile.offset.at(p+1)-1; k>=tile.offset.at(p); --k)
+    {
+        if (tile.z.at(k) < z_top - tol) return std::max(tile.z.at(k), z_floor);
+    }
+    return z_floor;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// Supports needed to build M rotated by R (see set_build_orientation()),
+// estimated on the footprint of the overhangs rasterized with the given pixel
+// size. No geometry is built and the mesh is neither copied nor rotated, so
+// it can be called for each candidate build direction. Supports are solid
+// columns from each overhang pixel down to the part (see landing_height()) or
+// to the build plate, which touches the bottom of the part.
+// If per_vertex_supports_data is not NULL it is filled as in
+// create_support_structures(), with the supported area of the incident
+// triangles (projected, or on the shape) over the total overhang area, and
+// with the support height of the vertices of the overhangs measured from
+// where supports land (the other vertices get their z in the build frame).
+// Supports landing on the plate are shorter here, as
+// create_support_structures() keeps the part 10% of its height above its
+// floor.
+// Lazy relations are not thread safe: require(T_NORMALS | VTX2TRI) before
+// calling it from multiple threads
+//
+CAX_INLINE
+void estimate_supports(const Trimesh                            & m,
+                       const double                               R[3][3],
+                       const double                               angle_thresh_deg,
+                       const double                               pixel,
+                             SupportEstimate                    & est,
+                             std::vector<VertexCumulativeSupportData> * per_vertex_supports_data)
+{
+    est = SupportEstimate();
+
+    std::vector<vec3d> pos(m.num_vertices());
+    double z_floor = DBL_MAX;
+    for(int vid=0; vid<m.num_vertices(); ++vid)
+    {
+        pos.at(vid) = m.vertex(vid);
+        transform(pos.at(vid), R);
+        z_floor = std::min(z_floor, pos.at(vid).z());
+    }
+
+    HeightField hf;
+    build_height_field(m, pos, pixel, hf);
+
+    // same test as Trimesh::get_overhangs()
+    //
+    vec3d build_dir(R[2][0], R[2][1], R[2][2]);
+    std::vector<int> overhang_tids;
+    for(int tid=0; tid<m.num_triangles(); ++tid)
+    {
+        if (acos(m.triangle_normal(tid).dot(build_dir)) * 180.0/M_PI - 90.0 >= angle_thresh_deg) overhang_tids.push_back(tid);
+    }
+
+    std::vector<double> area   (overhang_tids.size(), 0.0);
+    std::vector<double> contact(overhang_tids.size(), 0.0);
+    std::vector<double> volume (overhang_tids.size(), 0.0);
+
+    double px_area = hf.pixel * hf.pixel;
+
+    parallel_for(0, overhang_tids.size(), [&](const int k)
+    {
+        int tid = overhang_tids.at(k);
+        const vec3d & p0 = pos.at(m.triangle_vertex_id(tid,0));
+        const vec3d & p1 = pos.at(m.triangle_vertex_id(tid,1));
+        const vec3d & p2 = pos.at(m.triangle_vertex_id(tid,2));
+
+        int i0, i1, j0, j1;
+        height_field_pixels(hf, p0, p1, p2, i0, i1, j0, j1);
+        rasterize_triangle(hf, p0, p1, p2, i0, i1, j0, j1, [&](const int i, const int j, const double z)
+        {
+            double x      = hf.origin.x() + (i + 0.5) * hf.pixel;
+            double y      = hf.origin.y() + (j + 0.5) * hf.pixel;
+            double z_land = landing_height(hf, x, y, z, z_floor);
+
+            area.at(k)   += px_area;
+            volume.at(k) += px_area * (z - z_land);
+            if (z_land > z_floor) contact.at(k) += px_area;
+        });
+    });
+
+    for(size_t k=0; k<overhang_tids.size(); ++k)
+    {
+        est.overhang_area += area.at(k);
+        est.contact_area  += contact.at(k);
+        est.volume        += volume.at(k);
+    }
+
+    if (per_vertex_supports_data == NULL) return;
+
+    std::vector<TriangleCumulativeSupportData> per_face_supports_data(m.num_triangles());
+    for(size_t k=0; k<overhang_tids.size(); ++k)
+    {
+        int tid = overhang_tids.at(k);
+        per_face_supports_data.at(tid).ground_area = area.at(k);
+        per_face_supports_data.at(tid).lifted_area = area.at(k) / std::max(1e-6, fabs(m.triangle_normal(tid).dot(build_dir)));
+    }
+
+    double tot_area = std::max(est.overhang_area, DBL_MIN);
+
+    std::vector<bool> on_overhang(m.num_vertices(), false);
+    for(int tid : overhang_tids)
+    {
+        for(int i=0; i<3; ++i) on_overhang.at(m.triangle_vertex_id(tid,i)) = true;
+    }
+
+    per_vertex_supports_data->resize(m.num_vertices());
+    for(int vid=0; vid<m.num_vertices(); ++vid)
+    {
+        const vec3d & p = pos.at(vid);
+        VertexCumulativeSupportData & data = per_vertex_supports_data->at(vid);
+
+        data.vertex_area    = m.vertex_mass(vid);
+        data.support_height = on_overhang.at(vid) ? p.z() - landing_height(hf, p.x(), p.y(), p.z(), z_floor) : p.z();
+
+        double per_vert_ground_area = 0.0;
+        double per_vert_lifted_area = 0.0;
+        for(int tid : m.adj_vtx2tri(vid))
+        {
+            per_vert_ground_area += per_face_supports_data.at(tid).ground_area;
+            per_vert_lifted_area += per_face_supports_data.at(tid).lifted_area;
+        }
+
+        data.ground_area_ratio = per_vert_ground_area / tot_area;
+        data.lifted_area_ratio = per_vert_lifted_area / tot_area;
+    }
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// Supports hang from the overhangs and land either on the part (see
+// landing_height()) or on the floor at Z_FLOOR. Segments that would have no
+// height are not extruded. The support height of the vertices of the
+// overhangs is measured from where supports land, as in estimate_supports()
+//
 CAX_INLINE
 void extrude_supports(const std::vector<tri_seg_inters> & supp_segments,
                       const Trimesh             & m,
                       const Trimesh             & m_overhangs,
+                      const HeightField         & landing,
+                      const double                z_floor,
                       const std::vector<int>    & overhang_tids,
                       const double                thickness,
                        std::vector<VertexCumulativeSupportData> & per_vertex_supports_data,
@@ -211,18 +862,24 @@ void extrude_supports(const std::vector<tri_seg_inters> & supp_segments,
         vec3d C = m.triangle_point_from_bary(og_tid, obj.bary_beg);
         vec3d D = m.triangle_point_from_bary(og_tid, obj.bary_end);
 
-        int base = coords.size()/3;
-        tris.push_back(base);
-        tris.push_back(base + 1);
-        tris.push_back(base + 2);
-        tris.push_back(base + 1);
-        tris.push_back(base + 3);
-        tris.push_back(base + 2);
-
-        coords.push_back(A.x()); coords.push_back(A.y()); coords.push_back(A.z());
-        coords.push_back(B.x()); coords.push_back(B.y()); coords.push_back(B.z());
-        coords.push_back(C.x()); coords.push_back(C.y()); coords.push_back(C.z());
-        coords.push_back(D.x()); coords.push_back(D.y()); coords.push_back(D.z());
+        vec3d A_land(A.x(), A.y(), landing_height(landing, A.x(), A.y(), C.z(), A.z()));
+        vec3d B_land(B.x(), B.y(), landing_height(landing, B.x(), B.y(), D.z(), B.z()));
+
+        if (A_land.z() < C.z() || B_land.z() < D.z())
+        {
+            int base = coords.size()/3;
+            tris.push_back(base);
+            tris.push_back(base + 1);
+            tris.push_back(base + 2);
+            tris.push_back(base + 1);
+            tris.push_back(base + 3);
+            tris.push_back(base + 2);
+
+            coords.push_back(A_land.x()); coords.push_back(A_land.y()); coords.push_back(A_land.z());
+            coords.push_back(B_land.x()); coords.push_back(B_land.y()); coords.push_back(B_land.z());
+            coords.push_back(C.x());      coords.push_back(C.y());      coords.push_back(C.z());
+            coords.push_back(D.x());      coords.push_back(D.y());      coords.push_back(D.z());
+        }
 
         projected_overhang_area += m_overhangs.element_mass(obj.tid);
 
@@ -236,10 +893,17 @@ void extrude_supports(const std::vector<tri_seg_inters> & supp_segments,
 
     per_vertex_supports_data.resize(m.num_vertices());
 
+    std::vector<bool> on_overhang(m.num_vertices(), false);
+    for(int tid : overhang_tids)
+    {
+        for(int i=0; i<3; ++i) on_overhang.at(m.triangle_vertex_id(tid,i)) = true;
+    }
+
     for(uint vid=0; vid<m.num_vertices(); ++vid)
     {
         per_vertex_supports_data.at(vid).vertex_area    = m.vertex_mass(vid);
-        per_vertex_supports_data.at(vid).support_height = m.vertex(vid).z();
+        vec3d p = m.vertex(vid);
+        per_vertex_supports_data.at(vid).support_height = on_overhang.at(vid) ? p.z() - landing_height(landing, p.x(), p.y(), p.z(), z_floor) : p.z();
 
         double per_vert_ground_area = 0.0;
         double per_vert_lifted_area = 0.0;
@@ -0,0 +1,82 @@
+#include "radix_sort.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace caxlib
+{
+
+CAX_INLINE
+void radix_sort(std::vector<uint64_t> & keys,
+                std::vector<u_int>    & payload)
+{
+    assert(keys.size() == payload.size());
+
+    const size_t n = keys.size();
+    if (n < 2) return;
+
+    // for short arrays clearing the histograms costs more than sorting
+    //
+    if (n < 4096)
+    {
+        std::vector< std::pair<uint64_t,u_int> > tmp(n);
+        for(size_t i=0; i<n; ++i) tmp[i] = std::make_pair(keys[i], payload[i]);
+        std::stable_sort(tmp.begin(), tmp.end(), [](const std::pair<uint64_t,u_int> & a, const std::pair<uint64_t,u_int> & b)
+        {
+            return a.first < b.first;
+        });
+        for(size_t i=0; i<n; ++i)
+        {
+            keys[i]    = tmp[i].first;
+            payload[i] = tmp[i].second;
+        }
+        return;
+    }
+
+    const int n_digits = 1 << 16;
+
+    // histograms of the four 16 bit digits, all computed in a single sweep
+    //
+    std::vector<size_t> count(4 * n_digits, 0);
+    for(size_t i=0; i<n; ++i)
+    {
+        uint64_t k = keys[i];
+        ++count[0 * n_digits + ((k >>  0) & 0xFFFF)];
+        ++count[1 * n_digits + ((k >> 16) & 0xFFFF)];
+        ++count[2 * n_digits + ((k >> 32) & 0xFFFF)];
+        ++count[3 * n_digits + ((k >> 48) & 0xFFFF)];
+    }
+
+    std::vector<uint64_t> tmp_keys(n);
+    std::vector<u_int>    tmp_payload(n);
+
+    for(int pass=0; pass<4; ++pass)
+    {
+        int     shift = pass * 16;
+        size_t *c     = &count[pass * n_digits];
+
+        // all keys have the same digit: nothing to do
+        //
+        if (c[(keys[0] >> shift) & 0xFFFF] == n) continue;
+
+        size_t sum = 0;
+        for(int d=0; d<n_digits; ++d)
+        {
+            size_t tmp = c[d];
+            c[d] = sum;
+            sum += tmp;
+        }
+
+        for(size_t i=0; i<n; ++i)
+        {
+            size_t pos = c[(keys[i] >> shift) & 0xFFFF]++;
+            tmp_keys[pos]    = keys[i];
+            tmp_payload[pos] = payload[i];
+        }
+
+        keys.swap(tmp_keys);
+        payload.swap(tmp_payload);
+    }
+}
+
+}
@@ -0,0 +1,27 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include "caxlib.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <vector>
+
+namespace caxlib
+{
+
+// Stable LSD radix sort of 64 bit keys (16 bits per pass). The payload is
+// permuted along with the keys. Passes over digits that are the same for all
+// the keys are skipped, therefore small keys cost less than four passes.
+//
+CAX_INLINE
+void radix_sort(std::vector<uint64_t> & keys,
+                std::vector<u_int>    & payload);
+
+}
+
+#ifndef  CAX_STATIC_LIB
+#include "radix_sort.cpp"
+#endif
+
+#endif // RADIX_SORT_H
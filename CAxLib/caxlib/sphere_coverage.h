@@ -4,6 +4,7 @@
 #include "caxlib.h"
 #include "vec3.h"
 
+#include <random>
 #include <vector>
 
 namespace caxlib
@@ -14,12 +15,25 @@ namespace caxlib
 //
 // http://stackoverflow.com/questions/9600801/evenly-distributing-n-points-on-a-sphere
 //
-CAX_INLINE void sphere_coverage(const int n_samples, std::vector<vec3d> & points)
+// The points are randomly rotated around the y axis. A non negative SEED
+// makes the rotation (hence the points) reproducible, and does not touch
+// the global generator (i.e. it is thread safe)
+//
+CAX_INLINE void sphere_coverage(const int n_samples, std::vector<vec3d> & points, const int seed = -1)
 {
     assert(points.empty());
 
-    srand(time(NULL));
-    double rnd      = rand() * n_samples;
+    double rnd;
+    if (seed < 0)
+    {
+        srand(time(NULL));
+        rnd = rand() * n_samples;
+    }
+    else
+    {
+        std::minstd_rand rng(seed);
+        rnd = rng() % n_samples;
+    }
     double offset   = 2.0/double(n_samples);
     double increment = M_PI * (3.0 - sqrt(5.0));
 
@@ -1,6 +1,9 @@
 #include "tetmesh.h"
+#include "../parallel.h"
 #include "../timer.h"
+#include "../radix_sort.h"
 
+#include <algorithm>
 #include <float.h>
 #include <map>
 #include <set>
@@ -116,9 +119,12 @@ void Tetmesh::clear()
     vtx2tet.clear();
     vtx2tri.clear();
     edg2tet.clear();
+    edg2tri.clear();
     tet2edg.clear();
     tet2tet.clear();
     tet2tri.clear();
+    tri2tri.clear();
+    tri2edg.clear();
     tri2tet.clear();
 }
 
@@ -145,13 +151,23 @@ void Tetmesh::init()
 CAX_INLINE
 void Tetmesh::update_bbox()
 {
-    bb.reset();
-    for(int vid=0; vid<num_vertices(); ++vid)
+    bb = parallel_reduce(0, num_vertices(), Bbox(), [this](const int beg, const int end)
     {
-        vec3d v = vertex(vid);
-        bb.min = bb.min.min(v);
-        bb.max = bb.max.max(v);
-    }
+        Bbox b;
+        for(int vid=beg; vid<end; ++vid)
+        {
+            vec3d v = vertex(vid);
+            b.min = b.min.min(v);
+            b.max = b.max.max(v);
+        }
+        return b;
+    },
+    [](Bbox a, const Bbox & b)
+    {
+        a.min = a.min.min(b.min);
+        a.max = a.max.max(b.max);
+        return a;
+    });
 }
 
 CAX_INLINE
@@ -160,98 +176,161 @@ void Tetmesh::update_interior_adjacency()
     timer_start("Build adjacency");
 
     edges.clear();
-    vtx2vtx.clear();
-    vtx2edg.clear();
-    vtx2tet.clear();
-    edg2tet.clear();
-    tet2tet.clear();
-    tet2edg.clear();
 
-    vtx2tet.resize(num_vertices());
+    int nv = num_vertices();
+    int nt = num_tetrahedra();
+
+    vtx2tet.reset(nv);
+    for(size_t i=0; i<tets.size(); ++i) vtx2tet.count(tets[i]);
+    vtx2tet.alloc();
 
-    typedef std::map<ipair, std::vector<int> > mymap;
-    mymap edge_tet_map;
+    // Edges are found by sorting 64 bit keys (min_vid * nv + max_vid), one per
+    // edge of each tet. The sort is stable, therefore edge ids follow the
+    // lexicographic order of their endpoints and tets incident to the same
+    // edge are sorted by id (see also Trimesh::update_adjacency())
+    //
+    std::vector<uint64_t> keys(6*nt);
+    std::vector<u_int>    key2tet(6*nt);
 
-    for(int tid=0; tid<num_tetrahedra(); ++tid)
+    for(int tid=0; tid<nt; ++tid)
     {
         int tid_ptr = tid * 4;
+        int key_ptr = tid * 6;
 
         int vid4 = tets[tid_ptr + 3];
-        vtx2tet[vid4].push_back(tid);
+        vtx2tet.insert(vid4, tid);
 
         for(int i=0; i<3; ++i)
         {
             int  vid0 = tets[tid_ptr + i];
             int  vid1 = tets[tid_ptr + (i+1)%3];
 
-            vtx2tet[vid0].push_back(tid);
+            vtx2tet.insert(vid0, tid);
 
             ipair e1 = unique_pair(vid0, vid1);
-            edge_tet_map[e1].push_back(tid);
-
             ipair e2 = unique_pair(vid0, vid4);
-            edge_tet_map[e2].push_back(tid);
+
+            keys[key_ptr + 2*i + 0] = uint64_t(e1.first) * uint64_t(nv) + uint64_t(e1.second);
+            keys[key_ptr + 2*i + 1] = uint64_t(e2.first) * uint64_t(nv) + uint64_t(e2.second);
+            key2tet[key_ptr + 2*i + 0] = tid;
+            key2tet[key_ptr + 2*i + 1] = tid;
         }
     }
 
-    edg2tet.resize(edge_tet_map.size());
-    tet2edg.resize(num_tetrahedra());
-    tet2tet.resize(num_tetrahedra());
-    vtx2vtx.resize(num_vertices());
-    vtx2edg.resize(num_vertices());
+    radix_sort(keys, key2tet);
 
-    std::set<ipair> tet_pairs;
-
-    int fresh_id = 0;
-    for(mymap::iterator it=edge_tet_map.begin(); it!=edge_tet_map.end(); ++it)
+    // first sweep over the runs of equal keys: count the size of each
+    // relation and find face adjacent tets (at most four per tet, stored
+    // in the order they are found)
+    //
+    int ne = 0;
+    for(size_t i=0; i<keys.size(); ++i)
     {
-        ipair e    = it->first;
-        int  eid  = fresh_id++;
-        int  vid0 = e.first;
-        int  vid1 = e.second;
+        if (i == 0 || keys[i] != keys[i-1]) ++ne;
+    }
 
-        edges.push_back(vid0);
-        edges.push_back(vid1);
+    edges.reserve(2*ne);
+    vtx2vtx.reset(nv);
+    vtx2edg.reset(nv);
+    edg2tet.reset(ne);
+    tet2edg.reset(nt);
+    tet2tet.reset(nt);
+
+    std::vector<int> tet_nbrs(4*nt, -1);
+
+    int eid = 0;
+    for(size_t beg=0; beg<keys.size(); ++eid)
+    {
+        size_t end = beg + 1;
+        while (end < keys.size() && keys[end] == keys[beg]) ++end;
 
-        vtx2vtx[vid0].push_back(vid1);
-        vtx2vtx[vid1].push_back(vid0);
+        int vid0 = keys[beg] / uint64_t(nv);
+        int vid1 = keys[beg] % uint64_t(nv);
 
-        vtx2edg[vid0].push_back(eid);
-        vtx2edg[vid1].push_back(eid);
+        vtx2vtx.count(vid0);
+        vtx2vtx.count(vid1);
+        vtx2edg.count(vid0);
+        vtx2edg.count(vid1);
+        edg2tet.count(eid, end - beg);
 
-        std::vector<int> tids = it->second;
-        //assert(tids.size() <= 2);
-        //sassert(tids.size() >= 1);
-        for(int i=0; i<(int)tids.size(); ++i)
+        for(size_t i=beg; i<end; ++i)
         {
-            int tid = tids[i];
+            int tid0 = key2tet[i];
 
-            tet2edg[tid].push_back(eid);
-            edg2tet[eid].push_back(tid);
+            tet2edg.count(tid0);
 
-            for(int j=i+1; j<(int)tids.size(); ++j)
+            for(size_t j=i+1; j<end; ++j)
             {
-                if (shared_facet(tids[i], tids[j]) != -1)
-                {
-                    ipair p = unique_pair(tids[j], tids[i]);
-                    if (DOES_NOT_CONTAIN(tet_pairs, p))
-                    {
-                        tet_pairs.insert(p);
-                        tet2tet[tids[i]].push_back(tids[j]);
-                        tet2tet[tids[j]].push_back(tids[i]);
-                        // sanity checks
-                        assert(tet2tet[tids[j]].size() <= 4);
-                        assert(tet2tet[tids[i]].size() <= 4);
-                    }
-                }
+                int tid1 = key2tet[j];
+
+                if (shared_facet(tid0, tid1) == -1) continue;
+
+                int * nbrs0 = &tet_nbrs[4*tid0];
+                int * nbrs1 = &tet_nbrs[4*tid1];
+                if (std::find(nbrs0, nbrs0 + 4, tid1) != nbrs0 + 4) continue;
+
+                int * slot0 = std::find(nbrs0, nbrs0 + 4, -1);
+                int * slot1 = std::find(nbrs1, nbrs1 + 4, -1);
+                // sanity checks
+                assert(slot0 != nbrs0 + 4);
+                assert(slot1 != nbrs1 + 4);
+                if (slot0 == nbrs0 + 4 || slot1 == nbrs1 + 4) continue;
+
+                *slot0 = tid1;
+                *slot1 = tid0;
             }
         }
 
-//        if (tids.size() == 2)
-//        {
-//            tet2tet[tids[0]].push_back(tids[1]);
-//            tet2tet[tids[1]].push_back(tids[0]);
-//        }
+        beg = end;
+    }
+
+    for(int tid=0; tid<nt; ++tid)
+    for(int i=0; i<4; ++i)
+    {
+        if (tet_nbrs[4*tid+i] != -1) tet2tet.count(tid);
+    }
+
+    vtx2vtx.alloc();
+    vtx2edg.alloc();
+    edg2tet.alloc();
+    tet2edg.alloc();
+    tet2tet.alloc();
+
+    // second sweep: fill the relations
+    //
+    eid = 0;
+    for(size_t beg=0; beg<keys.size(); ++eid)
+    {
+        size_t end = beg + 1;
+        while (end < keys.size() && keys[end] == keys[beg]) ++end;
+
+        int vid0 = keys[beg] / uint64_t(nv);
+        int vid1 = keys[beg] % uint64_t(nv);
+
+        edges.push_back(vid0);
+        edges.push_back(vid1);
+
+        vtx2vtx.insert(vid0, vid1);
+        vtx2vtx.insert(vid1, vid0);
+
+        vtx2edg.insert(vid0, eid);
+        vtx2edg.insert(vid1, eid);
+
+        for(size_t i=beg; i<end; ++i)
+        {
+            int tid = key2tet[i];
+
+            tet2edg.insert(tid, eid);
+            edg2tet.insert(eid, tid);
+        }
+
+        beg = end;
+    }
+
+    for(int tid=0; tid<nt; ++tid)
+    for(int i=0; i<4; ++i)
+    {
+        if (tet_nbrs[4*tid+i] != -1) tet2tet.insert(tid, tet_nbrs[4*tid+i]);
     }
 
     logger << num_vertices()   << "\tvertices"   << endl;
@@ -264,46 +343,84 @@ void Tetmesh::update_interior_adjacency()
 CAX_INLINE
 void Tetmesh::update_surface_adjacency()
 {
-    tris.clear();
-    tri2tet.clear();
-    v_on_srf.resize(num_vertices(), false);
-    e_on_srf.resize(num_edges(), false);
-    tet2tri.resize(num_tetrahedra());
-    vtx2tri.resize(num_vertices());
+    timer_start("Build Surface");
 
-    edg2tri.resize(num_edges());
-    tri2edg.clear();
-    tri2tri.clear();
+    int nv = num_vertices();
+    int nt = num_tetrahedra();
+    int ne = num_edges();
 
-    timer_start("Build Surface");
+    tris.clear();
+    tri2tet.clear();
+    v_on_srf.assign(nv, false);
+    e_on_srf.assign(ne, false);
 
-    typedef std::vector<int> face;
-    std::map< face,std::pair<int,int> > tri2tet_map;
+    // sort all the tet faces by their (sorted) vertex ids. Surface faces are
+    // the ones appearing only once, and they are listed in the lexicographic
+    // order of their vertices
+    //
+    std::vector<int>   faces(12*nt);
+    std::vector<u_int> order(4*nt);
 
-    for(int tid=0; tid<num_tetrahedra(); ++tid)
+    for(int tid=0; tid<nt; ++tid)
     {
         int tid_ptr = tid * 4;
 
         for(int fid=0; fid<4; ++fid)
         {
-            face f;
-            f.push_back(tets[tid_ptr + TET_FACES[fid][0]]);
-            f.push_back(tets[tid_ptr + TET_FACES[fid][1]]);
-            f.push_back(tets[tid_ptr + TET_FACES[fid][2]]);
+            int * f = &faces[3*(tid_ptr + fid)];
+            f[0] = tets[tid_ptr + TET_FACES[fid][0]];
+            f[1] = tets[tid_ptr + TET_FACES[fid][1]];
+            f[2] = tets[tid_ptr + TET_FACES[fid][2]];
+            std::sort(f, f+3);
+            order[tid_ptr + fid] = tid_ptr + fid;
+        }
+    }
+
+    std::sort(order.begin(), order.end(), [&faces](const u_int a, const u_int b)
+    {
+        const int * fa = &faces[3*a];
+        const int * fb = &faces[3*b];
+        if (fa[0] != fb[0]) return fa[0] < fb[0];
+        if (fa[1] != fb[1]) return fa[1] < fb[1];
+        if (fa[2] != fb[2]) return fa[2] < fb[2];
+        return a < b;
+    });
+
+    // a face shared by two tets is interior. Runs of odd length (i.e. non
+    // manifold faces) keep their last face
+    //
+    std::vector<u_int> srf;
+    for(size_t beg=0; beg<order.size(); )
+    {
+        size_t end = beg + 1;
+        while (end < order.size() && std::equal(&faces[3*order[beg]], &faces[3*order[beg]] + 3, &faces[3*order[end]])) ++end;
 
-            sort(f.begin(), f.end());
+        if ((end - beg) % 2 == 1) srf.push_back(order[end-1]);
 
-            if (CONTAINS(tri2tet_map,f)) tri2tet_map.erase(f);
-            else                         tri2tet_map[f] = std::make_pair(tid,fid);
-        }
+        beg = end;
     }
 
-    for(auto it=tri2tet_map.begin(); it!=tri2tet_map.end(); ++it)
+    int ns = srf.size();
+
+    tris.reserve(3*ns);
+    tri2tet.reserve(ns);
+
+    // surface edges of each surface triangle, picked among the edges of its tet
+    //
+    std::vector<int> srf_edges;
+    std::vector<int> n_srf_edges(ns, 0);
+    srf_edges.reserve(3*ns);
+
+    vtx2tri.reset(nv);
+    tet2tri.reset(nt);
+    tri2edg.reset(ns);
+    edg2tri.reset(ne);
+
+    for(int sid=0; sid<ns; ++sid)
     {
-        auto obj     = *it;
-        int  tid     = obj.second.first;
-        int  fid     = obj.second.second;
-        int  tid_ptr = tid * 4;
+        int tid     = srf[sid] / 4;
+        int fid     = srf[sid] % 4;
+        int tid_ptr = tid * 4;
 
         int vid0 = tets[tid_ptr + TET_FACES[fid][0]];
         int vid1 = tets[tid_ptr + TET_FACES[fid][1]];
@@ -317,19 +434,13 @@ void Tetmesh::update_surface_adjacency()
         v_on_srf[vid1] = true;
         v_on_srf[vid2] = true;
 
-        int fresh_id = tri2tet.size();
-
-        vtx2tri[vid0].push_back(fresh_id);
-        tet2tri[tid].push_back(fresh_id);
+        vtx2tri.count(vid0);
+        tet2tri.count(tid);
         tri2tet.push_back(tid);
 
-        std::vector<int> edges = adj_tet2edg(tid);
-        std::vector<int> tmp;
-        tri2edg.push_back(tmp);
-        assert(edges.size() == 6);
-        for(size_t i=0; i<edges.size(); ++i)
+        assert(adj_tet2edg(tid).size() == 6);
+        for(int eid : adj_tet2edg(tid))
         {
-            int  eid   = edges[i];
             int  eid0  = edge_vertex_id(eid, 0);
             int  eid1  = edge_vertex_id(eid, 1);
             bool has_0 = (eid0 == vid0 || eid0 == vid1 || eid0 == vid2);
@@ -337,17 +448,35 @@ void Tetmesh::update_surface_adjacency()
 
             if (has_0 && has_1)
             {
-                edg2tri[eid].push_back(fresh_id);
-                tri2edg[fresh_id].push_back(eid);
+                srf_edges.push_back(eid);
+                ++n_srf_edges[sid];
+                tri2edg.count(sid);
+                edg2tri.count(eid);
             }
         }
     }
 
-    tri2tri.resize(num_srf_triangles());
+    vtx2tri.alloc();
+    tet2tri.alloc();
+    tri2edg.alloc();
+    edg2tri.alloc();
 
-    for(int eid=0; eid<num_edges(); ++eid)
+    for(int sid=0, i=0; sid<ns; ++sid)
     {
-        std::vector<int> tris = edg2tri[eid];
+        vtx2tri.insert(tri_vertex_id(sid,0), sid);
+        tet2tri.insert(tri2tet[sid], sid);
+
+        for(int j=0; j<n_srf_edges[sid]; ++j, ++i)
+        {
+            tri2edg.insert(sid, srf_edges[i]);
+            edg2tri.insert(srf_edges[i], sid);
+        }
+    }
+
+    tri2tri.reset(ns);
+    for(int eid=0; eid<ne; ++eid)
+    {
+        AdjacencyView tris = adj_edg2tri(eid);
         if (!(tris.empty() || tris.size() == 2))
         {
             logger << "\tedge " << eid << " is non manifold! " << tris.size() << endl;
@@ -356,16 +485,23 @@ void Tetmesh::update_surface_adjacency()
             u_text[edge_vertex_id(eid,1)] = 10.0;
         }
         //assert(tris.empty() || tris.size() == 2);
-        if (!tris.empty())
+        if (tris.size() >= 2)
         {
-            int t0 = tris[0];
-            int t1 = tris[1];
-            tri2tri[t0].push_back(t1);
-            tri2tri[t1].push_back(t0);
+            tri2tri.count(tris[0]);
+            tri2tri.count(tris[1]);
         }
 
-        e_on_srf[eid] = !(edg2tri[eid].empty());
-        //if (e_on_srf[eid]) assert(adj_edg2tri.size() == 2);
+        e_on_srf[eid] = !tris.empty();
+    }
+    tri2tri.alloc();
+    for(int eid=0; eid<ne; ++eid)
+    {
+        AdjacencyView tris = adj_edg2tri(eid);
+        if (tris.size() >= 2)
+        {
+            tri2tri.insert(tris[0], tris[1]);
+            tri2tri.insert(tris[1], tris[0]);
+        }
     }
 
     timer_stop("Build Surface");
@@ -373,34 +509,72 @@ void Tetmesh::update_surface_adjacency()
     logger << tris.size() / 3 << " triangles were generated" << endl;
 }
 
+CAX_INLINE
+void Tetmesh::print_memory_footprint() const
+{
+    size_t tot = 0;
+    auto print = [&tot](const char * name, const size_t bytes)
+    {
+        logger << name << "\t" << double(bytes) / (1024.0 * 1024.0) << " MB" << endl;
+        tot += bytes;
+    };
+
+    print("coords  ", coords.capacity()  * sizeof(double));
+    print("tets    ", tets.capacity()    * sizeof(u_int));
+    print("edges   ", edges.capacity()   * sizeof(u_int));
+    print("tris    ", tris.capacity()    * sizeof(u_int));
+    print("v_on_srf", v_on_srf.capacity() / 8);
+    print("e_on_srf", e_on_srf.capacity() / 8);
+    print("t_norm  ", t_norm.capacity()  * sizeof(double));
+    print("u_text  ", u_text.capacity()  * sizeof(float));
+    print("t_label ", t_label.capacity() * sizeof(int));
+    print("vtx2vtx ", vtx2vtx.memory_footprint());
+    print("vtx2edg ", vtx2edg.memory_footprint());
+    print("vtx2tet ", vtx2tet.memory_footprint());
+    print("vtx2tri ", vtx2tri.memory_footprint());
+    print("edg2tet ", edg2tet.memory_footprint());
+    print("edg2tri ", edg2tri.memory_footprint());
+    print("tet2edg ", tet2edg.memory_footprint());
+    print("tet2tet ", tet2tet.memory_footprint());
+    print("tet2tri ", tet2tri.memory_footprint());
+    print("tri2tri ", tri2tri.memory_footprint());
+    print("tri2edg ", tri2edg.memory_footprint());
+    print("tri2tet ", tri2tet.capacity() * sizeof(int));
+
+    logger << "total   \t" << double(tot) / (1024.0 * 1024.0) << " MB" << endl;
+}
+
 CAX_INLINE
 void Tetmesh::update_t_normals()
 {
     t_norm.clear();
     t_norm.resize(num_srf_triangles()*3);
 
-    for(int tid=0; tid<num_srf_triangles(); ++tid)
+    parallel_blocks(0, num_srf_triangles(), [this](const int beg, const int end)
     {
-        int tid_ptr = tid * 3;
+        for(int tid=beg; tid<end; ++tid)
+        {
+            int tid_ptr = tid * 3;
 
-        vec3d v0 = vertex(tris[tid_ptr+0]);
-        vec3d v1 = vertex(tris[tid_ptr+1]);
-        vec3d v2 = vertex(tris[tid_ptr+2]);
+            vec3d v0 = vertex(tris[tid_ptr+0]);
+            vec3d v1 = vertex(tris[tid_ptr+1]);
+            vec3d v2 = vertex(tris[tid_ptr+2]);
 
-        vec3d u = v1 - v0;    u.normalize();
-        vec3d v = v2 - v0;    v.normalize();
-        vec3d n = u.cross(v); n.normalize();
+            vec3d u = v1 - v0;    u.normalize();
+            vec3d v = v2 - v0;    v.normalize();
+            vec3d n = u.cross(v); n.normalize();
 
-        t_norm[tid_ptr + 0] = n.x();
-        t_norm[tid_ptr + 1] = n.y();
-        t_norm[tid_ptr + 2] = n.z();
-    }
+            t_norm[tid_ptr + 0] = n.x();
+            t_norm[tid_ptr + 1] = n.y();
+            t_norm[tid_ptr + 2] = n.z();
+        }
+    });
 }
 
 CAX_INLINE
 int Tetmesh::adjacent_tet_through_facet(const int tid, const int facet)
 {
-    std::vector<int> nbrs = adj_tet2tet(tid);
+    AdjacencyView nbrs = adj_tet2tet(tid);
     for(size_t i=0; i<nbrs.size(); ++i)
     {
         if (shared_facet(tid, nbrs[i]) == facet) return nbrs[i];
@@ -461,7 +635,7 @@ void Tetmesh::print_quality_statistics(bool list_folded_elements) const
 CAX_INLINE
 double Tetmesh::vertex_mass(const int vid) const
 {
-    std::vector<int> tets = adj_vtx2tri(vid);
+    AdjacencyView tets = adj_vtx2tri(vid);
     double mass = 0.0;
     for(int i=0; i<(int)tets.size(); ++i)
     {
@@ -652,7 +826,7 @@ CAX_INLINE
 double Tetmesh::vertex_quality(const int vid) const
 {
     double q = 1.0;
-    std::vector<int> nbrs = adj_vtx2tet(vid);
+    AdjacencyView nbrs = adj_vtx2tet(vid);
     for(size_t i=0; i<nbrs.size(); ++i)
     {
         q = std::min(q, tet_quality(nbrs[i]));
@@ -664,7 +838,7 @@ CAX_INLINE
 int Tetmesh::vertex_inverted_elements(const int vid) const
 {
     int count = 0;
-    std::vector<int> nbrs = adj_vtx2tet(vid);
+    AdjacencyView nbrs = adj_vtx2tet(vid);
     for(size_t i=0; i<nbrs.size(); ++i)
     {
         if (tet_quality(nbrs[i]) < 0) ++count;
@@ -680,7 +854,7 @@ std::vector<int> Tetmesh::tet_one_ring(const int tid) const
     int vid_c = tet_vertex_id(tid, 2);
     int vid_d = tet_vertex_id(tid, 3);
 
-    std::vector<int> vtx_adj[4] =
+    AdjacencyView vtx_adj[4] =
     {
         adj_vtx2tet(vid_a),
         adj_vtx2tet(vid_b),
@@ -764,7 +938,7 @@ void Tetmesh::export_submesh_with_label(const int             label,
 CAX_INLINE
 std::vector<int> Tetmesh::edge_ordered_tet_ring(const int eid) const
 {
-    std::vector<int> ring = adj_edg2tet(eid);
+    AdjacencyView ring = adj_edg2tet(eid);
 
     assert(!ring.empty());
     assert((!is_surface_edge(eid)) || (is_surface_edge(eid) && !adj_edg2tri(eid).empty()));
@@ -937,18 +1111,6 @@ void Tetmesh::operator+=(const Tetmesh & m)
         tets.push_back(nv + m.tet_vertex_id(tid,3));
 
         t_label.push_back(m.tet_label(tid));
-
-        std::vector<int> tmp;
-        for(int eid : m.tet2edg[tid]) tmp.push_back(ne + eid);
-        tet2edg.push_back(tmp);
-
-        tmp.clear();
-        for(int tid : m.tet2tet[tid]) tmp.push_back(nt + tid);
-        tet2tet.push_back(tmp);
-
-        tmp.clear();
-        for(int tid : m.tet2tri[tid]) tmp.push_back(ns + tid);
-        tet2tri.push_back(tmp);
     }
     for(int eid=0; eid<m.num_edges(); ++eid)
     {
@@ -956,14 +1118,6 @@ void Tetmesh::operator+=(const Tetmesh & m)
         edges.push_back(nv + m.edge_vertex_id(eid,1));
 
         e_on_srf.push_back(m.e_on_srf[eid]);
-
-        std::vector<int> tmp;
-        for(int tid : m.edg2tet[eid]) tmp.push_back(nt + tid);
-        edg2tet.push_back(tmp);
-
-        tmp.clear();
-        for(int tid : m.edg2tri[eid]) tmp.push_back(ns + tid);
-        edg2tri.push_back(tmp);
     }
     for(int sid=0; sid<m.num_srf_triangles(); ++sid)
     {
@@ -977,14 +1131,6 @@ void Tetmesh::operator+=(const Tetmesh & m)
         t_norm.push_back(n.z());
 
         tri2tet.push_back(nt + m.tri2tet[sid]);
-
-        std::vector<int> tmp;
-        for(int eid : m.tri2edg[sid]) tmp.push_back(ne + eid);
-        tri2edg.push_back(tmp);
-
-        tmp.clear();
-        for(int nbr : m.tri2tri[sid]) tmp.push_back(ns + nbr);
-        tri2tri.push_back(tmp);
     }
     for(int vid=0; vid<m.num_vertices(); ++vid)
     {
@@ -995,35 +1141,30 @@ void Tetmesh::operator+=(const Tetmesh & m)
 
         v_on_srf.push_back(m.v_on_srf[vid]);
         u_text.push_back(m.vertex_u_text(vid));
-
-        std::vector<int> tmp;
-        for(int eid : m.vtx2edg[vid]) tmp.push_back(ne + eid);
-        vtx2edg.push_back(tmp);
-
-        tmp.clear();
-        for(int tid : m.vtx2tet[vid]) tmp.push_back(nt + tid);
-        vtx2tet.push_back(tmp);
-
-        tmp.clear();
-        for(int sid : m.vtx2tri[vid]) tmp.push_back(ns + sid);
-        vtx2tri.push_back(tmp);
-
-        tmp.clear();
-        for(int nbr : m.vtx2vtx[vid]) tmp.push_back(nv + nbr);
-        vtx2vtx.push_back(tmp);
     }
 
+    vtx2vtx.append(m.vtx2vtx, nv);
+    vtx2edg.append(m.vtx2edg, ne);
+    vtx2tet.append(m.vtx2tet, nt);
+    vtx2tri.append(m.vtx2tri, ns);
+    edg2tet.append(m.edg2tet, nt);
+    edg2tri.append(m.edg2tri, ns);
+    tet2edg.append(m.tet2edg, ne);
+    tet2tet.append(m.tet2tet, nt);
+    tet2tri.append(m.tet2tri, ns);
+    tri2tri.append(m.tri2tri, ns);
+    tri2edg.append(m.tri2edg, ne);
+
     update_bbox();
 }
 
 CAX_INLINE
 void Tetmesh::normalize_volume()
 {
-    double vol = 0.0;
-    for(int tid=0; tid<num_tetrahedra(); ++tid)
+    double vol = parallel_sum(0, num_tetrahedra(), [this](const int tid)
     {
-        vol += tet_volume(tid);
-    }
+        return tet_volume(tid);
+    });
     logger << "volume before: " << vol << endl;
     if (vol < 1e-4)
     {
@@ -11,6 +11,7 @@
 
 #include "../caxlib.h"
 #include "../common.h"
+#include "../adjacency_list.h"
 #include "../bbox.h"
 #include "../vec3.h"
 #include "../trimesh/trimesh.h"
@@ -75,18 +76,18 @@ class Tetmesh
 
         // adjacencies
         //
-        std::vector< std::vector<int> > vtx2vtx;
-        std::vector< std::vector<int> > vtx2edg;
-        std::vector< std::vector<int> > vtx2tet;
-        std::vector< std::vector<int> > vtx2tri;
-        std::vector< std::vector<int> > edg2tet;
-        std::vector< std::vector<int> > edg2tri;
-        std::vector< std::vector<int> > tet2edg;
-        std::vector< std::vector<int> > tet2tet;
-        std::vector< std::vector<int> > tet2tri;
-        std::vector< std::vector<int> > tri2tri;
-        std::vector< std::vector<int> > tri2edg;
-        std::vector< int >              tri2tet;
+        AdjacencyList    vtx2vtx;
+        AdjacencyList    vtx2edg;
+        AdjacencyList    vtx2tet;
+        AdjacencyList    vtx2tri;
+        AdjacencyList    edg2tet;
+        AdjacencyList    edg2tri;
+        AdjacencyList    tet2edg;
+        AdjacencyList    tet2tet;
+        AdjacencyList    tet2tri;
+        AdjacencyList    tri2tri;
+        AdjacencyList    tri2edg;
+        std::vector<int> tri2tet;
 
 
     public:
@@ -121,24 +122,28 @@ class Tetmesh
 
         void update_t_normals();
 
+        // log the heap memory used by the mesh arrays and by each relation
+        //
+        void print_memory_footprint() const;
+
         int num_vertices()      const { return coords.size()/3; }
         int num_tetrahedra()    const { return tets.size()  /4; }
         int num_elements()      const { return tets.size()  /4; }
         int num_edges()         const { return edges.size() /2; }
         int num_srf_triangles() const { return tris.size()  /3; }
 
-        const std::vector<int> & adj_vtx2vtx(const int vid) const { return vtx2vtx.at(vid); }
-        const std::vector<int> & adj_vtx2edg(const int vid) const { return vtx2edg.at(vid); }
-        const std::vector<int> & adj_vtx2tri(const int vid) const { return vtx2tri.at(vid); }
-        const std::vector<int> & adj_vtx2tet(const int vid) const { return vtx2tet.at(vid); }
-        const std::vector<int> & adj_edg2tet(const int eid) const { return edg2tet.at(eid); }
-        const std::vector<int> & adj_edg2tri(const int eid) const { return edg2tri.at(eid); }
-        const std::vector<int> & adj_tet2edg(const int tid) const { return tet2edg.at(tid); }
-        const std::vector<int> & adj_tet2tet(const int tid) const { return tet2tet.at(tid); }
-        const std::vector<int> & adj_tet2tri(const int tid) const { return tet2tri.at(tid); }
-        const std::vector<int> & adj_tri2tri(const int tid) const { return tri2tri.at(tid); }
-        const std::vector<int> & adj_tri2edg(const int tid) const { return tri2edg.at(tid); }
-        const int              & adj_tri2tet(const int tid) const { return tri2tet.at(tid); }
+        AdjacencyView adj_vtx2vtx(const int vid) const { return vtx2vtx.row(vid); }
+        AdjacencyView adj_vtx2edg(const int vid) const { return vtx2edg.row(vid); }
+        AdjacencyView adj_vtx2tri(const int vid) const { return vtx2tri.row(vid); }
+        AdjacencyView adj_vtx2tet(const int vid) const { return vtx2tet.row(vid); }
+        AdjacencyView adj_edg2tet(const int eid) const { return edg2tet.row(eid); }
+        AdjacencyView adj_edg2tri(const int eid) const { return edg2tri.row(eid); }
+        AdjacencyView adj_tet2edg(const int tid) const { return tet2edg.row(tid); }
+        AdjacencyView adj_tet2tet(const int tid) const { return tet2tet.row(tid); }
+        AdjacencyView adj_tet2tri(const int tid) const { return tet2tri.row(tid); }
+        AdjacencyView adj_tri2tri(const int tid) const { return tri2tri.row(tid); }
+        AdjacencyView adj_tri2edg(const int tid) const { return tri2edg.row(tid); }
+        const int &  adj_tri2tet(const int tid) const { return tri2tet.at(tid); }
 
         vec3d vertex(const int vid) const
         {
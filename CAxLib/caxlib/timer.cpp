@@ -7,10 +7,12 @@
 namespace caxlib
 {
 
-static std::map<int,clock_t>      t_start;
-static std::map<int,clock_t>      t_stop;
-static std::map<int,std::string>  msgs;
-static unsigned int               first_call = 0;
+// one set of timers per thread
+//
+static thread_local std::map<int,clock_t>      t_start;
+static thread_local std::map<int,clock_t>      t_stop;
+static thread_local std::map<int,std::string>  msgs;
+static thread_local unsigned int               first_call = 0;
 
 ////////////////////////////////////////////////////////////////////////////////////////
 
@@ -78,18 +78,20 @@ void DrawableTrimesh::clear()
 CAX_INLINE
 vec3d DrawableTrimesh::scene_center() const
 {
-    return bb.center();
+    return bbox().center();
 }
 
 CAX_INLINE
 float DrawableTrimesh::scene_radius() const
 {
-    return bb.diag() * 0.5;
+    return bbox().diag() * 0.5;
 }
 
 CAX_INLINE
 void DrawableTrimesh::render_pass() const
 {
+    require(BBOX | V_NORMALS);
+
     if (draw_mode & DRAW_POINTS)
     {
         glEnableClientState(GL_VERTEX_ARRAY);
@@ -183,7 +185,7 @@ void DrawableTrimesh::render_pass() const
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glEnable(GL_BLEND);
 
-        float delta = bb.diag() * 0.0005;
+        float delta = bbox().diag() * 0.0005;
         for(int i=0; i<(int)borders.size(); i+=2)
         {
             vec3d v0 = vertex(borders[i]);
@@ -1,32 +1,38 @@
 #include "trimesh.h"
 #include "../bfs.h"
+#include "../convex_hull.h"
+#include "../parallel.h"
 #include "../timer.h"
+#include "../radix_sort.h"
+#include "../weld.h"
 #include "../io/read_write.h"
 
+#include <algorithm>
 #include <queue>
 
 namespace caxlib
 {
 
 CAX_INLINE
-Trimesh::Trimesh(const char * filename)
+Trimesh::Trimesh(const char * filename, const bool lazy)
 {
     timer_start("load");
 
     load(filename);
-    init();
+    init(lazy);
 
     timer_stop("load");
 }
 
 CAX_INLINE
 Trimesh::Trimesh(const std::vector<double> & coords,
-                 const std::vector<u_int>  & tris)
+                 const std::vector<u_int>  & tris,
+                 const bool                  lazy)
 {
     clear();
     this->coords = coords;
     this->tris   = tris;
-    init();
+    init(lazy);
 }
 
 CAX_INLINE
@@ -34,7 +40,8 @@ Trimesh::Trimesh(const std::vector<double>           & coords,
                  const std::vector<u_int>            & tris,
                  const GlobalAnnotations             & glob_ann,
                  const std::vector<VertexAnnotations> & vertex_ann,
-                 const std::vector<TriangleAnnotations> & triangle_ann)
+                 const std::vector<TriangleAnnotations> & triangle_ann,
+                 const bool                               lazy)
 {
     clear();
     this->coords = coords;
@@ -42,7 +49,7 @@ Trimesh::Trimesh(const std::vector<double>           & coords,
     this->glob_ann = glob_ann;
     this->vertex_ann = vertex_ann;
     this->triangle_ann = triangle_ann;
-    init();
+    init(lazy);
 }
 
 CAX_INLINE
@@ -62,15 +69,18 @@ void Trimesh::clear()
     tri2tri.clear();
     tri2edg.clear();
     edg2tri.clear();
+    he_twin.clear();
+    he2edg.clear();
+    hull_vids.clear();
     triangle_ann.clear();
+    valid = 0;
 }
 
 CAX_INLINE
-void Trimesh::init()
+void Trimesh::init(const bool lazy)
 {
-    update_adjacency();
-    update_bbox();
-    update_normals();
+    valid = 0;
+    if (!lazy) require(ALL);
 
     u_text.resize(num_vertices(), 0.0);
     if (t_label.empty())   t_label.resize(num_triangles(), 0);
@@ -80,23 +90,70 @@ void Trimesh::init()
 CAX_INLINE
 void Trimesh::update_adjacency()
 {
-    timer_start("Build adjacency");
+    build_vtx2tri();
+    build_edges();
+}
 
-    edges.clear();
+CAX_INLINE
+void Trimesh::build(const int what) const
+{
+    if (what & VTX2TRI)   build_vtx2tri();
+    if (what & EDGES)     build_edges();
+    if (what & HEDGES)    build_hedges();
+    if (what & BBOX)      build_bbox();
+    if (what & T_NORMALS) build_t_normals();
+    if (what & V_NORMALS) build_v_normals();
+    if (what & CONVEX_HULL) build_convex_hull();
+}
 
-    vtx2vtx.clear();
-    vtx2edg.clear();
-    edg2tri.clear();
-    tri2tri.clear();
-    tri2edg.clear();
-    vtx2tri.clear();
+CAX_INLINE
+void Trimesh::build_vtx2tri() const
+{
+    int nt = num_triangles();
 
-    vtx2tri.resize(num_vertices());
+    vtx2tri.reset(num_vertices());
+    for(size_t i=0; i<tris.size(); ++i) vtx2tri.count(tris[i]);
+    vtx2tri.alloc();
 
-    typedef std::map<ipair, std::vector<int> > mymap;
-    mymap edge_tri_map;
+    for(int tid=0; tid<nt; ++tid)
+    for(int i=0; i<3; ++i)
+    {
+        vtx2tri.insert(tris[3*tid+i], tid);
+    }
 
-    for(int tid=0; tid<num_triangles(); ++tid)
+    valid |= VTX2TRI;
+}
+
+CAX_INLINE
+void Trimesh::build_edges() const
+{
+    timer_start("Build adjacency");
+
+    // edge ids may change: half edges refer to them
+    //
+    valid &= ~HEDGES;
+
+    edges.clear();
+
+    int nv = num_vertices();
+    int nt = num_triangles();
+
+    // Each half edge is encoded as a 64 bit key (min_vid * nv + max_vid) and
+    // sorted along with its id (3 * tid + offset). Sorted keys list the edges
+    // in the same lexicographic (vid0,vid1) order of a std::map<ipair,...>, and
+    // the sort is stable, so half edges sharing the same key are still sorted by
+    // triangle id. Edge ids, as well as the order of the elements within each
+    // adjacency list, are therefore deterministic and do not depend on how the
+    // half edges are sorted:
+    //
+    //  - edge ids follow the lexicographic order of their (sorted) endpoints
+    //  - vtx2vtx, vtx2edg and tri2edg are sorted by edge id
+    //  - vtx2tri and edg2tri are sorted by triangle id
+    //
+    std::vector<uint64_t> keys(3*nt);
+    std::vector<u_int>    hedges(3*nt);
+
+    for(int tid=0; tid<nt; ++tid)
     {
         int tid_ptr = tid * 3;
 
@@ -105,57 +162,105 @@ void Trimesh::update_adjacency()
             int  vid0 = tris[tid_ptr + i];
             int  vid1 = tris[tid_ptr + (i+1)%3];
 
-            vtx2tri[vid0].push_back(tid);
-
             ipair e = unique_pair(vid0, vid1);
-            edge_tri_map[e].push_back(tid);
+            keys[tid_ptr + i]   = uint64_t(e.first) * uint64_t(nv) + uint64_t(e.second);
+            hedges[tid_ptr + i] = tid_ptr + i;
+        }
+    }
+
+    radix_sort(keys, hedges);
+
+    // first sweep over the runs of equal keys: count the edges and the size
+    // of each adjacency list, so that each relation is allocated only once
+    //
+    int ne = 0;
+    for(size_t i=0; i<keys.size(); ++i)
+    {
+        if (i == 0 || keys[i] != keys[i-1]) ++ne;
+    }
+
+    edges.reserve(2*ne);
+    vtx2vtx.reset(nv);
+    vtx2edg.reset(nv);
+    edg2tri.reset(ne);
+    tri2edg.reset(nt);
+    tri2tri.reset(nt);
+
+    int eid = 0;
+    for(size_t beg=0; beg<keys.size(); ++eid)
+    {
+        size_t end = beg + 1;
+        while (end < keys.size() && keys[end] == keys[beg]) ++end;
+
+        int vid0 = keys[beg] / uint64_t(nv);
+        int vid1 = keys[beg] % uint64_t(nv);
+
+        vtx2vtx.count(vid0);
+        vtx2vtx.count(vid1);
+        vtx2edg.count(vid0);
+        vtx2edg.count(vid1);
+        edg2tri.count(eid, end - beg);
+
+        for(size_t i=beg; i<end; ++i) tri2edg.count(hedges[i] / 3);
+
+        if (end - beg == 2)
+        {
+            tri2tri.count(hedges[beg]   / 3);
+            tri2tri.count(hedges[beg+1] / 3);
         }
+
+        beg = end;
     }
 
-    edg2tri.resize(edge_tri_map.size());
-    tri2edg.resize(num_triangles());
-    tri2tri.resize(num_triangles());
-    vtx2vtx.resize(num_vertices());
-    vtx2edg.resize(num_vertices());
+    vtx2vtx.alloc();
+    vtx2edg.alloc();
+    edg2tri.alloc();
+    tri2edg.alloc();
+    tri2tri.alloc();
 
-    int fresh_id = 0;
-    for(mymap::iterator it=edge_tri_map.begin(); it!=edge_tri_map.end(); ++it)
+    // second sweep: fill the relations
+    //
+    eid = 0;
+    for(size_t beg=0; beg<keys.size(); ++eid)
     {
-        ipair e    = it->first;
-        int  eid  = fresh_id++;
-        int  vid0 = e.first;
-        int  vid1 = e.second;
+        size_t end = beg + 1;
+        while (end < keys.size() && keys[end] == keys[beg]) ++end;
+
+        int vid0 = keys[beg] / uint64_t(nv);
+        int vid1 = keys[beg] % uint64_t(nv);
 
         edges.push_back(vid0);
         edges.push_back(vid1);
 
-        vtx2vtx[vid0].push_back(vid1);
-        vtx2vtx[vid1].push_back(vid0);
+        vtx2vtx.insert(vid0, vid1);
+        vtx2vtx.insert(vid1, vid0);
 
-        vtx2edg[vid0].push_back(eid);
-        vtx2edg[vid1].push_back(eid);
+        vtx2edg.insert(vid0, eid);
+        vtx2edg.insert(vid1, eid);
 
-        std::vector<int> tids = it->second;
-        //assert(tids.size() <= 2 && "Non manifold edge!");
-        //assert(tids.size() >= 1 && "Non manifold edge!");
-        //if (tids.size() > 2 || tids.size() < 1) cerr << "Non manifold edge! " << edge_vertex(eid, 0) << "\t" << edge_vertex(eid, 1) << endl;
+        //assert(end-beg <= 2 && "Non manifold edge!");
+        //if (end-beg > 2) cerr << "Non manifold edge! " << edge_vertex(eid, 0) << "\t" << edge_vertex(eid, 1) << endl;
 
-        for(int i=0; i<(int)tids.size(); ++i)
+        for(size_t i=beg; i<end; ++i)
         {
-            int tid = tids[i];
+            int tid = hedges[i] / 3;
 
-            tri2edg[tid].push_back(eid);
-            edg2tri[eid].push_back(tid);
+            tri2edg.insert(tid, eid);
+            edg2tri.insert(eid, tid);
         }
-        if (tids.size() == 2)
+        if (end - beg == 2)
         {
-            tri2tri[tids[0]].push_back(tids[1]);
-            tri2tri[tids[1]].push_back(tids[0]);
-            assert(tri2tri[tids[0]].size() <= 3);
-            assert(tri2tri[tids[1]].size() <= 3);
+            int tid0 = hedges[beg]   / 3;
+            int tid1 = hedges[beg+1] / 3;
+            tri2tri.insert(tid0, tid1);
+            tri2tri.insert(tid1, tid0);
         }
+
+        beg = end;
     }
 
+    valid |= EDGES;
+
     logger << num_vertices()  << "\tvertices"  << endl;
     logger << num_triangles() << "\ttriangles" << endl;
     logger << num_edges()     << "\tedges"     << endl;
@@ -163,55 +268,217 @@ void Trimesh::update_adjacency()
     timer_stop("Build adjacency");
 }
 
+CAX_INLINE
+void Trimesh::build_hedges() const
+{
+    require(EDGES);
+
+    int nt = num_triangles();
+
+    he_twin.assign(3*nt, -1);
+    he2edg.assign(3*nt, -1);
+
+    for(int tid=0; tid<nt; ++tid)
+    for(int off=0; off<3; ++off)
+    {
+        int   hid = 3*tid + off;
+        ipair e   = unique_pair(hedge_source(hid), hedge_target(hid));
+
+        for(int eid : tri2edg.row(tid))
+        {
+            if ((int)edges[2*eid] == e.first && (int)edges[2*eid+1] == e.second)
+            {
+                he2edg[hid] = eid;
+                break;
+            }
+        }
+    }
+
+    valid |= HEDGES;
+
+    for(int eid=0; eid<(int)edges.size()/2; ++eid) update_twins(eid);
+}
+
+CAX_INLINE
+void Trimesh::update_twins(const int eid) const
+{
+    // twins are defined only for manifold edges
+    //
+    AdjacencyView tids = edg2tri.row(eid);
+    int hids[2] = { -1, -1 };
+
+    for(int i=0; i<(int)tids.size(); ++i)
+    for(int off=0; off<3; ++off)
+    {
+        int hid = 3*tids[i] + off;
+        if (he2edg[hid] != eid) continue;
+        he_twin[hid] = -1;
+        if (i < 2) hids[i] = hid;
+    }
+
+    if (tids.size() == 2 && hids[0] >= 0 && hids[1] >= 0)
+    {
+        he_twin[hids[0]] = hids[1];
+        he_twin[hids[1]] = hids[0];
+    }
+}
+
+CAX_INLINE
+int Trimesh::edge_id(const int vid0, const int vid1) const
+{
+    require(EDGES);
+
+    ipair e = unique_pair(vid0, vid1);
+    for(int eid : vtx2edg.row(e.first))
+    {
+        if ((int)edges[2*eid] == e.first && (int)edges[2*eid+1] == e.second) return eid;
+    }
+    return -1;
+}
+
+CAX_INLINE
+void Trimesh::print_memory_footprint() const
+{
+    size_t tot = 0;
+    auto print = [&tot](const char * name, const size_t bytes)
+    {
+        logger << name << "\t" << double(bytes) / (1024.0 * 1024.0) << " MB" << endl;
+        tot += bytes;
+    };
+
+    print("coords ", coords.capacity()  * sizeof(double));
+    print("tris   ", tris.capacity()    * sizeof(u_int));
+    print("edges  ", edges.capacity()   * sizeof(u_int));
+    print("v_norm ", v_norm.capacity()  * sizeof(double));
+    print("t_norm ", t_norm.capacity()  * sizeof(double));
+    print("u_text ", u_text.capacity()  * sizeof(float));
+    print("t_label", t_label.capacity() * sizeof(int));
+    print("vtx2vtx", vtx2vtx.memory_footprint());
+    print("vtx2edg", vtx2edg.memory_footprint());
+    print("vtx2tri", vtx2tri.memory_footprint());
+    print("edg2tri", edg2tri.memory_footprint());
+    print("tri2edg", tri2edg.memory_footprint());
+    print("tri2tri", tri2tri.memory_footprint());
+    print("he_twin", he_twin.capacity() * sizeof(int));
+    print("he2edg ", he2edg.capacity()  * sizeof(int));
+    print("hull   ", hull_vids.capacity() * sizeof(int));
+    print("v_ann  ", vertex_ann.capacity()   * sizeof(VertexAnnotations));
+    print("t_ann  ", triangle_ann.capacity() * sizeof(TriangleAnnotations));
+
+    logger << "total  \t" << double(tot) / (1024.0 * 1024.0) << " MB" << endl;
+
+    if (coords.is_borrowed() || tris.is_borrowed())
+    {
+        logger << "(plus " << double(coords.size() * sizeof(double) + tris.size() * sizeof(u_int)) / (1024.0 * 1024.0)
+               << " MB of coords and tris mapped from " << filename << ")" << endl;
+    }
+}
+
 CAX_INLINE
 void Trimesh::update_t_normals()
+{
+    build_t_normals();
+}
+
+CAX_INLINE
+void Trimesh::update_v_normals()
+{
+    build_v_normals();
+}
+
+CAX_INLINE
+void Trimesh::update_bbox()
+{
+    build_bbox();
+}
+
+CAX_INLINE
+void Trimesh::build_t_normals() const
 {
     t_norm.clear();
     t_norm.resize(num_triangles()*3);
 
-    for(int tid=0; tid<num_triangles(); ++tid)
+    parallel_blocks(0, num_triangles(), [this](const int beg, const int end)
     {
-        int tid_ptr = tid * 3;
+        for(int tid=beg; tid<end; ++tid) build_t_normal(tid);
+    });
+
+    valid |= T_NORMALS;
+}
+
+CAX_INLINE
+void Trimesh::build_t_normal(const int tid) const
+{
+    int tid_ptr = tid * 3;
 
-        vec3d v0 = vertex(tris[tid_ptr+0]);
-        vec3d v1 = vertex(tris[tid_ptr+1]);
-        vec3d v2 = vertex(tris[tid_ptr+2]);
+    vec3d v0 = vertex(tris[tid_ptr+0]);
+    vec3d v1 = vertex(tris[tid_ptr+1]);
+    vec3d v2 = vertex(tris[tid_ptr+2]);
 
-        vec3d u = v1 - v0;    u.normalize();
-        vec3d v = v2 - v0;    v.normalize();
-        vec3d n = u.cross(v); n.normalize();
+    vec3d u = v1 - v0;    u.normalize();
+    vec3d v = v2 - v0;    v.normalize();
+    vec3d n = u.cross(v); n.normalize();
 
-        t_norm[tid_ptr + 0] = n.x();
-        t_norm[tid_ptr + 1] = n.y();
-        t_norm[tid_ptr + 2] = n.z();
-    }
+    t_norm[tid_ptr + 0] = n.x();
+    t_norm[tid_ptr + 1] = n.y();
+    t_norm[tid_ptr + 2] = n.z();
 }
 
 CAX_INLINE
-void Trimesh::update_v_normals()
+void Trimesh::build_v_normals() const
 {
+    require(VTX2TRI | T_NORMALS);
+
     v_norm.clear();
     v_norm.resize(num_vertices()*3);
 
-    for(int vid=0; vid<num_vertices(); ++vid)
+    parallel_blocks(0, num_vertices(), [this](const int beg, const int end)
     {
-        std::vector<int> nbrs = adj_vtx2tri(vid);
+        for(int vid=beg; vid<end; ++vid) build_v_normal(vid);
+    });
 
-        vec3d sum(0,0,0);
-        for(int i=0; i<(int)nbrs.size(); ++i)
-        {
-            sum += triangle_normal(nbrs[i]);
-        }
+    valid |= V_NORMALS;
+}
 
-        //assert(nbrs.size() > 0);
-        sum /= nbrs.size();
-        sum.normalize();
+CAX_INLINE
+void Trimesh::build_v_normal(const int vid) const
+{
+    AdjacencyView nbrs = vtx2tri.row(vid);
 
-        int vid_ptr = vid * 3;
-        v_norm[vid_ptr + 0] = sum.x();
-        v_norm[vid_ptr + 1] = sum.y();
-        v_norm[vid_ptr + 2] = sum.z();
+    vec3d sum(0,0,0);
+    for(int i=0; i<(int)nbrs.size(); ++i)
+    {
+        int tid_ptr = nbrs[i] * 3;
+        sum += vec3d(t_norm[tid_ptr + 0], t_norm[tid_ptr + 1], t_norm[tid_ptr + 2]);
     }
+
+    //assert(nbrs.size() > 0);
+    sum /= nbrs.size();
+    sum.normalize();
+
+    int vid_ptr = vid * 3;
+    v_norm[vid_ptr + 0] = sum.x();
+    v_norm[vid_ptr + 1] = sum.y();
+    v_norm[vid_ptr + 2] = sum.z();
+}
+
+CAX_INLINE
+void Trimesh::open_view(const char * filename)
+{
+    timer_start("Load Trimesh");
+
+    clear();
+
+    map_CAX(filename, coords, tris, glob_ann, vertex_ann, triangle_ann);
+
+    logger << tris.size() / 3   << " triangles mapped" << endl;
+    logger << coords.size() / 3 << " vertices  mapped" << endl;
+
+    this->filename = std::string(filename);
+
+    init(true);
+
+    timer_stop("Load Trimesh");
 }
 
 CAX_INLINE
@@ -221,22 +488,31 @@ void Trimesh::load(const char * filename)
 
     clear();
 
+    std::vector<double> xyz;
+    std::vector<u_int>  tri;
+
     std::string str(filename);
     std::string filetype = str.substr(str.size()-3,3);
 
     if (filetype.compare("zip") == 0 ||
         filetype.compare("ZIP") == 0)
     {
-        read_ZIP(str.substr(0, str.size()-3).append(std::string("zip")).c_str(), coords, tris, glob_ann, vertex_ann, triangle_ann);
+        read_ZIP(str.substr(0, str.size()-3).append(std::string("zip")).c_str(), xyz, tri, glob_ann, vertex_ann, triangle_ann);
+    }
+    else
+    if (filetype.compare("cax") == 0 ||
+        filetype.compare("CAX") == 0)
+    {
+        read_CAX(filename, xyz, tri, glob_ann, vertex_ann, triangle_ann);
     }
     else
     if (filetype.compare("ann") == 0 ||
         filetype.compare("ANN") == 0)
     {
-        read_OFF(str.substr(0, str.size()-3).append(std::string("off")).c_str(), coords, tris);
+        read_OFF(str.substr(0, str.size()-3).append(std::string("off")).c_str(), xyz, tri);
 
-        vertex_ann.resize(coords.size() / 3);
-        triangle_ann.resize(tris.size() / 3);
+        vertex_ann.resize(xyz.size() / 3);
+        triangle_ann.resize(tri.size() / 3);
 
         read_ANN(filename, glob_ann, vertex_ann, triangle_ann);
     }
@@ -244,26 +520,35 @@ void Trimesh::load(const char * filename)
     if (filetype.compare("off") == 0 ||
         filetype.compare("OFF") == 0)
     {
-        read_OFF(filename, coords, tris);
+        read_OFF(filename, xyz, tri);
     }
     else
     if (filetype.compare("obj") == 0 ||
         filetype.compare("OBJ") == 0)
     {
-        read_OBJ(filename, coords, tris);
+        read_OBJ(filename, xyz, tri);
+    }
+    else
+    if (filetype.compare("stl") == 0 ||
+        filetype.compare("STL") == 0)
+    {
+        read_STL(filename, xyz, tri);
     }
     else
     if (filetype.compare(".iv") == 0 ||
         filetype.compare(".IV") == 0)
     {
-        read_IV(filename, coords, tris, t_label);
+        read_IV(filename, xyz, tri, t_label);
     }
     else
     {
         std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : load() : file format not supported yet " << endl;
-        exit(-1);
+        read_error();
     }
 
+    coords.swap(xyz);
+    tris.swap(tri);
+
     logger << tris.size() / 3   << " triangles read" << endl;
     logger << coords.size() / 3 << " vertices  read" << endl;
 
@@ -273,7 +558,9 @@ void Trimesh::load(const char * filename)
 }
 
 CAX_INLINE
-void Trimesh::save(const char * filename) const
+void Trimesh::save(const char            * filename,
+                   const ZipCompression    compression,
+                   const AnnListEncoding   ann_encoding) const
 {
     timer_start("Save Trimesh");
 
@@ -283,33 +570,39 @@ void Trimesh::save(const char * filename) const
     if (filetype.compare("zip") == 0 ||
         filetype.compare("ZIP") == 0)
     {
-        write_ZIP(str.substr(0, str.size()-3).c_str(), coords, tris, glob_ann, vertex_ann, triangle_ann);
+        write_ZIP(str.substr(0, str.size()-3).c_str(), coords.data(), coords.size(), tris.data(), tris.size(), glob_ann, vertex_ann, triangle_ann, compression, ann_encoding);
+    }
+    else
+    if (filetype.compare("cax") == 0 ||
+        filetype.compare("CAX") == 0)
+    {
+        write_CAX(filename, coords.data(), coords.size(), tris.data(), tris.size(), glob_ann, vertex_ann, triangle_ann);
     }
     else
     if (filetype.compare("ann") == 0 ||
         filetype.compare("ANN") == 0)
     {
-        write_OFF(str.substr(0, str.size()-3).append(std::string("off")).c_str(), coords, tris);
+        write_OFF(str.substr(0, str.size()-3).append(std::string("off")).c_str(), coords.data(), coords.size(), tris.data(), tris.size());
 
-        write_ANN(filename, glob_ann, vertex_ann, triangle_ann);
+        write_ANN(filename, glob_ann, vertex_ann, triangle_ann, ann_encoding);
     }
     else
     if (filetype.compare("off") == 0 ||
         filetype.compare("OFF") == 0)
     {
-        write_OFF(filename, coords, tris);
+        write_OFF(filename, coords.data(), coords.size(), tris.data(), tris.size());
     }
     else
     if (filetype.compare("obj") == 0 ||
         filetype.compare("OBJ") == 0)
     {
-        write_OBJ(filename, coords, tris);
+        write_OBJ(filename, coords.data(), coords.size(), tris.data(), tris.size());
     }
     else
     if (filetype.compare("stl") == 0 ||
         filetype.compare("STL") == 0)
     {
-        write_STL(filename, coords, tris);
+        write_STL(filename, coords.data(), coords.size(), tris.data(), tris.size());
 
         //export_STL(filename, coords, tris, bb, glob_ann);
     }
@@ -336,7 +629,7 @@ void Trimesh::export_mesh(const char * filename) const
     if (filetype.compare("stl") == 0 ||
         filetype.compare("STL") == 0)
     {
-        export_STL(str.substr(0, str.size()-3).c_str(), coords, tris, bb, glob_ann);
+        export_STL(filename, coords.data(), coords.size(), tris.data(), tris.size(), bbox(), glob_ann);
 
     }
     else
@@ -375,14 +668,9 @@ int Trimesh::vertex_opposite_to(const int eid, const int vid) const
 CAX_INLINE
 int Trimesh::edge_opposite_to(const int tid, const int vid) const
 {
-    assert(triangle_contains_vertex(tid, vid));
-    std::vector<int> edges = adj_tri2edg(tid);
-    for(int i=0; i<(int)edges.size(); ++i)
-    {
-        int eid = edges[i];
-        if (edge_vertex_id(eid, 0) != vid && edge_vertex_id(eid, 1) != vid) return eid;
-    }
-    assert(false);
+    int hid = hedge_from(tid, vid);
+    assert(hid >= 0);
+    return hedge_edge(hedge_next(hid));
 }
 
 CAX_INLINE
@@ -416,7 +704,7 @@ double Trimesh::element_mass(const int tid) const
 CAX_INLINE
 double Trimesh::vertex_mass(const int vid) const
 {
-    std::vector<int> tris = adj_vtx2tri(vid);
+    AdjacencyView tris = adj_vtx2tri(vid);
     double mass = 0.0;
     for(int i=0; i<(int)tris.size(); ++i)
     {
@@ -430,7 +718,7 @@ double Trimesh::vertex_mass(const int vid) const
 CAX_INLINE
 bool Trimesh::vertex_is_border(const int vid) const
 {
-    std::vector<int> tris = adj_vtx2tri(vid);
+    AdjacencyView tris = adj_vtx2tri(vid);
     std::set<int> tri_scalars;
     for(int i=0; i<(int)tris.size(); ++i)
     {
@@ -442,7 +730,7 @@ bool Trimesh::vertex_is_border(const int vid) const
 CAX_INLINE
 bool Trimesh::vertex_is_boundary(const int vid) const
 {
-    std::vector<int> edges = adj_vtx2edg(vid);
+    AdjacencyView edges = adj_vtx2edg(vid);
     for(int i=0; i<(int)edges.size(); ++i)
     {
         if (edge_is_boundary(edges[i])) return true;
@@ -487,27 +775,85 @@ std::vector<std::pair<int,int> > Trimesh::get_boundary_edges() const
 }
 
 CAX_INLINE
-void Trimesh::update_bbox()
+void Trimesh::build_bbox() const
 {
     bb.reset();
-    for(int vid=0; vid<num_vertices(); ++vid)
+
+    // the hull (if any) has all the extreme vertices
+    //
+    if (valid & CONVEX_HULL)
+    {
+        for(int vid : hull_vids)
+        {
+            vec3d v = vertex(vid);
+            bb.min = bb.min.min(v);
+            bb.max = bb.max.max(v);
+        }
+    }
+    else bb = parallel_reduce(0, num_vertices(), Bbox(), [this](const int beg, const int end)
+    {
+        Bbox b;
+        for(int vid=beg; vid<end; ++vid)
+        {
+            vec3d v = vertex(vid);
+            b.min = b.min.min(v);
+            b.max = b.max.max(v);
+        }
+        return b;
+    },
+    [](Bbox a, const Bbox & b)
+    {
+        a.min = a.min.min(b.min);
+        a.max = a.max.max(b.max);
+        return a;
+    });
+
+    valid |= BBOX;
+}
+
+CAX_INLINE
+void Trimesh::build_convex_hull() const
+{
+    timer_start("Build convex hull");
+
+    hull_vids.clear();
+    std::vector<u_int> hull_tris;
+    convex_hull(coords.data(), num_vertices(), hull_vids, hull_tris);
+
+    valid |= CONVEX_HULL;
+
+    logger << hull_vids.size() << "\tvertices on the convex hull" << endl;
+
+    timer_stop("Build convex hull");
+}
+
+CAX_INLINE
+void Trimesh::extent_along(const vec3d & dir, double & min, double & max) const
+{
+    require(CONVEX_HULL);
+
+    min =  FLT_MAX;
+    max = -FLT_MAX;
+    for(int vid : hull_vids)
     {
-        vec3d v = vertex(vid);
-        bb.min = bb.min.min(v);
-        bb.max = bb.max.max(v);
+        double d = dir.dot(vertex(vid));
+        min = std::min(min, d);
+        max = std::max(max, d);
     }
 }
 
 CAX_INLINE
 void Trimesh::translate(const vec3d & delta)
 {
+    int was_valid = valid;
     for(int vid=0; vid<num_vertices(); ++vid)
     {
         vec3d pos = vertex(vid);
         pos += delta;
         set_vertex(vid, pos);
     }
-    update_bbox();
+    valid |= was_valid & (T_NORMALS | V_NORMALS | CONVEX_HULL);
+    require(was_valid);
 }
 
 CAX_INLINE
@@ -515,8 +861,9 @@ void Trimesh::rotate(const vec3d & axis, const double angle)
 {
     double R[3][3];
     bake_rotation_matrix(axis, angle, R);
-    vec3d c = bb.center();
+    vec3d c = bbox().center();
 
+    int was_valid = valid;
     for(int vid=0; vid<num_vertices(); ++vid)
     {
         vec3d pos = vertex(vid) - c;
@@ -524,30 +871,37 @@ void Trimesh::rotate(const vec3d & axis, const double angle)
         pos += c;
         set_vertex(vid, pos);
     }
-    update_bbox();
-    update_normals();
+    valid |= was_valid & CONVEX_HULL;
+    require(was_valid);
 }
 
 CAX_INLINE
 void Trimesh::rotate(const double R[3][3])
 {
+    int was_valid = valid;
     for(int vid=0; vid<num_vertices(); ++vid)
     {
         vec3d pos = vertex(vid);
         transform(pos, R);
         set_vertex(vid, pos);
     }
-    update_bbox();
-    update_normals();
+    valid |= was_valid & CONVEX_HULL;
+    require(was_valid);
 }
 
 
 CAX_INLINE
 void Trimesh::operator+=(const Trimesh & m)
 {
+    // merge whatever is up to date in this mesh. Everything else will be
+    // computed on demand
+    //
+    int keep = valid;
+    m.require(keep);
+
     int nv = num_vertices();
     int nt = num_triangles();
-    int ne = num_edges();
+    int ne = edges.size() / 2;
 
     for(int tid=0; tid<m.num_triangles(); ++tid)
     {
@@ -556,28 +910,22 @@ void Trimesh::operator+=(const Trimesh & m)
         tris.push_back(nv + m.triangle_vertex_id(tid,2));
 
         t_label.push_back(m.triangle_label(tid));
-
-        vec3d n = m.triangle_normal(tid);
-        t_norm.push_back(n.x());
-        t_norm.push_back(n.y());
-        t_norm.push_back(n.z());
-
-        std::vector<int> tmp;
-        for(int eid : m.tri2edg[tid]) tmp.push_back(ne + eid);
-        tri2edg.push_back(tmp);
-
-        tmp.clear();
-        for(int tid : m.tri2tri[tid]) tmp.push_back(nt + tid);
-        tri2tri.push_back(tmp);
     }
-    for(int eid=0; eid<m.num_edges(); ++eid)
+    if (triangle_ann.size() == (size_t)nt)
     {
-        edges.push_back(nv + m.edge_vertex_id(eid,0));
-        edges.push_back(nv + m.edge_vertex_id(eid,1));
-
-        std::vector<int> tmp;
-        for(int tid : m.edg2tri[eid]) tmp.push_back(nt + tid);
-        edg2tri.push_back(tmp);
+        if (m.triangle_ann.size() == (size_t)m.num_triangles())
+        {
+            triangle_ann.insert(triangle_ann.end(), m.triangle_ann.begin(), m.triangle_ann.end());
+        }
+        else triangle_ann.resize(num_triangles());
+    }
+    if (vertex_ann.size() == (size_t)nv)
+    {
+        if (m.vertex_ann.size() == (size_t)m.num_vertices())
+        {
+            vertex_ann.insert(vertex_ann.end(), m.vertex_ann.begin(), m.vertex_ann.end());
+        }
+        else if (nv > 0) vertex_ann.resize(nv + m.num_vertices());
     }
     for(int vid=0; vid<m.num_vertices(); ++vid)
     {
@@ -587,26 +935,104 @@ void Trimesh::operator+=(const Trimesh & m)
         coords.push_back(pos.z());
 
         u_text.push_back(m.vertex_u_text(vid));
+    }
+
+    if (keep & BBOX)
+    {
+        bb.min = bb.min.min(m.bb.min);
+        bb.max = bb.max.max(m.bb.max);
+    }
+    if (keep & T_NORMALS)
+    {
+        t_norm.insert(t_norm.end(), m.t_norm.begin(), m.t_norm.end());
+    }
+    if (keep & V_NORMALS)
+    {
+        v_norm.insert(v_norm.end(), m.v_norm.begin(), m.v_norm.end());
+    }
+    if (keep & VTX2TRI)
+    {
+        vtx2tri.append(m.vtx2tri, nt);
+    }
+    if (keep & EDGES)
+    {
+        for(size_t i=0; i<m.edges.size(); ++i) edges.push_back(nv + m.edges[i]);
 
-        vec3d n = m.vertex_normal(vid);
-        v_norm.push_back(n.x());
-        v_norm.push_back(n.y());
-        v_norm.push_back(n.z());
+        vtx2vtx.append(m.vtx2vtx, nv);
+        vtx2edg.append(m.vtx2edg, ne);
+        edg2tri.append(m.edg2tri, nt);
+        tri2edg.append(m.tri2edg, ne);
+        tri2tri.append(m.tri2tri, nt);
+    }
+    if (keep & HEDGES)
+    {
+        for(size_t i=0; i<m.he_twin.size(); ++i) he_twin.push_back(m.he_twin[i] < 0 ? -1 : 3*nt + m.he_twin[i]);
+        for(size_t i=0; i<m.he2edg.size();  ++i) he2edg.push_back(ne + m.he2edg[i]);
+    }
+
+    valid = keep & ~CONVEX_HULL;
+}
+
+CAX_INLINE
+void Trimesh::remove_duplicated_vertices(const double eps)
+{
+    timer_start("Remove duplicated vertices from trimesh");
 
-        std::vector<int> tmp;
-        for(int eid : m.vtx2edg[vid]) tmp.push_back(ne + eid);
-        vtx2edg.push_back(tmp);
+    int nv = num_vertices();
+
+    std::vector<double> new_coords;
+    std::vector<u_int>  map;
+    weld_points(coords.vector(), eps, new_coords, map);
 
-        tmp.clear();
-        for(int tid : m.vtx2tri[vid]) tmp.push_back(nt + tid);
-        vtx2tri.push_back(tmp);
+    // per vertex data comes from the first vertex of each group
+    //
+    int new_nv = new_coords.size() / 3;
+    std::vector<int> first(new_nv, -1);
+    for(int vid=0; vid<nv; ++vid) if (first[map[vid]] < 0) first[map[vid]] = vid;
 
-        tmp.clear();
-        for(int nbr : m.vtx2vtx[vid]) tmp.push_back(nv + nbr);
-        vtx2vtx.push_back(tmp);
+    std::vector<float> new_u_text(new_nv);
+    for(int vid=0; vid<new_nv; ++vid) new_u_text[vid] = u_text[first[vid]];
+    u_text.swap(new_u_text);
+
+    if (vertex_ann.size() == (size_t)nv)
+    {
+        std::vector<VertexAnnotations> new_vertex_ann(new_nv);
+        for(int vid=0; vid<new_nv; ++vid) new_vertex_ann[vid] = vertex_ann[first[vid]];
+        vertex_ann.swap(new_vertex_ann);
     }
 
-    update_bbox();
+    // triangles that collapse are removed, along with their annotations
+    //
+    bool has_ann = (triangle_ann.size() == (size_t)num_triangles());
+    int  nt      = 0;
+    for(int tid=0; tid<num_triangles(); ++tid)
+    {
+        u_int v0 = map[tris[3*tid+0]];
+        u_int v1 = map[tris[3*tid+1]];
+        u_int v2 = map[tris[3*tid+2]];
+
+        if (v0 == v1 || v0 == v2 || v1 == v2) continue;
+
+        tris[3*nt+0] = v0;
+        tris[3*nt+1] = v1;
+        tris[3*nt+2] = v2;
+        t_label[nt]  = t_label[tid];
+        if (has_ann) triangle_ann[nt] = triangle_ann[tid];
+        ++nt;
+    }
+
+    logger << nv - new_nv << " duplicated vertices and " << num_triangles() - nt << " degenerate triangles have been removed" << endl;
+
+    coords.swap(new_coords);
+    tris.resize(3*nt);
+    t_label.resize(nt);
+    if (has_ann) triangle_ann.resize(nt);
+
+    int was_valid = valid;
+    invalidate(ALL | CONVEX_HULL);
+    require(was_valid);
+
+    timer_stop("Remove duplicated vertices from trimesh");
 }
 
 CAX_INLINE
@@ -614,35 +1040,64 @@ void Trimesh::remove_duplicated_triangles()
 {
     timer_start("Remove duplicated triangles from trimesh");
 
-    std::set< std::vector<int> > unique_tris;
-    for(int tid=0; tid<num_triangles(); ++tid)
+    // triangles with the same vertices (in any order) have the same sorted
+    // triple. Sorting them by the two smallest ids groups them in short runs
+    // (one per edge), where the third one tells duplicates apart
+    //
+    int nt = num_triangles();
+
+    std::vector<uint64_t> keys(nt);
+    std::vector<u_int>    order(nt);
+    std::vector<u_int>    third(nt);
+
+    for(int tid=0; tid<nt; ++tid)
     {
-        std::vector<int> tri(3);
-        tri[0] = triangle_vertex_id(tid,0);
-        tri[1] = triangle_vertex_id(tid,1);
-        tri[2] = triangle_vertex_id(tid,2);
-        sort(tri.begin(), tri.end());
-        if (DOES_NOT_CONTAIN(unique_tris, tri))
+        u_int v[3] = { tris[3*tid+0], tris[3*tid+1], tris[3*tid+2] };
+        std::sort(v, v+3);
+        keys[tid]  = (uint64_t(v[0]) << 32) | v[1];
+        third[tid] = v[2];
+        order[tid] = tid;
+    }
+
+    radix_sort(keys, order);
+
+    // the sort is stable: the first triangle of each group is kept
+    //
+    std::vector<bool> keep(nt, true);
+    for(int beg=0, end=0; beg<nt; beg=end)
+    {
+        while (end < nt && keys[end] == keys[beg]) ++end;
+
+        for(int i=beg+1; i<end; ++i)
+        for(int j=beg; j<i && keep[order[i]]; ++j)
         {
-            unique_tris.insert(tri);
+            if (keep[order[j]] && third[order[j]] == third[order[i]]) keep[order[i]] = false;
         }
     }
 
-    std::vector<double> new_coords = coords;
-    std::vector<uint>   new_tris;
-    for(auto tri : unique_tris)
+    bool has_ann = (triangle_ann.size() == (size_t)nt);
+    int  new_nt  = 0;
+    for(int tid=0; tid<nt; ++tid)
     {
-        new_tris.push_back(tri[0]);
-        new_tris.push_back(tri[1]);
-        new_tris.push_back(tri[2]);
+        if (!keep[tid]) continue;
+
+        for(int i=0; i<3; ++i) tris[3*new_nt+i] = tris[3*tid+i];
+        t_label[new_nt] = t_label[tid];
+        if (has_ann) triangle_ann[new_nt] = triangle_ann[tid];
+        ++new_nt;
     }
 
-    logger << (tris.size() - new_tris.size())/3 << " duplicated triangles have been removed" << endl;
+    logger << nt - new_nt << " duplicated triangles have been removed" << endl;
 
-    clear();
-    coords = new_coords;
-    tris   = new_tris;
-    init();
+    tris.resize(3*new_nt);
+    t_label.resize(new_nt);
+    if (has_ann) triangle_ann.resize(new_nt);
+
+    // vertices did not change
+    //
+    int was_valid = valid;
+    invalidate(ALL & ~BBOX);
+    require(was_valid);
 
     timer_stop("Remove duplicated triangles from trimesh");
 }
@@ -684,6 +1139,7 @@ void Trimesh::center_bbox()
 {
     update_bbox();
     vec3d center = bb.center();
+    int was_valid = valid;
     for(int vid=0; vid<num_vertices(); ++vid)
     {
         vec3d pos = vertex(vid) - center;
@@ -691,26 +1147,29 @@ void Trimesh::center_bbox()
     }
     bb.min -= center;
     bb.max -= center;
+    valid = was_valid;
 }
 
 CAX_INLINE
 void Trimesh::normalize_area()
 {
-    double area = 0.0;
-    for(int tid=0; tid<num_triangles(); ++tid)
+    double area = parallel_sum(0, num_triangles(), [this](const int tid)
     {
-        area += element_mass(tid);
-    }
+        return element_mass(tid);
+    });
     if (area < 1e-4)
     {
         std::cerr << "\nWARNING!! Trimesh Area is close to zero: " << area << endl << endl;
         area = 1e-4;
     }
     double s = 1.0 / sqrt(area);
+    int was_valid = valid;
     for(int vid=0; vid<num_vertices(); ++vid)
     {
         set_vertex(vid, vertex(vid) * s);
     }
+    valid |= was_valid & (T_NORMALS | V_NORMALS | CONVEX_HULL);
+    require(was_valid);
 }
 
 CAX_INLINE
@@ -728,23 +1187,21 @@ vec3d Trimesh::element_barycenter(const int tid) const
 CAX_INLINE
 ipair Trimesh::shared_edge(const int tid0, const int tid1) const
 {
-    std::vector<int> shared_vertices;
-
-    int v0 = triangle_vertex_id(tid0, 0);
-    int v1 = triangle_vertex_id(tid0, 1);
-    int v2 = triangle_vertex_id(tid0, 2);
-
-    if (triangle_contains_vertex(tid1,v0)) shared_vertices.push_back(v0);
-    if (triangle_contains_vertex(tid1,v1)) shared_vertices.push_back(v1);
-    if (triangle_contains_vertex(tid1,v2)) shared_vertices.push_back(v2);
-
-    assert(shared_vertices.size() == 2);
-
-    ipair e;
-    e.first  = shared_vertices[0];
-    e.second = shared_vertices[1];
-
-    return e;
+    for(int off=0; off<3; ++off)
+    {
+        int hid = 3*tid0 + off;
+        if (triangle_contains_vertex(tid1, hedge_source(hid)) &&
+            triangle_contains_vertex(tid1, hedge_target(hid)))
+        {
+            // the first vertex is the one with the lowest offset in tid0
+            //
+            ipair e(hedge_source(hid), hedge_target(hid));
+            if (off == 2) std::swap(e.first, e.second);
+            return e;
+        }
+    }
+    assert(false);
+    return ipair(-1,-1);
 }
 
 CAX_INLINE
@@ -803,8 +1260,8 @@ int Trimesh::shared_vertex(const int eid0, const int eid1) const
 CAX_INLINE
 int Trimesh::shared_triangle(const int eid0, const int eid1) const
 {
-    std::vector<int> nbr_e0 = adj_edg2tri(eid0);
-    std::vector<int> nbr_e1 = adj_edg2tri(eid1);
+    AdjacencyView nbr_e0 = adj_edg2tri(eid0);
+    AdjacencyView nbr_e1 = adj_edg2tri(eid1);
 
     for(int i=0; i<(int)nbr_e0.size(); ++i)
     for(int j=0; j<(int)nbr_e1.size(); ++j)
@@ -819,12 +1276,9 @@ int Trimesh::shared_triangle(const int eid0, const int eid1) const
 CAX_INLINE
 int Trimesh::add_vertex(const vec3d & v, const float scalar)
 {
-    int vid = num_vertices();
-    coords.push_back(v.x());
-    coords.push_back(v.y());
-    coords.push_back(v.z());
-    u_text.push_back(scalar);
-    return vid;
+    // whatever is up to date is patched, not rebuilt (see append_vertex())
+    //
+    return append_vertex(v, scalar);
 }
 
 CAX_INLINE
@@ -836,16 +1290,28 @@ void Trimesh::set_triangle(const int tid, const int vid0, const int vid1, const
 
     int tid_ptr = tid * 3;
 
+    // the old vertices of tid lose a triangle: their normals change too
+    //
+    std::vector<int> old_vids(tris.begin() + tid_ptr, tris.begin() + tid_ptr + 3);
+
+    unlink_triangle(tid);
     tris[tid_ptr + 0] = vid0;
     tris[tid_ptr + 1] = vid1;
     tris[tid_ptr + 2] = vid2;
+    link_triangle(tid);
+
+    update_local_normals(std::vector<int>(1, tid));
+    if ((valid & V_NORMALS) && (valid & VTX2TRI))
+    {
+        for(int vid : old_vids) build_v_normal(vid);
+    }
 }
 
 CAX_INLINE
 bool Trimesh::edges_share_same_triangle(const int eid1, const int eid2) const
 {
-    std::vector<int> tris1 = adj_edg2tri(eid1);
-    std::vector<int> tris2 = adj_edg2tri(eid2);
+    AdjacencyView tris1 = adj_edg2tri(eid1);
+    AdjacencyView tris2 = adj_edg2tri(eid2);
 
     for(int i=0; i<(int)tris1.size(); ++i)
     for(int j=0; j<(int)tris2.size(); ++j)
@@ -858,7 +1324,17 @@ bool Trimesh::edges_share_same_triangle(const int eid1, const int eid2) const
 CAX_INLINE
 int Trimesh::triangle_adjacent_along(const int tid, const int vid0, const int vid1) const
 {
-    std::vector<int> nbrs = adj_tri2tri(tid);
+    int hid = hedge_from(tid, vid0);
+    assert(hid >= 0);
+    if (hedge_target(hid) != vid1) hid = hedge_prev(hid);
+    assert(hedge_source(hid) == vid1 || hedge_target(hid) == vid1);
+
+    int twin = hedge_twin(hid);
+    if (twin >= 0) return hedge_triangle(twin);
+
+    // non manifold edge: scan the neighbors
+    //
+    AdjacencyView nbrs = adj_tri2tri(tid);
     for(size_t i=0; i<nbrs.size(); ++i)
     {
         if (triangle_contains_vertex(nbrs[i], vid0) &&
@@ -868,6 +1344,7 @@ int Trimesh::triangle_adjacent_along(const int tid, const int vid0, const int vi
         }
     }
     assert(false);
+    return -1;
 }
 
 CAX_INLINE
@@ -877,48 +1354,59 @@ int Trimesh::add_triangle(const int vid0, const int vid1, const int vid2, const
     assert(vid1 < num_vertices());
     assert(vid2 < num_vertices());
 
-    int tid = num_triangles();
-    tris.push_back(vid0);
-    tris.push_back(vid1);
-    tris.push_back(vid2);
-    t_label.push_back(scalar);
+    // relations and normals that are up to date are patched locally, in
+    // O(valence). Inserting N triangles costs O(N), not N full rebuilds
+    //
+    int tid = append_triangle(vid0, vid1, vid2, scalar);
+    link_triangle(tid);
+    update_local_normals(std::vector<int>(1, tid));
     return tid;
 }
 
 CAX_INLINE
 std::vector<int> Trimesh::adj_vtx2vtx_ordered(const int vid) const
 {
-    std::vector<int> ordered_onering;
-
-    int curr_e  = adj_vtx2edg(vid).front();
-    int curr_v  = vertex_opposite_to(curr_e, vid);
-    int curr_t  = adj_edg2tri(curr_e).front();
-    int start_t = curr_t;
+    require(VTX2TRI | HEDGES);
 
-    logger << "curr_e " << curr_e << endl;
-    logger << "curr_v " << curr_v << endl;
-    logger << "curr_t " << curr_t << endl;
+    std::vector<int> ordered_onering;
 
-    do
+    AdjacencyView tids = vtx2tri.row(vid);
+    if (tids.empty()) return ordered_onering;
+
+    // a fan has at most as many triangles as vid. Counting the steps keeps
+    // the walks finite around non manifold or badly oriented vertices
+    //
+    int max_steps = tids.size();
+
+    // outgoing half edges of vid: next around vid (counterclockwise) is
+    // twin(prev(hid)), previous (clockwise) is next(twin(hid)). Go clockwise
+    // as far as possible first, so that boundary fans are walked from one
+    // end to the other
+    //
+    int start = hedge_from(tids.front(), vid);
+    int hid   = start;
+    for(int step=0; step<max_steps; ++step)
     {
-        logger << "iter" << endl;
-        ordered_onering.push_back(curr_v);
-
-        std::vector<int> adj_tri = adj_edg2tri(curr_e);
-        assert(adj_tri.size() == 2);
+        int twin = he_twin[hid];
+        if (twin < 0 || hedge_next(twin) == start) break;
+        hid = hedge_next(twin);
+    }
 
-        curr_e = edge_opposite_to(curr_t, curr_v);
-        curr_t = (adj_tri[0] == curr_t) ? adj_tri[1] : adj_tri[0];
-        curr_v = vertex_opposite_to(curr_e, vid);
+    int first = hid;
+    for(int step=0; step<max_steps; ++step)
+    {
+        ordered_onering.push_back(hedge_target(hid));
 
-        logger << "-------" << endl;
-        logger << "curr_e " << curr_e << endl;
-        logger << "curr_v " << curr_v << endl;
-        logger << "curr_t " << curr_t << endl;
+        int prev = hedge_prev(hid);
+        if (he_twin[prev] < 0)
+        {
+            ordered_onering.push_back(hedge_source(prev));
+            break;
+        }
+        hid = he_twin[prev];
+        if (hid == first) break;
     }
-    while(curr_t != start_t);
 
-    assert(ordered_onering.size() == adj_vtx2vtx(vid).size());
     return ordered_onering;
 }
 
@@ -973,21 +1461,40 @@ double Trimesh::get_overhangs(const vec3d      & build_dir,
 
     timer_start(msg);
 
-    double sup_area = 0.0;
-    double tot_area = 0.0;
+    // lazy relations cannot be built from multiple threads
+    //
+    require(T_NORMALS);
 
-    for(int tid=0; tid<num_triangles(); ++tid)
-    {
-        vec3d  n     = triangle_normal(tid);
-        double angle = acos(n.dot(build_dir)) * 180.0/M_PI;
-        double area  = element_mass(tid);
-        tot_area += area;
+    typedef std::pair<double,double> Areas; // (sup_area, tot_area)
+
+    std::vector<char> is_overhang(num_triangles(), false);
 
-        if (angle - 90.0 >= angle_thresh_deg)
+    Areas areas = parallel_reduce(0, num_triangles(), Areas(0.0, 0.0), [&](const int beg, const int end)
+    {
+        Areas a(0.0, 0.0);
+        for(int tid=beg; tid<end; ++tid)
         {
-            overhang_tris.push_back(tid);
-            sup_area += area;
+            vec3d  n     = triangle_normal(tid);
+            double angle = acos(n.dot(build_dir)) * 180.0/M_PI;
+            double area  = element_mass(tid);
+            a.second += area;
+
+            if (angle - 90.0 >= angle_thresh_deg)
+            {
+                is_overhang[tid] = true;
+                a.first += area;
+            }
         }
+        return a;
+    },
+    [](const Areas & a, const Areas & b) { return Areas(a.first + b.first, a.second + b.second); });
+
+    double sup_area = areas.first;
+    double tot_area = areas.second;
+
+    for(int tid=0; tid<num_triangles(); ++tid)
+    {
+        if (is_overhang[tid]) overhang_tris.push_back(tid);
     }
 
     timer_stop(msg);
@@ -998,5 +1505,558 @@ double Trimesh::get_overhangs(const vec3d      & build_dir,
     return sup_area/tot_area;
 }
 
+CAX_INLINE
+int Trimesh::append_vertex(const vec3d & pos, const float scalar)
+{
+    int vid = num_vertices();
+
+    coords.push_back(pos.x());
+    coords.push_back(pos.y());
+    coords.push_back(pos.z());
+    u_text.push_back(scalar);
+    invalidate(CONVEX_HULL);
+
+    if (vid > 0 && vertex_ann.size() == (size_t)vid) vertex_ann.push_back(VertexAnnotations());
+
+    if (valid & VTX2TRI) vtx2tri.add_row();
+    if (valid & EDGES)
+    {
+        vtx2vtx.add_row();
+        vtx2edg.add_row();
+    }
+    if (valid & V_NORMALS) v_norm.resize(v_norm.size() + 3, 0.0);
+    if (valid & BBOX)
+    {
+        bb.min = bb.min.min(pos);
+        bb.max = bb.max.max(pos);
+    }
+    return vid;
+}
+
+CAX_INLINE
+int Trimesh::append_triangle(const int vid0, const int vid1, const int vid2, const int label)
+{
+    int tid = num_triangles();
+
+    tris.push_back(vid0);
+    tris.push_back(vid1);
+    tris.push_back(vid2);
+    t_label.push_back(label);
+
+    if (triangle_ann.size() == (size_t)tid) triangle_ann.push_back(TriangleAnnotations());
+
+    if (valid & T_NORMALS) t_norm.resize(t_norm.size() + 3, 0.0);
+    if (valid & EDGES)
+    {
+        tri2edg.add_row();
+        tri2tri.add_row();
+    }
+    if (valid & HEDGES)
+    {
+        he_twin.resize(he_twin.size() + 3, -1);
+        he2edg.resize(he2edg.size()  + 3, -1);
+    }
+    return tid;
+}
+
+CAX_INLINE
+void Trimesh::link_triangle(const int tid)
+{
+    if (valid & VTX2TRI)
+    {
+        for(int off=0; off<3; ++off) vtx2tri.push_back(tris[3*tid+off], tid);
+    }
+
+    if (!(valid & EDGES)) return;
+
+    for(int off=0; off<3; ++off)
+    {
+        int hid  = 3*tid + off;
+        int vid0 = hedge_source(hid);
+        int vid1 = hedge_target(hid);
+        int eid  = edge_id(vid0, vid1);
+
+        if (eid < 0)
+        {
+            ipair e = unique_pair(vid0, vid1);
+            eid = edges.size() / 2;
+            edges.push_back(e.first);
+            edges.push_back(e.second);
+            vtx2vtx.push_back(e.first,  e.second);
+            vtx2vtx.push_back(e.second, e.first);
+            vtx2edg.push_back(e.first,  eid);
+            vtx2edg.push_back(e.second, eid);
+            edg2tri.add_row();
+        }
+
+        // tri2tri connects the triangles of manifold edges only
+        //
+        AdjacencyView nbrs = edg2tri.row(eid);
+        if (nbrs.size() == 1)
+        {
+            int nbr = nbrs[0];
+            tri2tri.push_back(nbr, tid);
+            tri2tri.push_back(tid, nbr);
+        }
+        else if (nbrs.size() == 2)
+        {
+            int nbr0 = nbrs[0];
+            int nbr1 = nbrs[1];
+            tri2tri.remove(nbr0, nbr1);
+            tri2tri.remove(nbr1, nbr0);
+        }
+
+        edg2tri.push_back(eid, tid);
+        tri2edg.push_back(tid, eid);
+
+        if (valid & HEDGES)
+        {
+            he2edg[hid] = eid;
+            update_twins(eid);
+        }
+    }
+}
+
+CAX_INLINE
+void Trimesh::unlink_triangle(const int tid)
+{
+    if (valid & VTX2TRI)
+    {
+        for(int off=0; off<3; ++off) vtx2tri.remove(tris[3*tid+off], tid);
+    }
+
+    if (!(valid & EDGES)) return;
+
+    for(int off=0; off<3; ++off)
+    {
+        int hid = 3*tid + off;
+        int eid = (valid & HEDGES) ? he2edg[hid] : edge_id(hedge_source(hid), hedge_target(hid));
+
+        edg2tri.remove(eid, tid);
+        tri2edg.remove(tid, eid);
+
+        AdjacencyView nbrs = edg2tri.row(eid);
+        int n_nbrs = nbrs.size();
+        if (n_nbrs == 1)
+        {
+            int nbr = nbrs[0];
+            tri2tri.remove(nbr, tid);
+            tri2tri.remove(tid, nbr);
+        }
+        else if (n_nbrs == 2)
+        {
+            int nbr0 = nbrs[0];
+            int nbr1 = nbrs[1];
+            tri2tri.push_back(nbr0, nbr1);
+            tri2tri.push_back(nbr1, nbr0);
+        }
+
+        if (valid & HEDGES)
+        {
+            he2edg[hid]  = -1;
+            he_twin[hid] = -1;
+        }
+
+        // erasing eid renumbers the last edge, which may be one of the
+        // edges of tid still to be unlinked: erase_edge() updates them too
+        //
+        if (n_nbrs == 0) erase_edge(eid);
+        else if (valid & HEDGES) update_twins(eid);
+    }
+}
+
+CAX_INLINE
+void Trimesh::erase_edge(const int eid)
+{
+    assert(edg2tri.row(eid).empty());
+
+    int vid0 = edges[2*eid];
+    int vid1 = edges[2*eid+1];
+
+    vtx2vtx.remove(vid0, vid1);
+    vtx2vtx.remove(vid1, vid0);
+    vtx2edg.remove(vid0, eid);
+    vtx2edg.remove(vid1, eid);
+
+    int last = edges.size()/2 - 1;
+    if (eid != last)
+    {
+        edges[2*eid]   = edges[2*last];
+        edges[2*eid+1] = edges[2*last+1];
+
+        vtx2edg.replace(edges[2*eid],   last, eid);
+        vtx2edg.replace(edges[2*eid+1], last, eid);
+
+        std::vector<int> tids = edg2tri.row(last);
+        edg2tri.set_row(eid, tids);
+
+        for(int tid : tids)
+        {
+            tri2edg.replace(tid, last, eid);
+
+            if (valid & HEDGES)
+            {
+                for(int off=0; off<3; ++off) if (he2edg[3*tid+off] == last) he2edg[3*tid+off] = eid;
+            }
+        }
+    }
+
+    edges.resize(2*last);
+    edg2tri.pop_row();
+}
+
+CAX_INLINE
+void Trimesh::erase_triangle(const int tid)
+{
+    int last = num_triangles() - 1;
+
+    if (tid != last)
+    {
+        for(int off=0; off<3; ++off) tris[3*tid+off] = tris[3*last+off];
+
+        t_label[tid] = t_label[last];
+
+        if (triangle_ann.size() == (size_t)(last+1)) triangle_ann[tid] = triangle_ann[last];
+
+        if (valid & T_NORMALS)
+        {
+            for(int i=0; i<3; ++i) t_norm[3*tid+i] = t_norm[3*last+i];
+        }
+        if (valid & VTX2TRI)
+        {
+            for(int off=0; off<3; ++off) vtx2tri.replace(tris[3*tid+off], last, tid);
+        }
+        if (valid & EDGES)
+        {
+            std::vector<int> eids = tri2edg.row(last);
+            tri2edg.set_row(tid, eids);
+            for(int eid : eids) edg2tri.replace(eid, last, tid);
+
+            std::vector<int> nbrs = tri2tri.row(last);
+            tri2tri.set_row(tid, nbrs);
+            for(int nbr : nbrs) tri2tri.replace(nbr, last, tid);
+        }
+        if (valid & HEDGES)
+        {
+            for(int off=0; off<3; ++off)
+            {
+                int hid  = 3*tid + off;
+                int twin = he_twin[3*last+off];
+                if (twin >= 0 && hedge_triangle(twin) == last) twin = 3*tid + twin%3;
+
+                he_twin[hid] = twin;
+                he2edg[hid]  = he2edg[3*last+off];
+                if (twin >= 0) he_twin[twin] = hid;
+            }
+        }
+    }
+
+    tris.resize(3*last);
+    t_label.resize(last);
+
+    if (triangle_ann.size() == (size_t)(last+1)) triangle_ann.resize(last);
+
+    if (valid & T_NORMALS) t_norm.resize(3*last);
+    if (valid & EDGES)
+    {
+        tri2edg.pop_row();
+        tri2tri.pop_row();
+    }
+    if (valid & HEDGES)
+    {
+        he_twin.resize(3*last);
+        he2edg.resize(3*last);
+    }
+}
+
+CAX_INLINE
+void Trimesh::erase_vertex(const int vid)
+{
+    int last = num_vertices() - 1;
+
+    invalidate(CONVEX_HULL);
+
+    if (vid != last)
+    {
+        for(int i=0; i<3; ++i) coords[3*vid+i] = coords[3*last+i];
+
+        u_text[vid] = u_text[last];
+
+        if (vertex_ann.size() == (size_t)(last+1)) vertex_ann[vid] = vertex_ann[last];
+
+        if (valid & V_NORMALS)
+        {
+            for(int i=0; i<3; ++i) v_norm[3*vid+i] = v_norm[3*last+i];
+        }
+
+        if (valid & VTX2TRI)
+        {
+            std::vector<int> tids = vtx2tri.row(last);
+            vtx2tri.set_row(vid, tids);
+            for(int tid : tids)
+            for(int off=0; off<3; ++off) if ((int)tris[3*tid+off] == last) tris[3*tid+off] = vid;
+        }
+        else
+        {
+            for(size_t i=0; i<tris.size(); ++i) if ((int)tris[i] == last) tris[i] = vid;
+        }
+
+        if (valid & EDGES)
+        {
+            std::vector<int> eids = vtx2edg.row(last);
+            vtx2edg.set_row(vid, eids);
+            for(int eid : eids)
+            {
+                for(int i=0; i<2; ++i) if ((int)edges[2*eid+i] == last) edges[2*eid+i] = vid;
+
+                // keep the endpoints sorted, as unique_pair() does
+                //
+                if (edges[2*eid] > edges[2*eid+1]) std::swap(edges[2*eid], edges[2*eid+1]);
+            }
+
+            std::vector<int> nbrs = vtx2vtx.row(last);
+            vtx2vtx.set_row(vid, nbrs);
+            for(int nbr : nbrs) vtx2vtx.replace(nbr, last, vid);
+        }
+    }
+
+    coords.resize(3*last);
+    u_text.resize(last);
+
+    if (vertex_ann.size() == (size_t)(last+1)) vertex_ann.resize(last);
+
+    if (valid & V_NORMALS) v_norm.resize(3*last);
+    if (valid & VTX2TRI) vtx2tri.pop_row();
+    if (valid & EDGES)
+    {
+        vtx2vtx.pop_row();
+        vtx2edg.pop_row();
+    }
+}
+
+CAX_INLINE
+void Trimesh::update_local_normals(const std::vector<int> & tids)
+{
+    if (!(valid & T_NORMALS))
+    {
+        invalidate(V_NORMALS);
+        return;
+    }
+
+    for(int tid : tids) build_t_normal(tid);
+
+    if (!(valid & V_NORMALS)) return;
+
+    if (!(valid & VTX2TRI))
+    {
+        invalidate(V_NORMALS);
+        return;
+    }
+
+    for(int tid : tids)
+    for(int off=0; off<3; ++off)
+    {
+        build_v_normal(tris[3*tid+off]);
+    }
+}
+
+CAX_INLINE
+int Trimesh::flip_edge(const int eid)
+{
+    require(VTX2TRI | EDGES | HEDGES);
+
+    if (edg2tri.row(eid).size() != 2) return -1;
+
+    int tid0 = edg2tri.row(eid)[0];
+    int tid1 = edg2tri.row(eid)[1];
+    int hid0 = -1;
+    for(int off=0; off<3; ++off) if (he2edg[3*tid0+off] == eid) hid0 = 3*tid0 + off;
+    int hid1 = he_twin[hid0];
+
+    // the triangles must read (a,b,c) and (b,a,d)
+    //
+    if (hid1 < 0 || hedge_source(hid1) != hedge_target(hid0)) return -1;
+
+    int a = hedge_source(hid0);
+    int b = hedge_target(hid0);
+    int c = hedge_source(hedge_prev(hid0));
+    int d = hedge_source(hedge_prev(hid1));
+
+    if (c == d || edge_id(c, d) >= 0) return -1;
+
+    unlink_triangle(tid0);
+    unlink_triangle(tid1);
+
+    // (a,b,c) (b,a,d) => (c,a,d) (d,b,c)
+    //
+    tris[3*tid0+0] = c;  tris[3*tid0+1] = a;  tris[3*tid0+2] = d;
+    tris[3*tid1+0] = d;  tris[3*tid1+1] = b;  tris[3*tid1+2] = c;
+
+    link_triangle(tid0);
+    link_triangle(tid1);
+
+    std::vector<int> changed;
+    changed.push_back(tid0);
+    changed.push_back(tid1);
+    update_local_normals(changed);
+
+    return edge_id(c, d);
+}
+
+CAX_INLINE
+int Trimesh::split_edge(const int eid, const vec3d & pos)
+{
+    require(VTX2TRI | EDGES | HEDGES);
+
+    int vid0 = edges[2*eid];
+    int vid1 = edges[2*eid+1];
+
+    std::vector<int> tids = edg2tri.row(eid);
+
+    int vid = append_vertex(pos, 0.5 * (u_text[vid0] + u_text[vid1]));
+
+    for(int tid : tids) unlink_triangle(tid);
+
+    std::vector<int> changed;
+    for(int tid : tids)
+    {
+        // tid reads (x,y,z), where x->y is the edge being split
+        //
+        int hid = hedge_from(tid, vid0);
+        if (hedge_target(hid) != vid1) hid = hedge_prev(hid);
+
+        int y = hedge_target(hid);
+        int z = hedge_source(hedge_prev(hid));
+
+        // (x,y,z) => (x,vid,z) (vid,y,z)
+        //
+        tris[hedge_next(hid)] = vid;
+        int new_tid = append_triangle(vid, y, z, t_label[tid]);
+        if (triangle_ann.size() == tris.size()/3) triangle_ann[new_tid] = triangle_ann[tid];
+
+        link_triangle(tid);
+        link_triangle(new_tid);
+
+        changed.push_back(tid);
+        changed.push_back(new_tid);
+    }
+
+    update_local_normals(changed);
+
+    return vid;
+}
+
+CAX_INLINE
+int Trimesh::split_triangle(const int tid, const vec3d & pos)
+{
+    require(VTX2TRI | EDGES | HEDGES);
+
+    int a = tris[3*tid+0];
+    int b = tris[3*tid+1];
+    int c = tris[3*tid+2];
+
+    int vid = append_vertex(pos, (u_text[a] + u_text[b] + u_text[c]) / 3.0);
+
+    unlink_triangle(tid);
+
+    // (a,b,c) => (a,b,vid) (b,c,vid) (c,a,vid)
+    //
+    tris[3*tid+2] = vid;
+    int tid1 = append_triangle(b, c, vid, t_label[tid]);
+    int tid2 = append_triangle(c, a, vid, t_label[tid]);
+
+    if (triangle_ann.size() == tris.size()/3)
+    {
+        triangle_ann[tid1] = triangle_ann[tid];
+        triangle_ann[tid2] = triangle_ann[tid];
+    }
+
+    link_triangle(tid);
+    link_triangle(tid1);
+    link_triangle(tid2);
+
+    std::vector<int> changed;
+    changed.push_back(tid);
+    changed.push_back(tid1);
+    changed.push_back(tid2);
+    update_local_normals(changed);
+
+    return vid;
+}
+
+CAX_INLINE
+int Trimesh::collapse_edge(const int eid, const vec3d & pos)
+{
+    require(VTX2TRI | EDGES | HEDGES);
+
+    // vid1 is merged into vid0
+    //
+    int vid0 = edges[2*eid];
+    int vid1 = edges[2*eid+1];
+
+    std::vector<int> dead = edg2tri.row(eid);
+    if (dead.size() > 2) return -1;
+
+    // link condition: the vertices adjacent to both vid0 and vid1 must be
+    // the ones opposite to eid, and interior edges cannot connect two
+    // boundary vertices
+    //
+    std::vector<int> opp;
+    for(int tid : dead) opp.push_back(vertex_opposite_to(tid, vid0, vid1));
+
+    AdjacencyView nbrs0 = vtx2vtx.row(vid0);
+    AdjacencyView nbrs1 = vtx2vtx.row(vid1);
+    for(int vid : nbrs0)
+    {
+        if (vid == vid1) continue;
+        if (std::find(nbrs1.begin(), nbrs1.end(), vid) != nbrs1.end() &&
+            std::find(opp.begin(),   opp.end(),   vid) == opp.end())
+        {
+            return -1;
+        }
+    }
+    if (dead.size() == 2 && vertex_is_boundary(vid0) && vertex_is_boundary(vid1)) return -1;
+
+    std::vector<int> moved;
+    std::vector<int> tids = vtx2tri.row(vid1);
+    for(int tid : tids)
+    {
+        if (std::find(dead.begin(), dead.end(), tid) == dead.end()) moved.push_back(tid);
+    }
+
+    for(int tid : tids) unlink_triangle(tid);
+
+    for(int tid : moved)
+    {
+        tris[hedge_from(tid, vid1)] = vid0;
+        link_triangle(tid);
+    }
+
+    coords[3*vid0+0] = pos.x();
+    coords[3*vid0+1] = pos.y();
+    coords[3*vid0+2] = pos.z();
+    invalidate(CONVEX_HULL);
+
+    // vid0 moved: all the triangles around it changed
+    //
+    std::vector<int> fan = vtx2tri.row(vid0);
+    update_local_normals(fan);
+    if (valid & V_NORMALS)
+    {
+        for(int vid : opp) build_v_normal(vid);
+    }
+
+    std::sort(dead.begin(), dead.end());
+    for(int i=(int)dead.size()-1; i>=0; --i) erase_triangle(dead[i]);
+
+    int last = num_vertices() - 1;
+    erase_vertex(vid1);
+
+    // vid1 may have been on the bounding box
+    //
+    invalidate(BBOX);
+
+    return (vid0 == last) ? vid1 : vid0;
+}
 
 }
@@ -17,6 +17,9 @@
 #include "../bbox.h"
 #include "../vec3.h"
 #include "../common.h"
+#include "../mapped_vector.h"
+#include "../io/write_ZIP.h"
+#include "../adjacency_list.h"
 
 #include "annotations.h"
 
@@ -34,18 +37,41 @@ class Trimesh
 {
     public:
 
-        Trimesh(){}
-
-        Trimesh(const char * filename);
+        // Relations and attributes that can be computed on demand. A lazy
+        // mesh (see init()) builds each of them the first time it is
+        // accessed, and keeps it until the geometry or the connectivity
+        // change. Eager meshes build ALL of them at init(), as usual (the
+        // convex hull is always built on demand).
+        //
+        enum
+        {
+            BBOX      = 0x00000001,
+            VTX2TRI   = 0x00000002,
+            EDGES     = 0x00000004, // edges, vtx2vtx, vtx2edg, edg2tri, tri2edg, tri2tri
+            T_NORMALS = 0x00000008,
+            V_NORMALS = 0x00000010,
+            HEDGES    = 0x00000020, // half edge twins and half edge to edge map (requires EDGES)
+            ALL       = 0x0000003F,
+            CONVEX_HULL = 0x00000040  // ids of the vertices of the convex hull
+        };
+
+        Trimesh() : valid(0) {}
+
+        // a missing or malformed file exits, or throws a ReadError (see
+        // read_errors_throw())
+        //
+        Trimesh(const char * filename, const bool lazy = false);
 
         Trimesh(const std::vector<double> & coords,
-                const std::vector<u_int>  & tris);
+                const std::vector<u_int>  & tris,
+                const bool                  lazy = false);
 
         Trimesh(const std::vector<double>              & coords,
                 const std::vector<u_int>               & tris,
                 const GlobalAnnotations                & glob_ann,
                 const std::vector<VertexAnnotations>   & vertex_ann,
-                const std::vector<TriangleAnnotations> & triangle_ann);
+                const std::vector<TriangleAnnotations> & triangle_ann,
+                const bool                               lazy = false);
 
     protected:
 
@@ -53,18 +79,19 @@ class Trimesh
 
         // bounding box
         //
-        Bbox bb;
+        mutable Bbox bb;
 
-        // serialized xyz coordinates, triangles and edges
+        // serialized xyz coordinates, triangles and edges. Coordinates and
+        // triangles may be borrowed from a mapped file (see open_view())
         //
-        std::vector<double> coords;
-        std::vector<u_int>  tris;
-        std::vector<u_int>  edges;
+        MappedVector<double>        coords;
+        MappedVector<u_int>         tris;
+        mutable std::vector<u_int>  edges;
 
         // per vertex/triangle normals
         //
-        std::vector<double> v_norm;
-        std::vector<double> t_norm;
+        mutable std::vector<double> v_norm;
+        mutable std::vector<double> t_norm;
 
         // general purpose float and int scalars
         //
@@ -73,12 +100,31 @@ class Trimesh
 
         // adjacencies
         //
-        std::vector< std::vector<int> > vtx2vtx;
-        std::vector< std::vector<int> > vtx2edg;
-        std::vector< std::vector<int> > vtx2tri;
-        std::vector< std::vector<int> > edg2tri;
-        std::vector< std::vector<int> > tri2edg;
-        std::vector< std::vector<int> > tri2tri;
+        mutable AdjacencyList vtx2vtx;
+        mutable AdjacencyList vtx2edg;
+        mutable AdjacencyList vtx2tri;
+        mutable AdjacencyList edg2tri;
+        mutable AdjacencyList tri2edg;
+        mutable AdjacencyList tri2tri;
+
+        // half edges. Half edge h = 3 * tid + offset goes from vertex
+        // tris[h] to vertex tris[hedge_next(h)], therefore next, prev and
+        // the source vertex are implicit. Only the twins (-1 along open
+        // boundaries and around non manifold edges) and the edge each half
+        // edge belongs to are stored
+        //
+        mutable std::vector<int> he_twin;
+        mutable std::vector<int> he2edg;
+
+        // vertices of the convex hull. The extreme vertices along any
+        // direction are among them, and they stay the same under rigid
+        // motions and scaling
+        //
+        mutable std::vector<int> hull_vids;
+
+        // relations and attributes (see the enum above) that are up to date
+        //
+        mutable int valid;
 
         // Local and global annotations for CAxMan
         // see annotations.h
@@ -89,6 +135,32 @@ class Trimesh
 
         void load(const char * filename);
 
+        void build(const int what) const;
+        void build_bbox()      const;
+        void build_vtx2tri()   const;
+        void build_edges()     const;
+        void build_t_normals() const;
+        void build_v_normals() const;
+        void build_hedges()    const;
+        void build_convex_hull() const;
+
+        void build_t_normal(const int tid) const;
+        void build_v_normal(const int vid) const;
+
+        // local edits. They patch whatever relation is up to date (and leave
+        // the others out of date). erase_*() expect elements that are no
+        // longer referenced (unlinked triangles, isolated vertices)
+        //
+        int  append_vertex(const vec3d & pos, const float scalar);
+        int  append_triangle(const int vid0, const int vid1, const int vid2, const int label);
+        void link_triangle(const int tid);
+        void unlink_triangle(const int tid);
+        void erase_edge(const int eid);
+        void erase_triangle(const int tid);
+        void erase_vertex(const int vid);
+        void update_twins(const int eid) const;
+        void update_local_normals(const std::vector<int> & tids);
+
     public:
 
         //
@@ -208,40 +280,155 @@ class Trimesh
         // END OF CAXMAN  UTILITIES
         //
 
-        void init();
+        void init(const bool lazy = false);
         void clear();
+
+        // read only view of a CAX file (see map_CAX()). Coordinates and
+        // triangles are used in place from the mapped file, whose pages are
+        // shared with any other process that maps it, so that analyses can
+        // start right away even on huge meshes. Annotations are read as
+        // usual, and relations are built on demand (the mesh is lazy).
+        // Editing the mesh, or asking for vector_coords() or
+        // vector_triangles(), makes a private copy of the arrays first
+        //
+        void open_view(const char * filename);
         void update_adjacency();
         void update_t_normals();
         void update_v_normals();
 
+        // make sure that the relations/attributes in WHAT are up to date.
+        // Lazy evaluation is not thread safe: require() everything a
+        // parallel section will need before entering it
+        //
+        void require(const int what) const
+        {
+            if ((valid & what) != what) build(what & ~valid);
+        }
+
+        // mark the relations/attributes in WHAT as out of date. Mesh editing
+        // methods do it on their own; call it after editing coords/tris
+        // directly (e.g. from a derived class). Half edges refer to edge ids,
+        // so they go together with the edges
+        //
+        void invalidate(const int what) { valid &= ~((what & EDGES) ? (what | HEDGES) : what); }
+
+        bool is_valid(const int what) const { return (valid & what) == what; }
+
+        // log the heap memory used by the mesh arrays and by each relation
+        // (the strings of the extra annotations are not accounted for)
+        //
+        void print_memory_footprint() const;
+
         std::string loaded_file() const { return filename; }
 
         int num_vertices()  const { return coords.size()/3; }
         int num_triangles() const { return tris.size()  /3; }
         int num_elements()  const { return tris.size()  /3; }
-        int num_edges()     const { return edges.size() /2; }
+        int num_edges()     const { require(EDGES); return edges.size() /2; }
+
+        AdjacencyView adj_vtx2vtx(const int vid) const { require(EDGES);   return vtx2vtx.row(vid); }
+        AdjacencyView adj_vtx2edg(const int vid) const { require(EDGES);   return vtx2edg.row(vid); }
+        AdjacencyView adj_vtx2tri(const int vid) const { require(VTX2TRI); return vtx2tri.row(vid); }
+        AdjacencyView adj_edg2tri(const int eid) const { require(EDGES);   return edg2tri.row(eid); }
+        AdjacencyView adj_tri2edg(const int tid) const { require(EDGES);   return tri2edg.row(tid); }
+        AdjacencyView adj_tri2tri(const int tid) const { require(EDGES);   return tri2tri.row(tid); }
+
+        // one ring of VID in counterclockwise order (walks the half edges,
+        // O(valence)). Along open boundaries it goes from one boundary
+        // vertex to the other
+        //
+        std::vector<int> adj_vtx2vtx_ordered(const int vid) const;
 
-        const std::vector<int> & adj_vtx2vtx(const int vid) const { return vtx2vtx.at(vid); }
-        const std::vector<int> & adj_vtx2edg(const int vid) const { return vtx2edg.at(vid); }
-        const std::vector<int> & adj_vtx2tri(const int vid) const { return vtx2tri.at(vid); }
-        const std::vector<int> & adj_edg2tri(const int eid) const { return edg2tri.at(eid); }
-        const std::vector<int> & adj_tri2edg(const int tid) const { return tri2edg.at(tid); }
-        const std::vector<int> & adj_tri2tri(const int tid) const { return tri2tri.at(tid); }
+        //
+        // Half edges (see he_twin)
+        //
 
-        std::vector<int> adj_vtx2vtx_ordered(const int vid) const;
+        int hedge_triangle(const int hid) const { return hid / 3; }
+        int hedge_next    (const int hid) const { return 3 * (hid / 3) + (hid + 1) % 3; }
+        int hedge_prev    (const int hid) const { return 3 * (hid / 3) + (hid + 2) % 3; }
+        int hedge_source  (const int hid) const { return tris[hid]; }
+        int hedge_target  (const int hid) const { return tris[hedge_next(hid)]; }
+        int hedge_twin    (const int hid) const { require(HEDGES); return he_twin[hid]; }
+        int hedge_edge    (const int hid) const { require(HEDGES); return he2edg[hid]; }
 
-        const std::vector<double> & vector_coords()    const { return coords; }
-        const std::vector<u_int>  & vector_triangles() const { return tris;   }
-        const std::vector<u_int>  & vector_edges()     const { return edges;  }
-        const Bbox                & bbox()             const { return bb;     }
+        // half edge of TID that starts from VID (-1 if VID is not in TID)
+        //
+        int hedge_from(const int tid, const int vid) const
+        {
+            for(int off=0; off<3; ++off) if ((int)tris[3*tid+off] == vid) return 3*tid+off;
+            return -1;
+        }
+
+        // id of the edge (VID0,VID1), -1 if there is no such edge
+        //
+        int edge_id(const int vid0, const int vid1) const;
+
+        //
+        // Local edits. They update the mesh, its relations and whatever
+        // normal is up to date without rebuilding anything, and cost
+        // O(valence) each. Elements are never left as holes: new ones go at
+        // the end, and removed ones are replaced with the last element of
+        // their kind, therefore only the ids of the last elements change.
+        //
+
+        // swap the diagonal of the two triangles adjacent to EID. It returns
+        // the id of the new edge, or -1 if EID is not a manifold edge, its
+        // triangles are not consistently oriented or the new edge exists
+        // already. The two triangles keep their ids
+        //
+        int flip_edge(const int eid);
+
+        // add a vertex in POS and split EID and all its triangles at it. Each
+        // triangle of EID keeps its id for the half incident to the vertex its
+        // own half edge along EID starts from (the first vertex of EID if the
+        // triangle runs from it to the second one, the second vertex
+        // otherwise), and one new triangle per each of them is appended for
+        // the other half, in the same order of adj_edg2tri(eid). It returns
+        // the id of the new vertex
+        //
+        int split_edge(const int eid, const vec3d & pos);
+
+        // add a vertex in POS and split TID in three triangles. TID keeps its
+        // id, the other two are appended. It returns the id of the new vertex
+        //
+        int split_triangle(const int tid, const vec3d & pos);
+
+        // merge the endpoints of EID in a single vertex in POS, removing the
+        // triangles of EID. It returns the id of the merged vertex, or -1 if
+        // the collapse would make the mesh non manifold (link condition)
+        //
+        int collapse_edge(const int eid, const vec3d & pos);
+
+        const std::vector<double> & vector_coords()    const { return coords.vector(); }
+        const std::vector<u_int>  & vector_triangles() const { return tris.vector();   }
+        const std::vector<u_int>  & vector_edges()     const { require(EDGES); return edges; }
+        const Bbox                & bbox()             const { require(BBOX);  return bb;    }
+
+        const std::vector<int> & convex_hull_vertices() const { require(CONVEX_HULL); return hull_vids; }
+
+        // range of the projections of the vertices onto DIR (e.g. the height
+        // of the mesh along a build direction). It costs O(hull size)
+        //
+        void extent_along(const vec3d & dir, double & min, double & max) const;
 
         const std::vector<float> & vector_v_float_scalar() const { return u_text; }
         const std::vector<int>   & vector_t_int_scalar() const { return t_label; }
 
-        void save(const char * filename) const;
+        // compression only applies to zip archives, ann_encoding to zip and
+        // ann files (see AnnListEncoding). STL files are binary
+        //
+        void save(const char            * filename,
+                  const ZipCompression    compression  = ZIP_COMPRESSION_DEFAULT,
+                  const AnnListEncoding   ann_encoding = ANN_LISTS_IDS) const;
 
+        // binary STL, rotated by the orientation matrix (see GlobalAnnotations)
+        //
         void export_mesh (const char * filename) const;
 
+        // add_vertex(), add_triangle() and set_triangle() patch relations,
+        // normals and bounding box in place (when they are up to date), so
+        // that meshes can be grown element by element at O(1) amortized cost
+        //
         virtual int add_vertex(const vec3d & v, const float scalar = 0.0);
         virtual int add_triangle(const int vid0, const int vid1, const int vid2, const int scalar);
 
@@ -295,6 +482,7 @@ class Trimesh
 
         vec3d edge_vertex(const int eid, const int offset) const
         {
+            require(EDGES);
             int eid_ptr = eid * 2;
             int vid     = edges[eid_ptr + offset];
             int vid_ptr = vid * 3;
@@ -332,6 +520,7 @@ class Trimesh
 
         int edge_vertex_id(const int eid, const int offset) const
         {
+            require(EDGES);
             int eid_ptr = eid * 2;
             return edges[eid_ptr + offset];
         }
@@ -344,12 +533,14 @@ class Trimesh
 
         vec3d triangle_normal(const int tid) const
         {
+            require(T_NORMALS);
             int tid_ptr = tid * 3;
             return vec3d(t_norm[tid_ptr + 0], t_norm[tid_ptr + 1], t_norm[tid_ptr + 2]);
         }
 
         vec3d vertex_normal(const int vid) const
         {
+            require(V_NORMALS);
             int vid_ptr = vid * 3;
             return vec3d(v_norm[vid_ptr+0], v_norm[vid_ptr+1], v_norm[vid_ptr+2]);
         }
@@ -366,6 +557,7 @@ class Trimesh
             coords[vid_ptr + 0] = pos.x();
             coords[vid_ptr + 1] = pos.y();
             coords[vid_ptr + 2] = pos.z();
+            invalidate(BBOX | T_NORMALS | V_NORMALS | CONVEX_HULL);
         }
 
         int vertex_valence(const int vid) const
@@ -438,21 +630,10 @@ class Trimesh
         int triangle_adjacent_along(const int tid, const int vid0, const int vid1) const;
 
         int triangle_edge_local_to_global(const int tid, const int off) const
-	{
-	    assert(off>=0 && off <=2);
-
-	    int vid0 = triangle_vertex_id(tid, TRI_EDGES[off][0]);
-	    int vid1 = triangle_vertex_id(tid, TRI_EDGES[off][1]);
-
-	    for(int eid : adj_tri2edg(tid))
-	    {
-		if (edge_contains_vertex(eid, vid0) && edge_contains_vertex(eid, vid1))
-		{
-		    return eid;
-		}
-	    }
-	    assert(false && "Something is off here...");
-	}
+        {
+            assert(off>=0 && off <=2);
+            return hedge_edge(3*tid + off);
+        }
 
         vec3d element_barycenter(const int tid) const;
 
@@ -466,16 +647,30 @@ class Trimesh
 
         virtual void operator+=(const Trimesh & m);
 
+        // weld the vertices closer than eps (see weld_points()). Triangles that
+        // collapse are removed. Annotations, labels and texture coordinates
+        // are kept (vertices get the ones of the first vertex they merge)
+        //
         void remove_duplicated_vertices(const double eps = 1e-7);
+
+        // remove the triangles with the same vertices as a previous one (in
+        // any order). Surviving triangles keep their order, orientation,
+        // annotations and labels
+        //
         void remove_duplicated_triangles();
 
         void scale(const float scale_factor)
         {
+            // normals do not change under uniform scaling
+            //
+            int was_valid = valid;
             for(int vid=0; vid<num_vertices(); ++vid)
             {
                 vec3d pos = vertex(vid) * scale_factor;
                 set_vertex(vid, pos);
             }
+            valid |= was_valid & (T_NORMALS | V_NORMALS | CONVEX_HULL);
+            require(was_valid);
         }
 
         int connected_components(std::vector< std::set<int> > & ccs) const;
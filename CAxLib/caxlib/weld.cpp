@@ -0,0 +1,173 @@
+#include "weld.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+
+namespace caxlib
+{
+
+CAX_INLINE
+void weld_points(const std::vector<double> & xyz,
+                 const double                eps,
+                 std::vector<double>       & welded,
+                 std::vector<u_int>        & map)
+{
+    int n = xyz.size() / 3;
+
+    welded.clear();
+    map.resize(n);
+    if (n == 0) return;
+
+    // grid: at most 2^21 cells per axis (cell coordinates are packed in a
+    // 64 bits key), each one not smaller than EPS
+    //
+    const int64_t MAX_CELLS = (int64_t(1) << 21) - 1;
+
+    double min[3] = {  DBL_MAX,  DBL_MAX,  DBL_MAX };
+    double max[3] = { -DBL_MAX, -DBL_MAX, -DBL_MAX };
+    for(int i=0; i<n; ++i)
+    for(int j=0; j<3; ++j)
+    {
+        min[j] = std::min(min[j], xyz[3*i+j]);
+        max[j] = std::max(max[j], xyz[3*i+j]);
+    }
+
+    double cell = eps;
+    for(int j=0; j<3; ++j) cell = std::max(cell, (max[j] - min[j]) / (MAX_CELLS - 1));
+    if (cell == 0) cell = 1.0;
+
+    // cell of each point, and whether it is within EPS from the neighbor
+    // cells (bit 2j: lower neighbor along axis j, bit 2j+1: upper neighbor)
+    //
+    std::vector<uint64_t> key(n);
+    std::vector<uint8_t>  near(n);
+
+    parallel_for(0, n, [&](const int i)
+    {
+        uint64_t k = 0;
+        uint8_t  b = 0;
+        for(int j=0; j<3; ++j)
+        {
+            double  x = (xyz[3*i+j] - min[j]) / cell;
+            int64_t c = std::min(MAX_CELLS - 1, (int64_t)x);
+            k |= uint64_t(c) << (21*j);
+            if (eps > 0)
+            {
+                if ((x - c) * cell <= eps)     b |= 1 << (2*j);
+                if ((c + 1 - x) * cell <= eps) b |= 1 << (2*j+1);
+            }
+        }
+        key[i]  = k;
+        near[i] = b;
+    });
+
+    // kept points, as linked lists (one per cell). Heads are in an open
+    // addressing hash table (linear probing), which doubles as soon as it
+    // is 2/3 full
+    //
+    const uint64_t EMPTY = ~uint64_t(0);
+
+    int    shift = 60;
+    size_t cap   = 16;
+    size_t used  = 0;
+
+    std::vector<uint64_t> slot_key(cap, EMPTY);
+    std::vector<int>      slot_head(cap);
+    std::vector<int>      next;
+
+    auto slot = [&](const uint64_t k) -> size_t
+    {
+        size_t h = size_t((k * UINT64_C(0x9E3779B97F4A7C15)) >> shift);
+        while (slot_key[h] != EMPTY && slot_key[h] != k) h = (h + 1) & (cap - 1);
+        return h;
+    };
+
+    auto grow = [&]()
+    {
+        std::vector<uint64_t> old_key;
+        std::vector<int>      old_head;
+        old_key.swap(slot_key);
+        old_head.swap(slot_head);
+
+        cap <<= 1;
+        --shift;
+        slot_key.assign(cap, EMPTY);
+        slot_head.resize(cap);
+
+        for(size_t h=0; h<old_key.size(); ++h) if (old_key[h] != EMPTY)
+        {
+            size_t h_new = slot(old_key[h]);
+            slot_key[h_new]  = old_key[h];
+            slot_head[h_new] = old_head[h];
+        }
+    };
+
+    double eps2 = eps * eps;
+
+    for(int i=0; i<n; ++i)
+    {
+        const double * p = &xyz[3*i];
+        int match = -1;
+
+        int r = (near[i] != 0) ? 1 : 0; // otherwise, only its own cell
+
+        for(int dz=-r; dz<=r && match<0; ++dz)
+        for(int dy=-r; dy<=r && match<0; ++dy)
+        for(int dx=-r; dx<=r && match<0; ++dx)
+        {
+            int d[3] = { dx, dy, dz };
+            bool skip = false;
+            uint64_t k = key[i];
+            for(int j=0; j<3 && !skip; ++j)
+            {
+                if (d[j] == 0) continue;
+                int64_t c = (key[i] >> (21*j)) & MAX_CELLS;
+                skip = !(near[i] & (1 << (2*j + (d[j] > 0)))) || c + d[j] < 0 || c + d[j] >= MAX_CELLS;
+                k = (k & ~(uint64_t(MAX_CELLS) << (21*j))) | (uint64_t(c + d[j]) << (21*j));
+            }
+            if (skip) continue;
+
+            size_t h = slot(k);
+            if (slot_key[h] == EMPTY) continue;
+
+            for(int w=slot_head[h]; w>=0; w=next[w])
+            {
+                const double * q = &welded[3*w];
+                double dist2 = (p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2]);
+                if (dist2 <= eps2)
+                {
+                    match = w;
+                    break;
+                }
+            }
+        }
+
+        if (match < 0)
+        {
+            match = welded.size() / 3;
+            welded.push_back(p[0]);
+            welded.push_back(p[1]);
+            welded.push_back(p[2]);
+
+            size_t h = slot(key[i]);
+            if (slot_key[h] == EMPTY)
+            {
+                next.push_back(-1);
+                slot_key[h] = key[i];
+                if (3 * ++used > 2 * cap)
+                {
+                    grow();
+                    h = slot(key[i]);
+                }
+            }
+            else next.push_back(slot_head[h]);
+            slot_head[h] = match;
+        }
+        map[i] = match;
+    }
+}
+
+}
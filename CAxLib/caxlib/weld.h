@@ -0,0 +1,33 @@
+#ifndef WELD_H
+#define WELD_H
+
+#include "caxlib.h"
+
+#include <sys/types.h>
+#include <vector>
+
+namespace caxlib
+{
+
+// Weld a set of points (serialized xyz coordinates): points are visited in
+// input order, and each one is either merged into a kept point not farther
+// than EPS, or kept. map[i] is the position of point i in welded (which keeps
+// the input order). EPS = 0 merges the exact duplicates only.
+//
+// Kept points are hashed in a uniform grid with cells not smaller than EPS,
+// and a point is compared only against the cells within EPS from it (mostly
+// its own cell), so the expected time is O(n).
+//
+CAX_INLINE
+void weld_points(const std::vector<double> & xyz,
+                 const double                eps,
+                 std::vector<double>       & welded,
+                 std::vector<u_int>        & map);
+
+}
+
+#ifndef  CAX_STATIC_LIB
+#include "weld.cpp"
+#endif
+
+#endif // WELD_H
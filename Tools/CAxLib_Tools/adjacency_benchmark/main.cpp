@@ -0,0 +1,171 @@
+#include <caxlib/trimesh/trimesh.h>
+
+#include <chrono>
+#include <iostream>
+#include <map>
+
+// Reference adjacency builder, based on std::map. This is the algorithm
+// Trimesh::update_adjacency() used before switching to sorted half edges,
+// and it is kept here only to measure the speedup and to check that both
+// produce exactly the same relations.
+//
+struct MapAdjacency
+{
+    std::vector<u_int> edges;
+    std::vector< std::vector<int> > vtx2vtx;
+    std::vector< std::vector<int> > vtx2edg;
+    std::vector< std::vector<int> > vtx2tri;
+    std::vector< std::vector<int> > edg2tri;
+    std::vector< std::vector<int> > tri2edg;
+    std::vector< std::vector<int> > tri2tri;
+};
+
+void map_adjacency(const std::vector<u_int> & tris, const int nv, MapAdjacency & adj)
+{
+    int nt = tris.size() / 3;
+
+    adj.vtx2tri.resize(nv);
+
+    typedef std::map<caxlib::ipair, std::vector<int> > mymap;
+    mymap edge_tri_map;
+
+    for(int tid=0; tid<nt; ++tid)
+    {
+        for(int i=0; i<3; ++i)
+        {
+            int vid0 = tris[tid*3 + i];
+            int vid1 = tris[tid*3 + (i+1)%3];
+            adj.vtx2tri[vid0].push_back(tid);
+            edge_tri_map[caxlib::unique_pair(vid0, vid1)].push_back(tid);
+        }
+    }
+
+    adj.edg2tri.resize(edge_tri_map.size());
+    adj.tri2edg.resize(nt);
+    adj.tri2tri.resize(nt);
+    adj.vtx2vtx.resize(nv);
+    adj.vtx2edg.resize(nv);
+
+    int fresh_id = 0;
+    for(mymap::iterator it=edge_tri_map.begin(); it!=edge_tri_map.end(); ++it)
+    {
+        int eid  = fresh_id++;
+        int vid0 = it->first.first;
+        int vid1 = it->first.second;
+
+        adj.edges.push_back(vid0);
+        adj.edges.push_back(vid1);
+        adj.vtx2vtx[vid0].push_back(vid1);
+        adj.vtx2vtx[vid1].push_back(vid0);
+        adj.vtx2edg[vid0].push_back(eid);
+        adj.vtx2edg[vid1].push_back(eid);
+
+        const std::vector<int> & tids = it->second;
+        for(int tid : tids)
+        {
+            adj.tri2edg[tid].push_back(eid);
+            adj.edg2tri[eid].push_back(tid);
+        }
+        if (tids.size() == 2)
+        {
+            adj.tri2tri[tids[0]].push_back(tids[1]);
+            adj.tri2tri[tids[1]].push_back(tids[0]);
+        }
+    }
+}
+
+bool same_relation(const std::vector< std::vector<int> > & ref, const std::vector< std::vector<int> > & res, const char * name)
+{
+    if (ref == res) return true;
+    std::cerr << "MISMATCH in " << name << std::endl;
+    return false;
+}
+
+size_t footprint(const std::vector< std::vector<int> > & rel)
+{
+    size_t bytes = rel.capacity() * sizeof(std::vector<int>);
+    for(const std::vector<int> & row : rel) bytes += row.capacity() * sizeof(int);
+    return bytes;
+}
+
+double seconds_since(const std::chrono::steady_clock::time_point & t)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        caxlib::logger << "Compare the adjacency builder of caxlib::Trimesh against the std::map based one it replaced." << caxlib::endl;
+        caxlib::logger << "Usage: ./adjacency_benchmark input.[off|obj|zip] [n_runs]" << caxlib::endl;
+        return 0;
+    }
+
+    int n_runs = (argc > 2) ? atoi(argv[2]) : 3;
+
+    caxlib::Trimesh m(argv[1]);
+
+    caxlib::logger.disable();
+
+    double t_sort = FLT_MAX;
+    double t_map  = FLT_MAX;
+
+    MapAdjacency ref;
+
+    for(int run=0; run<n_runs; ++run)
+    {
+        std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+        m.update_adjacency();
+        t_sort = std::min(t_sort, seconds_since(t));
+
+        ref = MapAdjacency();
+        t = std::chrono::steady_clock::now();
+        map_adjacency(m.vector_triangles(), m.num_vertices(), ref);
+        t_map = std::min(t_map, seconds_since(t));
+    }
+
+    caxlib::logger.enable();
+
+    std::vector< std::vector<int> > vtx2vtx, vtx2edg, vtx2tri, edg2tri, tri2edg, tri2tri;
+    for(int vid=0; vid<m.num_vertices(); ++vid)
+    {
+        vtx2vtx.push_back(m.adj_vtx2vtx(vid));
+        vtx2edg.push_back(m.adj_vtx2edg(vid));
+        vtx2tri.push_back(m.adj_vtx2tri(vid));
+    }
+    for(int eid=0; eid<m.num_edges(); ++eid)
+    {
+        edg2tri.push_back(m.adj_edg2tri(eid));
+    }
+    for(int tid=0; tid<m.num_triangles(); ++tid)
+    {
+        tri2edg.push_back(m.adj_tri2edg(tid));
+        tri2tri.push_back(m.adj_tri2tri(tid));
+    }
+
+    bool ok = (ref.edges == m.vector_edges());
+    if (!ok) std::cerr << "MISMATCH in edges" << std::endl;
+    ok &= same_relation(ref.vtx2vtx, vtx2vtx, "vtx2vtx");
+    ok &= same_relation(ref.vtx2edg, vtx2edg, "vtx2edg");
+    ok &= same_relation(ref.vtx2tri, vtx2tri, "vtx2tri");
+    ok &= same_relation(ref.edg2tri, edg2tri, "edg2tri");
+    ok &= same_relation(ref.tri2edg, tri2edg, "tri2edg");
+    ok &= same_relation(ref.tri2tri, tri2tri, "tri2tri");
+
+    caxlib::logger << m.num_triangles() << " triangles, " << m.num_edges() << " edges (best of " << n_runs << " runs)" << caxlib::endl;
+    caxlib::logger << "std::map adjacency     : " << t_map  << " secs" << caxlib::endl;
+    caxlib::logger << "sorted half edges      : " << t_sort << " secs" << caxlib::endl;
+    caxlib::logger << "speedup                : " << t_map / t_sort << "x" << caxlib::endl;
+    caxlib::logger << "identical relations    : " << (ok ? "yes" : "NO") << caxlib::endl;
+
+    size_t nested = footprint(ref.vtx2vtx) + footprint(ref.vtx2edg) + footprint(ref.vtx2tri) +
+                    footprint(ref.edg2tri) + footprint(ref.tri2edg) + footprint(ref.tri2tri);
+
+    caxlib::logger << caxlib::endl;
+    caxlib::logger << "relations as nested std::vectors: " << double(nested) / (1024.0 * 1024.0) << " MB (heap blocks only, allocator overhead excluded)" << caxlib::endl;
+    caxlib::logger << "memory footprint of caxlib::Trimesh:" << caxlib::endl;
+    m.print_memory_footprint();
+
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,23 @@
+#include <caxlib/trimesh/trimesh.h>
+
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        caxlib::logger << "Convert a part between the ZIP (OFF + ANN) and the binary CAX container, in both directions." << caxlib::endl;
+        caxlib::logger << "Any other format supported by Trimesh::load() and Trimesh::save() works as well (annotations are" << caxlib::endl;
+        caxlib::logger << "kept only by ZIP, ANN and CAX)." << caxlib::endl;
+        caxlib::logger << "" << caxlib::endl;
+        caxlib::logger << "Usage: ./cax_converter input.zip output.cax" << caxlib::endl;
+        caxlib::logger << "       ./cax_converter input.cax output.zip" << caxlib::endl;
+        return 0;
+    }
+
+    caxlib::Trimesh m(argv[1], true); // lazy: no relation is needed
+
+    m.save(argv[2]);
+
+    return 0;
+}
@@ -13,7 +13,7 @@ int main(int argc, char *argv[])
         return 0;
     }
 
-    caxlib::Trimesh m(argv[1]);
+    caxlib::Trimesh m(argv[1], true); // lazy: relations are built only if needed
 
     bool has_voids = caxlib::detect_voids(m); //, angle_thresh, dirs_pool_size);
 
@@ -3,4 +3,4 @@
 CAXLIB_INCLUDE_DIR=/Users/cino/Documents/research/devel/lib/CAxLib
 LIBZIP_INCLUDE_DIR=/usr/local/Cellar/libzip/0.11.2/lib/libzip/include
 
-g++ -I $CAXLIB_INCLUDE_DIR -I $LIBZIP_INCLUDE_DIR -Wno-c++11-extensions -ltinyxml2 -lzip -llz -o checks_service main.cpp
\ No newline at end of file
+g++ -pthread -I $CAXLIB_INCLUDE_DIR -I $LIBZIP_INCLUDE_DIR -Wno-c++11-extensions -ltinyxml2 -lzip -llz -o checks_service main.cpp
\ No newline at end of file
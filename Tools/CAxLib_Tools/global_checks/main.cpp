@@ -11,7 +11,7 @@ int main(int argc, char *argv[])
         return 0;
     }
 
-    caxlib::Trimesh m(argv[1]);
+    caxlib::Trimesh m(argv[1], true); // lazy: relations are built only if needed
     caxlib::check_material(m);
     caxlib::check_size(m);
     caxlib::check_weight(m);
@@ -1,10 +1,227 @@
 #include <caxlib/process_plan/orient.h>
 #include <caxlib/trimesh/trimesh.h>
+#include <caxlib/parallel.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <dirent.h>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sys/stat.h>
+#include <thread>
+
+typedef struct
+{
+    std::string in;
+    std::string out;
+    bool        ok;
+    std::string status;
+    int         n_tris;
+    double      t_load;
+    double      t_orient;
+    double      t_save;
+}
+Part;
+
+// input parts: the zip files in a directory, or the lines of a manifest file
+// (one path per line, empty lines and lines starting with # are skipped).
+// Outputs go in OUT_DIR with the file name of their input, prefixed with the
+// position of the part in the list when two inputs have the same file name
+//
+bool list_parts(const std::string & input, const std::string & out_dir, std::vector<Part> & parts)
+{
+    std::vector<std::string> files;
+
+    struct stat st;
+    if (stat(input.c_str(), &st) != 0) return false;
+
+    if (S_ISDIR(st.st_mode))
+    {
+        DIR * dir = opendir(input.c_str());
+        if (dir == NULL) return false;
+        while (struct dirent * e = readdir(dir))
+        {
+            std::string name = e->d_name;
+            if (name.size() > 4 && (name.substr(name.size()-4) == ".zip" || name.substr(name.size()-4) == ".ZIP"))
+            {
+                files.push_back(input + "/" + name);
+            }
+        }
+        closedir(dir);
+        std::sort(files.begin(), files.end());
+    }
+    else
+    {
+        std::ifstream f(input.c_str());
+        std::string line;
+        while (std::getline(f, line))
+        {
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (!line.empty() && line[0] != '#') files.push_back(line);
+        }
+    }
+
+    std::map<std::string,int> n_same_name;
+    for(const std::string & file : files) ++n_same_name[file.substr(file.find_last_of('/') + 1)];
+
+    std::set<std::string> out_names;
+    for(size_t i=0; i<files.size(); ++i)
+    {
+        const std::string & file = files[i];
+
+        std::string name = file.substr(file.find_last_of('/') + 1);
+        if (n_same_name[name] > 1) name = std::to_string(i) + "_" + name;
+
+        if (!out_names.insert(name).second)
+        {
+            std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : list_parts() : two parts would be saved as " << name << std::endl;
+            return false;
+        }
+
+        Part p;
+        p.in       = file;
+        p.out      = out_dir + "/" + name;
+        p.ok       = false;
+        p.status   = "not processed";
+        p.n_tris   = 0;
+        p.t_load   = 0.0;
+        p.t_orient = 0.0;
+        p.t_save   = 0.0;
+        parts.push_back(p);
+    }
+    return true;
+}
+
+// Orient all the parts listed in argv[2] with a pool of workers (one part at a
+// time each), and print a single summary with per part timings. Parts are
+// loaded and saved one at a time: readers and writers set the (process wide)
+// numeric locale
+//
+int batch(int argc, char *argv[])
+{
+    double wgt_srf_quality = atof(argv[3]);
+    double wgt_print_time  = atof(argv[4]);
+    double wgt_supports    = atof(argv[5]);
+    std::string out_dir    = argv[6];
+    int    n_workers       = (argc > 7) ? atoi(argv[7]) : caxlib::num_threads();
+
+    double angle_thresh   = 30.0;
+    int    dirs_pool_size = 100;
+    int    seed           = 0;
+
+    std::vector<Part> parts;
+    if (!list_parts(argv[2], out_dir, parts))
+    {
+        std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : batch() : couldn't read " << argv[2] << caxlib::endl;
+        return -1;
+    }
+    mkdir(out_dir.c_str(), 0755);
+
+    n_workers = std::max(1, std::min(n_workers, (int)parts.size()));
+
+    caxlib::logger << parts.size() << " parts, " << n_workers << " workers" << caxlib::endl;
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point t_batch = clock::now();
+
+    std::atomic<int> next(0);
+    std::mutex       io_mutex;
+
+    std::vector<std::thread> workers;
+    for(int w=0; w<n_workers; ++w)
+    {
+        workers.push_back(std::thread([&]()
+        {
+            // each part is a job of its own: no nested threads, no logs, and
+            // a part that cannot be read fails alone (see read_errors_throw())
+            //
+            caxlib::is_worker_thread() = (n_workers > 1);
+            caxlib::read_errors_throw() = true;
+            caxlib::logger.disable();
+
+            for(int i=next++; i<(int)parts.size(); i=next++)
+            {
+                Part & p = parts[i];
+
+                clock::time_point t0 = clock::now();
+                std::unique_lock<std::mutex> lock(io_mutex);
+                std::unique_ptr<caxlib::Trimesh> mesh;
+                try
+                {
+                    mesh.reset(new caxlib::Trimesh(p.in.c_str(), true));
+                }
+                catch (const std::exception &)
+                {
+                }
+                lock.unlock();
+
+                clock::time_point t1 = clock::now();
+                p.t_load = std::chrono::duration<double>(t1 - t0).count();
+
+                // unreadable parts, and parts with no triangles, have nothing
+                // to orient nor to save
+                //
+                if (mesh == nullptr || mesh->num_triangles() == 0)
+                {
+                    p.ok     = false;
+                    p.status = (mesh == nullptr) ? "unreadable" : "empty mesh";
+                    continue;
+                }
+                caxlib::Trimesh & m = *mesh;
+
+                p.ok     = caxlib::orient(m, wgt_srf_quality, wgt_print_time, wgt_supports, angle_thresh, dirs_pool_size, NULL, seed);
+                p.status = p.ok ? "ok" : "no legal orientation";
+
+                clock::time_point t2 = clock::now();
+                lock.lock();
+                m.save(p.out.c_str());
+                lock.unlock();
+
+                clock::time_point t3 = clock::now();
+                p.n_tris   = m.num_triangles();
+                p.t_orient = std::chrono::duration<double>(t2 - t1).count();
+                p.t_save   = std::chrono::duration<double>(t3 - t2).count();
+            }
+        }));
+    }
+    for(std::thread & t : workers) t.join();
+
+    double t_tot  = std::chrono::duration<double>(clock::now() - t_batch).count();
+    double t_load = 0.0, t_orient = 0.0, t_save = 0.0;
+    int    n_ok   = 0;
+
+    caxlib::logger << caxlib::newl << "part\ttriangles\tload\torient\tsave\tstatus" << caxlib::newl;
+    for(const Part & p : parts)
+    {
+        caxlib::logger << p.in << "\t" << p.n_tris << "\t" << p.t_load << "\t" << p.t_orient << "\t" << p.t_save << "\t"
+                       << p.status << caxlib::newl;
+        t_load   += p.t_load;
+        t_orient += p.t_orient;
+        t_save   += p.t_save;
+        if (p.ok) ++n_ok;
+    }
+    caxlib::logger << caxlib::newl;
+    caxlib::logger << n_ok << " of " << parts.size() << " parts oriented in " << t_tot << " secs" << caxlib::newl;
+    caxlib::logger << "load " << t_load << " secs, orient " << t_orient << " secs, save " << t_save << " secs (summed over parts)" << caxlib::endl;
+
+    if (n_ok == (int)parts.size())
+        return 0;
+
+    return -1;
+}
 
 int main(int argc, char *argv[])
 {
+    if (argc >= 7 && argc <= 8 && std::string(argv[1]) == "--batch")
+    {
+        return batch(argc, argv);
+    }
+
     if (argc != 6)
     {
         caxlib::logger << "Choose the best orientation according to three metrics (or any combination of them)." << caxlib::endl;
@@ -18,6 +235,11 @@ int main(int argc, char *argv[])
         caxlib::logger << "This function minimizes a functional defined as the weighted sum of these three components. Weigths must" << caxlib::endl;
         caxlib::logger << "sum up to 1." << caxlib::endl;
         caxlib::logger << "Usage: ./orientation_service input.zip wgt_srf_quality wgt_print_time wgt_supports output.zip" << caxlib::endl;
+        caxlib::logger << "       ./orientation_service --batch input_dir|manifest.txt wgt_srf_quality wgt_print_time wgt_supports output_dir [n_workers]" << caxlib::endl;
+        caxlib::logger << "" << caxlib::endl;
+        caxlib::logger << "In batch mode all the zip files in input_dir (or listed in manifest.txt, one per line) are oriented" << caxlib::endl;
+        caxlib::logger << "by a pool of n_workers (default: one per core) in a single process, and saved in output_dir." << caxlib::endl;
+        caxlib::logger << "Parts with the same file name are saved as <position in the list>_<file name>." << caxlib::endl;
         return 0;
     }
 
@@ -33,7 +255,7 @@ int main(int argc, char *argv[])
 
     m.save(argv[5]);
 
-    if (ok) 
+    if (ok)
         return 0;
 
     return -1;
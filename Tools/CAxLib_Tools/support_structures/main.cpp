@@ -5,16 +5,16 @@
 
 int main(int argc, char *argv[])
 {
-    if (argc != 5)
+    if (argc != 5 && argc != 6)
     {
-        caxlib::logger << "Usage: ./supports_service input.zip support_thickness output.zip supports_data.txt" << caxlib::endl;
+        caxlib::logger << "Usage: ./supports_service input.zip support_thickness output.zip supports_data.txt [grid_pitch]" << caxlib::endl;
         return 0;
     }
 
     std::vector<caxlib::VertexCumulativeSupportData> per_vertex_supports_data;
 
     caxlib::Trimesh m(argv[1]);
-    caxlib::create_support_structures(m, atof(argv[2]), per_vertex_supports_data);
+    caxlib::create_support_structures(m, atof(argv[2]), per_vertex_supports_data, (argc == 6) ? atof(argv[5]) : 0.0);
 
     m.save(argv[3]);
 
@@ -140,7 +140,7 @@ void EpsTrimesh::set_epsilon_triangle_label()
 DANI_INLINE
 int EpsTrimesh::edge_local_to_global(const uint v0, const uint v1) const
 {
-    for (uint edg : vtx2edg.at(v0))
+    for (uint edg : adj_vtx2edg(v0))
         if (edge_contains_vertex(edg, v1))
             return edg;
 
@@ -156,7 +156,7 @@ int EpsTrimesh::edge_local_to_global(const uint v0, const uint v1) const
 DANI_INLINE
 uint EpsTrimesh::triangle_local_to_global(const uint v0, const uint v1, const uint v2) const
 {
-    for (uint tid : vtx2tri.at(v0))
+    for (uint tid : adj_vtx2tri(v0))
         if (triangle_contains_vertex(tid, v1) && triangle_contains_vertex(tid, v2))
             return tid;
 
@@ -170,6 +170,14 @@ int EpsTrimesh::add_triangle(const int vid0, const int vid1, const int vid2, con
     assert(vid1 >= 0 && vid1 < num_vertices());
     assert(vid2 >= 0 && vid2 < num_vertices());
 
+#ifdef CAXLIB
+
+    // caxlib patches relations and normals on its own, in O(valence)
+    //
+    return Trimesh::add_triangle(vid0, vid1, vid2, scalar);
+
+#else
+
     int tid = num_triangles();
     //
     tris.push_back(vid0);
@@ -187,10 +195,15 @@ int EpsTrimesh::add_triangle(const int vid0, const int vid1, const int vid2, con
     //
     ipair new_e[3]   = { unique_pair(vid0, vid1), unique_pair(vid1, vid2), unique_pair(vid2, vid0) };
     int   new_eid[3] = { -1, -1, -1 };
-    for(int eid=0; eid<num_edges(); ++eid)
+    for(int i=0; i<3; ++i)
     {
-        ipair e = unique_pair(edge_vertex_id(eid, 0), edge_vertex_id(eid, 1));
-        for(int i=0; i<3; ++i) if (e == new_e[i]) new_eid[i] = eid;
+        // look the edge up among the edges of its first vertex only
+        //
+        for(int eid : vtx2edg.at(new_e[i].first))
+        {
+            ipair e = unique_pair(edge_vertex_id(eid, 0), edge_vertex_id(eid, 1));
+            if (e == new_e[i]) new_eid[i] = eid;
+        }
     }
     //
     for(int i=0; i<3; ++i)
@@ -236,6 +249,8 @@ int EpsTrimesh::add_triangle(const int vid0, const int vid1, const int vid2, con
 #endif
 
     return tid;
+
+#endif
 }
 
 DANI_INLINE
@@ -299,8 +314,21 @@ uint EpsTrimesh::split_edge(const uint eid, const vec3d point, std::vector<doubl
     return vid;
 #else
 
-    std::cerr << "[ERROR] Cinolib required to run this operation." << std::endl;
-    exit(1);
+    // caxlib splits the edge in place: the triangles of eid keep their ids,
+    // and one new triangle per each of them is appended, in the same order
+    //
+    std::vector<int> tids = adj_edg2tri(eid);
+
+    uint vid = Trimesh::split_edge(eid, point);
+
+    for (int tt : tids)
+    {
+        radius.push_back(radius.at(tt));
+        centers.push_back(centers.at(tt));
+        antipodeans.push_back(antipodeans.at(tt));
+    }
+
+    return vid;
 
 #endif
 }
@@ -391,8 +419,20 @@ uint EpsTrimesh::split_triangle(const uint tid, const vec3d point, std::vector<d
 
 #else
 
-    std::cerr << "[ERROR] Cinolib required to run this operation." << std::endl;
-    exit(1);
+    // caxlib splits the triangle in place: tid keeps its id, the other two
+    // pieces are appended
+    //
+    uint vid = Trimesh::split_triangle(tid, point);
+
+    radius.at(tid) = FLT_MAX;
+    centers.at(tid) = {FLT_MAX};
+    antipodeans.at(tid) = {FLT_MAX};
+
+    radius.resize(num_triangles(), FLT_MAX);
+    centers.resize(num_triangles(), vec3d(FLT_MAX));
+    antipodeans.resize(num_triangles(), vec3d(FLT_MAX));
+
+    return vid;
 
 #endif
 }